@@ -15,6 +15,8 @@
 #endif
 
 #define CALCULATE_EXECUTION_TIME 0
+#define REPORT_CELL_ALLOCATIONS 0
+#define REPORT_LOOKUP_CACHE 0
 
 #if CALCULATE_EXECUTION_TIME
 #include <chrono>
@@ -46,6 +48,12 @@ public:
 
   std::filesystem::path get_config_file_path() { return config_file_path_; }
 
+  void set_snapshot_path(std::filesystem::path path) { snapshot_path_ = path; }
+
+  std::optional<std::filesystem::path> get_snapshot_path() const {
+    return snapshot_path_;
+  }
+
   std::optional<std::string> get_repl_prelude() const {
     if (!use_std_) {
       return std::nullopt;
@@ -84,6 +92,7 @@ private:
   bool use_std_{true};
 
   std::filesystem::path config_file_path_;
+  std::optional<std::filesystem::path> snapshot_path_{std::nullopt};
 };
 
 std::unique_ptr<program_data_controller_c> pdc{nullptr};
@@ -97,17 +106,34 @@ void error_callback_function(nibi::error_c error) {
 }
 
 void run_from_file(std::filesystem::path file_name) {
-  auto file_interpreter =
-      interpreter_factory_c::file_interpreter(error_callback_function);
+  {
+    auto file_interpreter =
+        interpreter_factory_c::file_interpreter(error_callback_function);
+
+    // Bring in the standard library if enabled, from a snapshot of
+    // what it left behind the last time if one was asked for
+    if (pdc->use_std()) {
+      auto config_file = pdc->get_config_file_path();
+      auto snapshot = pdc->get_snapshot_path();
+      if (!snapshot.has_value() ||
+          !file_interpreter->restore_snapshot(*snapshot, config_file)) {
+        file_interpreter->interpret_file(config_file);
+        file_interpreter->indicate_complete();
+        if (snapshot.has_value() &&
+            !file_interpreter->save_snapshot(*snapshot, config_file)) {
+          std::cout << "Warning: Could not save snapshot to " << *snapshot
+                    << std::endl;
+        }
+      }
+    }
 
-  // Bring in the standard library if enabled
-  if (pdc->use_std()) {
-    file_interpreter->interpret_file(pdc->get_config_file_path());
+    file_interpreter->interpret_file(file_name);
     file_interpreter->indicate_complete();
   }
 
-  file_interpreter->interpret_file(file_name);
-  file_interpreter->indicate_complete();
+  // The cells of the script went with its interpreter, so
+  // the pooled memory that held them can be given back at once
+  cell_memory_release_unused();
 }
 
 void run_from_dir(const std::string &file_name) {
@@ -120,7 +146,8 @@ void run_from_dir(const std::string &file_name) {
 }
 
 void show_help() {
-  std::cout << "Usage: nibi [options] [file | directory]\n" << std::endl;
+  std::cout << "Usage: nibi [options] [file | directory] [arguments]\n"
+            << std::endl;
   std::cout << "Options:" << std::endl;
   std::cout << "  -h, --help            Show this help message" << std::endl;
   std::cout << "  -v, --version         Show version info" << std::endl;
@@ -130,6 +157,10 @@ void show_help() {
             << std::endl;
   std::cout << "  -i, --include <dirs>  Add include directory (`:` delimited)"
             << std::endl;
+  std::cout << "  -s, --snapshot <file> Start from a snapshot of the standard "
+               "symbols,\n"
+               "                        saving one if it is missing or stale"
+            << std::endl;
 }
 
 void show_version() {
@@ -277,13 +308,16 @@ int main(int argc, char **argv) {
   auto app_start = std::chrono::high_resolution_clock::now();
 #endif
   std::vector<std::filesystem::path> include_dirs;
-  std::vector<std::string> args =
-      std::vector<std::string>(argv + 1, argv + argc);
+
+  // Only the launch target and the arguments after it are handed to
+  // the program, the options before it are for nibi
+  std::vector<std::string> program_args;
 
   bool use_std{true};
   std::string launch_target;
   {
-    pdc = std::make_unique<program_data_controller_c>(args, include_dirs);
+    pdc = std::make_unique<program_data_controller_c>(program_args,
+                                                      include_dirs);
 
     std::vector<std::string> args =
         std::vector<std::string>(argv + 1, argv + argc);
@@ -323,6 +357,16 @@ int main(int argc, char **argv) {
         return 0;
       }
 
+      if (args[i] == "-s" || args[i] == "--snapshot") {
+        if (i + 1 >= args.size()) {
+          std::cout << "Error: Expected value for [-s | --snapshot]"
+                    << std::endl;
+          return 1;
+        }
+        pdc->set_snapshot_path(args[++i]);
+        continue;
+      }
+
       if (args[i] == "-i" || args[i] == "--include") {
         if (i + 1 >= args.size()) {
           std::cout << "Error: Expected value for [-i | --include]"
@@ -337,13 +381,11 @@ int main(int argc, char **argv) {
         continue;
       }
 
-      // Launch target already set, now we assume
-      // that the rest will be arguments to the program
-      if (!launch_target.empty()) {
-        continue;
-      }
-
+      // The rest are arguments to the program, even those
+      // that look like options
       launch_target = args[i];
+      program_args.assign(args.begin() + i, args.end());
+      break;
     }
   }
 
@@ -402,5 +444,20 @@ int main(int argc, char **argv) {
       std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
   std::cout << "Execution time: " << duration.count() << "ms" << std::endl;
 #endif
+
+#if REPORT_CELL_ALLOCATIONS
+  auto stats = get_cell_allocation_stats();
+  std::cout << "Cell allocations: " << stats.allocations
+            << ", deallocations: " << stats.deallocations
+            << ", peak bytes: " << stats.peak_bytes
+            << ", slabs allocated: " << stats.slabs_allocated
+            << ", slabs released: " << stats.slabs_released << std::endl;
+#endif
+
+#if REPORT_LOOKUP_CACHE
+  auto lookups = get_lookup_cache_stats();
+  std::cout << "Lookup cache hits: " << lookups.hits
+            << ", misses: " << lookups.misses << std::endl;
+#endif
   return 0;
 }
@@ -71,12 +71,23 @@ void start_repl(repl_config_s config) {
       {"(th", {"(throw "}},      {"(tr", {"(try "}},
       {"(en", {"(env "}},        {"(dr", {"("}},
       {"(lo", {"(loop "}},       {"(it", {"(iter \""}},
+      {"(pi", {"(piter "}},      {"(pm", {"(pmap "}},
       {"(im", {"(import \""}},   {"(imp", {"(import \""}},
       {"(impo", {"(import \""}}, {"(impor", {"(import \""}},
       {"(d", {"(drop "}},        {"(dr", {"(drop "}},
       {"(dro", {"(drop "}},      {"(s", {"(set "}},
       {"(se", {"(set "}},        {"(as", {"(assert "}},
       {"(cl", {"(clone "}},      {"(c", {"(clone "}},
+      {"(ve", {"(vec-"}},        {"(vec-a", {"(vec-add "}},
+      {"(vec-mu", {"(vec-mul "}}, {"(vec-sc", {"(vec-scale "}},
+      {"(vec-di", {"(vec-div "}}, {"(vec-do", {"(vec-dot "}},
+      {"(vec-mi", {"(vec-min "}}, {"(vec-ma", {"(vec-max "}},
+      {"(ta", {"(task"}},         {"(task-", {"(task-join "}},
+      {"(ch", {"(chan"}},         {"(chan-s", {"(chan-send "}},
+      {"(chan-r", {"(chan-recv "}}, {"(chan-c", {"(chan-close "}},
+      {"(ge", {"(gen"}},          {"(gen-n", {"(gen-next "}},
+      {"(gen-t", {"(gen-take "}}, {"(gen-m", {"(gen-map "}},
+      {"(gen-f", {"(gen-filter "}}, {"(em", {"(emit "}},
   };
 
   linenoise::SetCompletionCallback(
@@ -21,6 +21,10 @@ endif()
 # Target
 add_library(${LIBRARY_NAME} ${LIBRARY_TYPE} ${SOURCES} ${HEADERS})
 
+# Parallel builtins run on a pool of threads
+find_package(Threads REQUIRED)
+target_link_libraries(${LIBRARY_NAME} PUBLIC Threads::Threads)
+
 # Install library
 install(TARGETS ${LIBRARY_NAME}
   EXPORT ${PROJECT_EXPORT}
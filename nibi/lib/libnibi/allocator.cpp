@@ -0,0 +1,172 @@
+#include "libnibi/allocator.hpp"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace nibi {
+
+namespace {
+
+// Blocks are handed out in multiples of this size so every
+// block is aligned for any type that a cell may contain
+static constexpr std::size_t BLOCK_GRANULARITY = 16;
+
+// Anything larger than this is forwarded to the global allocator
+static constexpr std::size_t MAX_POOLED_BLOCK_SIZE = 256;
+
+// The size of each slab that blocks are carved out of
+static constexpr std::size_t SLAB_SIZE = 64 * 1024;
+
+//! \brief A free list of fixed size blocks carved out of larger slabs
+class block_pool_c {
+public:
+  block_pool_c(const std::size_t block_size)
+      : block_size_(block_size), blocks_per_slab_(SLAB_SIZE / block_size) {}
+
+  ~block_pool_c() {
+    // If cells are still alive (exit during execution, etc) the slabs
+    // are left for the system to reclaim rather than leaving dangling cells
+    if (live_blocks_ == 0) {
+      release_slabs();
+    }
+  }
+
+  inline void *allocate(cell_allocation_stats_s &stats) {
+    if (!free_list_) {
+      grow(stats);
+    }
+    auto *block = free_list_;
+    free_list_ = block->next;
+    live_blocks_++;
+    return block;
+  }
+
+  inline void deallocate(void *block) {
+    auto *freed = static_cast<free_block_s *>(block);
+    freed->next = free_list_;
+    free_list_ = freed;
+    live_blocks_--;
+  }
+
+  std::size_t release_if_unused() {
+    if (live_blocks_ != 0) {
+      return 0;
+    }
+    return release_slabs();
+  }
+
+private:
+  struct free_block_s {
+    free_block_s *next;
+  };
+
+  void grow(cell_allocation_stats_s &stats) {
+    auto *slab = static_cast<char *>(::operator new(SLAB_SIZE));
+    slabs_.push_back(slab);
+    stats.slabs_allocated++;
+
+    // Thread the new blocks onto the free list in address order
+    for (std::size_t i = blocks_per_slab_; i > 0; i--) {
+      auto *block =
+          reinterpret_cast<free_block_s *>(slab + (i - 1) * block_size_);
+      block->next = free_list_;
+      free_list_ = block;
+    }
+  }
+
+  std::size_t release_slabs() {
+    auto released = slabs_.size();
+    for (auto *slab : slabs_) {
+      ::operator delete(slab);
+    }
+    slabs_.clear();
+    free_list_ = nullptr;
+    return released;
+  }
+
+  std::size_t block_size_{0};
+  std::size_t blocks_per_slab_{0};
+  std::size_t live_blocks_{0};
+  free_block_s *free_list_{nullptr};
+  std::vector<char *> slabs_;
+};
+
+//! \brief Size segregated block pools for a single thread
+class cell_pool_c {
+public:
+  inline void *allocate(const std::size_t size) {
+    auto block_size = round_up(size);
+    track_allocation(block_size);
+    if (block_size > MAX_POOLED_BLOCK_SIZE) {
+      return ::operator new(size);
+    }
+    auto &pool = pools_[block_size / BLOCK_GRANULARITY - 1];
+    if (!pool) {
+      pool = std::make_unique<block_pool_c>(block_size);
+    }
+    return pool->allocate(stats_);
+  }
+
+  inline void deallocate(void *block, const std::size_t size) {
+    auto block_size = round_up(size);
+    stats_.deallocations++;
+    stats_.bytes_in_use -= block_size;
+    if (block_size > MAX_POOLED_BLOCK_SIZE) {
+      ::operator delete(block);
+      return;
+    }
+    pools_[block_size / BLOCK_GRANULARITY - 1]->deallocate(block);
+  }
+
+  std::size_t release_unused() {
+    std::size_t released{0};
+    for (auto &pool : pools_) {
+      if (pool) {
+        released += pool->release_if_unused();
+      }
+    }
+    stats_.slabs_released += released;
+    return released;
+  }
+
+  cell_allocation_stats_s get_stats() const { return stats_; }
+
+private:
+  static inline std::size_t round_up(const std::size_t size) {
+    return (size + BLOCK_GRANULARITY - 1) & ~(BLOCK_GRANULARITY - 1);
+  }
+
+  inline void track_allocation(const std::size_t block_size) {
+    stats_.allocations++;
+    stats_.bytes_in_use += block_size;
+    if (stats_.bytes_in_use > stats_.peak_bytes) {
+      stats_.peak_bytes = stats_.bytes_in_use;
+    }
+  }
+
+  cell_allocation_stats_s stats_;
+  std::array<std::unique_ptr<block_pool_c>,
+             MAX_POOLED_BLOCK_SIZE / BLOCK_GRANULARITY>
+      pools_;
+};
+
+thread_local cell_pool_c cell_pool;
+
+} // namespace
+
+void *cell_memory_allocate(const std::size_t size) {
+  return cell_pool.allocate(size);
+}
+
+void cell_memory_free(void *block, const std::size_t size) {
+  cell_pool.deallocate(block, size);
+}
+
+std::size_t cell_memory_release_unused() { return cell_pool.release_unused(); }
+
+cell_allocation_stats_s get_cell_allocation_stats() {
+  return cell_pool.get_stats();
+}
+
+} // namespace nibi
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// When enabled, cells are allocated from a thread local pool of fixed size
+// blocks rather than being individually allocated on the heap
+#define CELL_ALLOCATOR_USE_POOL 1
+
+namespace nibi {
+
+//! \brief Statistics on the memory used by cells
+//! \note  Bytes are counted in whole pool blocks
+struct cell_allocation_stats_s {
+  uint64_t allocations{0};
+  uint64_t deallocations{0};
+  uint64_t bytes_in_use{0};
+  uint64_t peak_bytes{0};
+  uint64_t slabs_allocated{0};
+  uint64_t slabs_released{0};
+};
+
+//! \brief Allocate memory for a cell from the calling thread's pool
+//! \param size The number of bytes required
+//! \note  Requests larger than the largest pooled block size
+//!        are forwarded to the global allocator
+extern void *cell_memory_allocate(const std::size_t size);
+
+//! \brief Return memory allocated by cell_memory_allocate
+//! \param block The memory to return
+//! \param size The number of bytes that were requested
+//! \note  The pool is not thread safe, memory must be returned
+//!        on the thread that allocated it
+extern void cell_memory_free(void *block, const std::size_t size);
+
+//! \brief Release all pool slabs back to the system if
+//!        there are no cells that are still alive within them
+//! \returns The number of slabs that were released
+extern std::size_t cell_memory_release_unused();
+
+//! \brief Get the allocation statistics for the calling thread
+extern cell_allocation_stats_s get_cell_allocation_stats();
+
+//! \brief An allocator that routes allocations through the cell pool
+//! \note  Cells themselves are routed to the pool by cell_c's
+//!        operator new, this is for containers of small objects
+//!        that live and die alongside cells
+template <typename T> class cell_allocator_c {
+public:
+  using value_type = T;
+
+  cell_allocator_c() noexcept = default;
+
+  template <typename U>
+  cell_allocator_c(const cell_allocator_c<U> &other) noexcept {}
+
+  T *allocate(const std::size_t n) {
+    return static_cast<T *>(cell_memory_allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T *block, const std::size_t n) noexcept {
+    cell_memory_free(block, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const cell_allocator_c<U> &other) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const cell_allocator_c<U> &other) const noexcept {
+    return false;
+  }
+};
+
+} // namespace nibi
@@ -41,17 +41,22 @@ const char *cell_type_to_string(const cell_type_e type) {
     return "LIST";
   case cell_type_e::DICT:
     return "DICT";
+  case cell_type_e::ENVIRONMENT:
+    return "ENVIRONMENT";
+  case cell_type_e::ABERRANT:
+    return "ABERRANT";
   }
   return "UNKNOWN";
 }
 
-cell_c::~cell_c() {
+cell_c::~cell_c() { release_data(); }
+
+void cell_c::release_data() {
   // Different types of cells may need to be manually cleaned up
   switch (this->type) {
   case cell_type_e::ABERRANT: {
-    auto *aberrant = this->as_aberrant();
-    if (aberrant != nullptr) {
-      delete aberrant;
+    if (data.aberrant != nullptr) {
+      delete data.aberrant;
     }
     break;
   }
@@ -59,189 +64,362 @@ cell_c::~cell_c() {
   // we need to clean the operating environment
   // as well because fauxs own their own
   case cell_type_e::FUNCTION: {
-    auto &func_info = this->as_function_info();
-    if (func_info.type == function_type_e::FAUX) {
-      if (func_info.operating_env) {
-        delete func_info.operating_env;
+    if (data.fn->type == function_type_e::FAUX) {
+      if (data.fn->operating_env) {
+        delete data.fn->operating_env;
       }
     }
+    delete data.fn;
     break;
   }
+  case cell_type_e::STRING:
+    if (--data.str->shares == 0) {
+      delete data.str;
+    }
+    break;
+  case cell_type_e::SYMBOL:
+    delete data.sym;
+    break;
+  case cell_type_e::LIST:
+    if (--data.list->shares == 0) {
+      delete data.list;
+    }
+    break;
+  case cell_type_e::DICT:
+    if (--data.dict->shares == 0) {
+      delete data.dict;
+    }
+    break;
+  case cell_type_e::ENVIRONMENT:
+    delete data.env;
+    break;
   default: {
     break;
   }
   }
+  this->type = cell_type_e::NIL;
+  data.i = 0;
+}
+
+void cell_c::throw_access_error(cell_type_e requested) {
+  switch (requested) {
+  case cell_type_e::INTEGER:
+    throw cell_access_exception_c(
+        "Cell is not an integer: " + this->to_string(), this->locator);
+  case cell_type_e::DOUBLE:
+    throw cell_access_exception_c("Cell is not a double", this->locator);
+  case cell_type_e::STRING:
+    throw cell_access_exception_c("Cell is not a string", this->locator);
+  case cell_type_e::SYMBOL:
+    throw cell_access_exception_c("Cell is not a symbol", this->locator);
+  case cell_type_e::LIST:
+    throw cell_access_exception_c("Cell is not a list", this->locator);
+  case cell_type_e::ABERRANT:
+    throw cell_access_exception_c("Cell is not an aberrant cell",
+                                  this->locator);
+  case cell_type_e::FUNCTION:
+    throw cell_access_exception_c("Cell is not a function", this->locator);
+  case cell_type_e::ENVIRONMENT:
+    throw cell_access_exception_c("Cell is not an environment", this->locator);
+  case cell_type_e::DICT:
+    throw cell_access_exception_c("Cell is not a dict", this->locator);
+  default:
+    break;
+  }
+  throw cell_access_exception_c("Unknown cell type", this->locator);
 }
 
 cell_ptr cell_c::clone(env_c &env) {
+  switch (this->type) {
+  case cell_type_e::SYMBOL: {
+    auto referenced_symbol = env.get(*data.sym);
+    if (referenced_symbol == nullptr) {
+      throw cell_access_exception_c("Unknown variable", this->locator);
+    }
+    return referenced_symbol->clone(env);
+  }
+  case cell_type_e::LIST: {
+    // Numbers held unboxed can be shared as there is nothing to resolve
+    if (data.list->resolved || data.list->value.numeric) {
+      break;
+    }
+    auto &linf = data.list->value;
+    list_info_s other(linf.type);
+    other.list.reserve(linf.list.size());
+    for (auto &cell : linf.list) {
+      other.list.push_back(cell->clone(env));
+    }
+    auto new_cell = allocate_cell(std::move(other));
+    new_cell->data.list->resolved = true;
+    new_cell->locator = this->locator;
+    return new_cell;
+  }
+  case cell_type_e::DICT: {
+    if (data.dict->resolved) {
+      break;
+    }
+    cell_dict_t other;
+    for (auto &pair : data.dict->value) {
+      other[pair.first] = pair.second->clone(env);
+    }
+    auto new_cell = allocate_cell(std::move(other));
+    new_cell->data.dict->resolved = true;
+    new_cell->locator = this->locator;
+    return new_cell;
+  }
+  default:
+    break;
+  }
+  return copy();
+}
 
-  // Allocate a new cell
-  cell_ptr new_cell = allocate_cell(this->type);
+cell_ptr cell_c::copy() {
 
-  // Copy the data
-  new_cell->locator = this->locator;
+  cell_ptr new_cell{nullptr};
 
   switch (this->type) {
   case cell_type_e::NIL:
     return allocate_cell(cell_type_e::NIL);
   case cell_type_e::INTEGER:
-    new_cell->data = this->to_integer();
+    new_cell = allocate_cell(data.i);
     break;
   case cell_type_e::DOUBLE:
-    new_cell->data = this->to_double();
+    new_cell = allocate_cell(data.d);
     break;
-  case cell_type_e::SYMBOL: {
-    auto referenced_symbol = env.get(this->as_symbol());
-    if (referenced_symbol == nullptr) {
-      throw cell_access_exception_c("Unknown variable", this->locator);
-    }
-    new_cell = referenced_symbol->clone(env);
+  case cell_type_e::SYMBOL:
+    new_cell = allocate_cell(symbol_s{data.sym->id});
     break;
-  }
+  // Shared data is only copied once it is modified
   case cell_type_e::STRING:
-    new_cell->data = this->to_string();
+    data.str->shares++;
+    new_cell = allocate_cell(cell_type_e::NIL);
+    new_cell->type = this->type;
+    new_cell->data = this->data;
+    break;
+  case cell_type_e::LIST:
+    data.list->shares++;
+    new_cell = allocate_cell(cell_type_e::NIL);
+    new_cell->type = this->type;
+    new_cell->data = this->data;
+    break;
+  case cell_type_e::DICT:
+    data.dict->shares++;
+    new_cell = allocate_cell(cell_type_e::NIL);
+    new_cell->type = this->type;
+    new_cell->data = this->data;
     break;
   case cell_type_e::FUNCTION: {
 
-    auto &func_info = this->as_function_info();
+    auto &func_info = *data.fn;
 
-    new_cell->data =
-        function_info_s(func_info.name, func_info.fn, func_info.type);
+    function_info_s new_info(func_info.name, func_info.fn, func_info.type,
+                             nullptr, func_info.value_fn,
+                             func_info.apply_fn);
 
     if (func_info.type == function_type_e::FAUX) {
       if (func_info.operating_env) {
-        new_cell->as_function_info().operating_env = new env_c();
-        *new_cell->as_function_info().operating_env = *func_info.operating_env;
+        new_info.operating_env = new env_c();
+        *new_info.operating_env = *func_info.operating_env;
       }
     } else if (func_info.operating_env) {
       // Other functions may be pointing to an env that they don't own
       // so we need to set o set the pointer
-      new_cell->as_function_info().operating_env = func_info.operating_env;
+      new_info.operating_env = func_info.operating_env;
+      new_info.captured_env = func_info.captured_env;
     }
 
     // Copy lambda stuff over
     if (func_info.lambda.has_value()) {
-      new_cell->as_function_info().lambda = func_info.lambda;
-    }
-    break;
-  }
-  case cell_type_e::LIST: {
-    auto &linf = this->as_list_info();
-    auto &other = new_cell->as_list_info();
-    other.type = linf.type;
-    for (auto &cell : linf.list) {
-      other.list.push_back(cell->clone(env));
+      new_info.lambda = func_info.lambda;
     }
+
+    new_cell = allocate_cell(std::move(new_info));
     break;
   }
   case cell_type_e::ENVIRONMENT: {
     throw cell_access_exception_c("Cannot clone an environment", this->locator);
     break;
   }
+  case cell_type_e::ABERRANT: {
+    new_cell = allocate_cell(data.aberrant ? data.aberrant->clone() : nullptr);
+    break;
+  }
+  }
+
+  // Copy the data
+  new_cell->locator = this->locator;
+  return new_cell;
+}
+
+void cell_c::unshare_data() {
+  // The cells within lists and dicts can be modified in place, so
+  // each copy of the data is given its own
+  switch (this->type) {
+  case cell_type_e::STRING: {
+    auto *shared = data.str;
+    data.str = new shared_data_s<std::string>(shared->value);
+    shared->shares--;
+    break;
+  }
+  case cell_type_e::LIST: {
+    auto *shared = data.list;
+    auto *unshared = new shared_data_s<list_info_s>(shared->value.type);
+    unshared->resolved = shared->resolved;
+    if (shared->value.numeric) {
+      unshared->value.numeric =
+          std::make_unique<numeric_list_s>(*shared->value.numeric);
+    }
+    unshared->value.list.reserve(shared->value.list.size());
+    for (auto &cell : shared->value.list) {
+      unshared->value.list.push_back(cell->copy());
+    }
+    data.list = unshared;
+    shared->shares--;
+    break;
+  }
   case cell_type_e::DICT: {
-    auto &dinf = this->as_dict();
-    auto &other = new_cell->as_dict();
-    for (auto &pair : dinf) {
-      other[pair.first] = pair.second->clone(env);
+    auto *shared = data.dict;
+    auto *unshared = new shared_data_s<cell_dict_t>();
+    unshared->resolved = shared->resolved;
+    for (auto &pair : shared->value) {
+      unshared->value[pair.first] = pair.second->copy();
     }
+    data.dict = unshared;
+    shared->shares--;
     break;
   }
-  case cell_type_e::ABERRANT: {
-    new_cell->data = this->as_aberrant();
+  default:
     break;
   }
+}
+
+void cell_c::box_numeric_list() {
+  auto &list_info = data.list->value;
+  auto numbers = std::move(list_info.numeric);
+
+  list_info.list.reserve(numbers->size());
+  value_s item;
+  for (std::size_t i = 0; i < numbers->size(); i++) {
+    numbers->get(i, item);
+    list_info.list.push_back(item.box(this->locator));
   }
-  return new_cell;
 }
 
 void cell_c::update_from(cell_c &other, env_c &env) {
-  this->type = other.type;
-  this->data = other.clone(env)->data;
-}
+  auto cloned = other.clone(env);
 
-int64_t cell_c::to_integer() {
-  if (this->type == cell_type_e::DOUBLE) {
-    return (int64_t)this->as_double();
-  }
-  return this->as_integer();
+  // Take ownership of the freshly cloned data so it doesn't
+  // have to be copied a second time
+  this->release_data();
+  this->type = cloned->type;
+  this->data = cloned->data;
+  cloned->type = cell_type_e::NIL;
+  cloned->data.i = 0;
 }
 
-int64_t &cell_c::as_integer() {
-  try {
-    return std::any_cast<int64_t &>(this->data);
-  } catch (const std::bad_any_cast &e) {
-    throw cell_access_exception_c(
-        "Cell is not an integer: " + this->to_string(), this->locator);
+void cell_c::update_from(value_s &value, env_c &env) {
+  switch (value.type) {
+  case cell_type_e::INTEGER:
+    this->release_data();
+    this->type = cell_type_e::INTEGER;
+    this->data.i = value.i;
+    return;
+  case cell_type_e::DOUBLE:
+    this->release_data();
+    this->type = cell_type_e::DOUBLE;
+    this->data.d = value.d;
+    return;
+  default:
+    update_from(*value.cell, env);
+    return;
   }
 }
 
-double cell_c::to_double() {
-  if (this->type == cell_type_e::INTEGER) {
-    return (double)this->as_integer();
+cell_list_t cell_c::to_list() { return this->as_list(); }
+
+cell_list_t &cell_c::as_list() { return as_list_info().list; }
+
+list_info_s cell_c::to_list_info() { return this->as_list_info(); }
+
+list_info_s &cell_c::as_list_info() {
+  if (this->type != cell_type_e::LIST) {
+    throw_access_error(cell_type_e::LIST);
+  }
+  if (data.list->shares > 1) {
+    unshare_data();
+  }
+  if (data.list->value.numeric) {
+    box_numeric_list();
   }
-  return this->as_double();
+  return data.list->value;
 }
 
-double &cell_c::as_double() {
-  try {
-    return std::any_cast<double &>(this->data);
-  } catch (const std::bad_any_cast &e) {
-    throw cell_access_exception_c("Cell is not a double", this->locator);
+const list_info_s &cell_c::read_list_info() {
+  if (this->type != cell_type_e::LIST) {
+    throw_access_error(cell_type_e::LIST);
+  }
+  if (data.list->value.numeric) {
+    box_numeric_list();
   }
+  return data.list->value;
 }
 
-cell_list_t cell_c::to_list() { return this->as_list(); }
-
-cell_list_t &cell_c::as_list() {
-  try {
-    auto &info = as_list_info();
-    return info.list;
-  } catch (const std::bad_any_cast &e) {
-    throw cell_access_exception_c("Cell is not a list", this->locator);
+numeric_list_s *cell_c::as_numeric_list() {
+  if (this->type != cell_type_e::LIST) {
+    throw_access_error(cell_type_e::LIST);
+  }
+  if (!data.list->value.numeric) {
+    return nullptr;
+  }
+  if (data.list->shares > 1) {
+    unshare_data();
   }
+  return data.list->value.numeric.get();
 }
 
-list_info_s cell_c::to_list_info() { return this->as_list_info(); }
-
-list_info_s &cell_c::as_list_info() {
-  try {
-    return std::any_cast<list_info_s &>(this->data);
-  } catch (const std::bad_any_cast &e) {
-    throw cell_access_exception_c("Cell is not a list", this->locator);
+const numeric_list_s *cell_c::read_numeric_list() {
+  if (this->type != cell_type_e::LIST) {
+    throw_access_error(cell_type_e::LIST);
   }
+  return data.list->value.numeric.get();
 }
 
 aberrant_cell_if *cell_c::as_aberrant() {
-  try {
-    return std::any_cast<aberrant_cell_if *>(this->data);
-  } catch (const std::bad_any_cast &e) {
-    throw cell_access_exception_c("Cell is not an aberrant cell",
-                                  this->locator);
+  if (this->type != cell_type_e::ABERRANT) {
+    throw_access_error(cell_type_e::ABERRANT);
   }
+  return data.aberrant;
 }
 
 function_info_s &cell_c::as_function_info() {
-  try {
-    return std::any_cast<function_info_s &>(this->data);
-  } catch (const std::bad_any_cast &e) {
-    throw cell_access_exception_c("Cell is not a function", this->locator);
+  if (this->type != cell_type_e::FUNCTION) {
+    throw_access_error(cell_type_e::FUNCTION);
   }
+  return *data.fn;
 }
 
 environment_info_s &cell_c::as_environment_info() {
-  try {
-    return std::any_cast<environment_info_s &>(this->data);
-  } catch (const std::bad_any_cast &e) {
-    throw cell_access_exception_c("Cell is not an environment", this->locator);
+  if (this->type != cell_type_e::ENVIRONMENT) {
+    throw_access_error(cell_type_e::ENVIRONMENT);
   }
+  return *data.env;
 }
 
 cell_dict_t &cell_c::as_dict() {
-  try {
-    return std::any_cast<cell_dict_t &>(this->data);
-  } catch (const std::bad_any_cast &e) {
-    throw cell_access_exception_c("Cell is not a dict", this->locator);
+  if (this->type != cell_type_e::DICT) {
+    throw_access_error(cell_type_e::DICT);
   }
+  if (data.dict->shares > 1) {
+    unshare_data();
+  }
+  return data.dict->value;
+}
+
+const cell_dict_t &cell_c::read_dict() {
+  if (this->type != cell_type_e::DICT) {
+    throw_access_error(cell_type_e::DICT);
+  }
+  return data.dict->value;
 }
 
 std::string cell_c::to_string(bool quote_strings, bool flatten_complex) {
@@ -253,12 +431,12 @@ std::string cell_c::to_string(bool quote_strings, bool flatten_complex) {
   case cell_type_e::DOUBLE:
     return std::to_string(this->as_double());
   case cell_type_e::SYMBOL:
-    return this->as_string();
+    return this->as_symbol();
   case cell_type_e::STRING:
     if (quote_strings) {
-      return "\"" + this->as_string() + "\"";
+      return "\"" + this->read_string() + "\"";
     }
-    return this->as_string();
+    return this->read_string();
   case cell_type_e::ABERRANT: {
     aberrant_cell_if *cell = this->as_aberrant();
     if (!cell)
@@ -294,7 +472,7 @@ std::string cell_c::to_string(bool quote_strings, bool flatten_complex) {
     return result;
   }
   case cell_type_e::DICT: {
-    auto &dict = this->as_dict();
+    auto &dict = this->read_dict();
     std::string result = "{";
     for (auto &pair : dict) {
       result += pair.first + ":" + pair.second->to_string(quote_strings) + " ";
@@ -306,7 +484,21 @@ std::string cell_c::to_string(bool quote_strings, bool flatten_complex) {
   }
   case cell_type_e::LIST: {
     std::string result;
-    auto &list_info = this->as_list_info();
+    auto &list_info = data.list->value;
+
+    // Only data lists hold numbers unboxed
+    if (auto *numbers = list_info.numeric.get()) {
+      result += "[";
+      value_s item;
+      for (std::size_t i = 0; i < numbers->size(); i++) {
+        numbers->get(i, item);
+        result += item.to_string() + " ";
+      }
+      if (result.size() > 1)
+        result.pop_back();
+      result += "]";
+      return result;
+    }
 
     switch (list_info.type) {
     case list_types_e::INSTRUCTION: {
@@ -347,22 +539,26 @@ std::string cell_c::to_string(bool quote_strings, bool flatten_complex) {
 }
 
 std::string &cell_c::as_string() {
-  try {
-    return std::any_cast<std::string &>(this->data);
-  } catch (const std::bad_any_cast &e) {
-    throw cell_access_exception_c("Cell is not a string", this->locator);
+  if (this->type != cell_type_e::STRING) {
+    throw_access_error(cell_type_e::STRING);
+  }
+  if (data.str->shares > 1) {
+    unshare_data();
   }
+  return data.str->value;
 }
 
-std::string &cell_c::as_symbol() {
-  if (this->type != cell_type_e::SYMBOL) {
-    throw cell_access_exception_c("Cell is not a symbol", this->locator);
+const std::string &cell_c::read_string() {
+  if (this->type != cell_type_e::STRING) {
+    throw_access_error(cell_type_e::STRING);
   }
-  try {
-    return std::any_cast<std::string &>(this->data);
-  } catch (const std::bad_any_cast &e) {
-    throw cell_access_exception_c("Symbol cell does not contain a string",
-                                  this->locator);
+  return data.str->value;
+}
+
+const std::string &cell_c::as_symbol() {
+  if (this->type != cell_type_e::SYMBOL) {
+    throw_access_error(cell_type_e::SYMBOL);
   }
+  return symbol_name(data.sym->id);
 }
 } // namespace nibi
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "libnibi/RLL/rll_wrapper.hpp"
+#include "libnibi/allocator.hpp"
+#include "libnibi/ref_ptr.hpp"
 #include "libnibi/source.hpp"
-#include <any>
+#include "libnibi/symbols.hpp"
 #include <cassert>
 #include <cstdint>
 #include <exception>
@@ -10,9 +12,14 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #define CELL_LIST_USE_STD_VECTOR 1
 
+// When enabled, lists spawned from a number hold their items unboxed
+// until something other than a number of the same type is put in them
+#define CELL_LIST_USE_NUMERIC_STORAGE 1
+
 #if CELL_LIST_USE_STD_VECTOR
 #include <vector>
 #else
@@ -65,12 +72,14 @@ class env_c;
 class cell_c;
 class interpreter_c;
 class cell_processor_if;
+struct bytecode_s;
 
 //! \brief A cell pointer type
-using cell_ptr = std::shared_ptr<cell_c>;
+//! \note  Cells carry their own reference count, see ref_ptr.hpp
+using cell_ptr = ref_ptr_c<cell_c>;
 
 constexpr auto allocate_cell = [](auto... args) -> nibi::cell_ptr {
-  return std::make_shared<nibi::cell_c>(args...);
+  return nibi::make_ref<nibi::cell_c>(args...);
 };
 
 //! \brief A list of cells
@@ -82,15 +91,97 @@ using cell_list_t = std::deque<cell_ptr>;
 #endif
 
 //! \brief A function that takes a list of cells and an environment
-using cell_fn_t =
-    std::function<cell_ptr(cell_processor_if &ci, cell_list_t &, env_c &)>;
+//! \note  Builtins, lambdas and external functions are all plain
+//!        functions, so they are called directly rather than
+//!        through a type erased wrapper
+using cell_fn_t = cell_ptr (*)(cell_processor_if &ci, cell_list_t &, env_c &);
 
 using cell_dict_t = std::unordered_map<std::string, cell_ptr>;
 
+//! \brief A value produced while processing an instruction
+//! \note  Numeric values are carried unboxed so intermediate
+//!        results don't have to be allocated as cells. Any other
+//!        type of value is carried by the cell that holds it.
+struct value_s {
+  cell_type_e type{cell_type_e::NIL};
+  union {
+    int64_t i{0};
+    double d;
+  };
+  cell_ptr cell{nullptr};
+
+  //! \brief Set the value to an unboxed integer
+  inline void set(const int64_t value) {
+    type = cell_type_e::INTEGER;
+    i = value;
+  }
+
+  //! \brief Set the value to an unboxed double
+  inline void set(const double value) {
+    type = cell_type_e::DOUBLE;
+    d = value;
+  }
+
+  //! \brief Set the value from a cell, unboxing it if it is numeric
+  inline void set(cell_ptr value);
+
+  //! \brief Check if the value is a numeric type
+  inline bool is_numeric() const {
+    return type == cell_type_e::INTEGER || type == cell_type_e::DOUBLE;
+  }
+
+  //! \brief Get the value as an integer
+  //! \throws cell_access_exception_c if the value is not numeric
+  inline int64_t to_integer();
+
+  //! \brief Get the value as a double
+  //! \throws cell_access_exception_c if the value is not numeric
+  inline double to_double();
+
+  //! \brief Get the value as a string
+  inline std::string to_string();
+
+  //! \brief Materialize the value as a cell
+  //! \param locator The locator to give a newly allocated cell
+  //! \note Non-numeric values return the cell that holds them
+  inline cell_ptr box(locator_ptr locator = nullptr);
+};
+
+//! \brief A function that produces a value from a list of cells
+//!        and an environment without needing to box the result
+using value_fn_t = void (*)(cell_processor_if &ci, cell_list_t &, env_c &,
+                            value_s &);
+
+//! \brief A function that produces a value from arguments that have
+//!        already been evaluated, where args[n] is the value of list[n + 1]
+using apply_fn_t = void (*)(value_s *args, cell_list_t &, value_s &);
+
+//! \brief Names of the locals that an environment holds in slots
+//!        rather than in its map, in slot order
+using env_layout_t = std::vector<symbol_id_t>;
+
+//! \brief Where a symbol was last found when looked up from an environment
+//! \note  The binding points at the storage of the cell within the
+//!        environment it was found in, so rebinding the symbol is seen
+//!        without missing the cache. Entries are only valid while the
+//!        environment they were looked up from and the binding epoch
+//!        are unchanged
+struct lookup_cache_s {
+  uint64_t env{0};
+  uint64_t epoch{0};
+  cell_ptr *binding{nullptr};
+};
+
 //! \brief Lambda information that can be encoded into a cell
+//! \note  The argument names are resolved into a layout when the
+//!        lambda is defined so that the environment the body runs
+//!        in can hold the arguments in slots
+//! \note  Lambdas whose body defines functions need the environment
+//!        of each call to live for as long as those functions
 struct lambda_info_s {
-  std::vector<std::string> arg_names;
+  std::shared_ptr<const env_layout_t> arg_names{nullptr};
   cell_ptr body{nullptr};
+  bool defines_functions{false};
 };
 
 //! \brief Function wrapper that holds the function
@@ -101,22 +192,128 @@ struct lambda_info_s {
 //!        but do not own it, while MACROS own the environment
 //!        to hold onto construction data. While two pointers
 //!        or a further wrapper could be used, this is lighter
+//! \note  Lambdas defined within the call of another lambda
+//!        share the environment of the call, so that it lives
+//!        for as long as they do
+//! \note  Builtins that produce numeric results may also supply
+//!        a value function that the interpreter uses when the
+//!        result does not need to be boxed into a cell, and an
+//!        apply function that bytecode calls once every argument
+//!        has been evaluated
 struct function_info_s {
   std::string name;
   cell_fn_t fn;
   function_type_e type;
   std::optional<lambda_info_s> lambda{std::nullopt};
   env_c *operating_env{nullptr};
+  std::shared_ptr<env_c> captured_env{nullptr};
+  value_fn_t value_fn{nullptr};
+  apply_fn_t apply_fn{nullptr};
   function_info_s() : name(""), fn(nullptr), type(function_type_e::UNSET){};
   function_info_s(std::string name, cell_fn_t fn, function_type_e type,
-                  env_c *env = nullptr)
-      : name(name), fn(fn), type(type), operating_env(env) {}
+                  env_c *env = nullptr, value_fn_t value_fn = nullptr,
+                  apply_fn_t apply_fn = nullptr)
+      : name(name), fn(fn), type(type), operating_env(env),
+        value_fn(value_fn), apply_fn(apply_fn) {}
+};
+
+//! \brief Storage for a data list whose items are numbers of one type
+//! \note  Items are held unboxed and contiguous, in whichever of the
+//!        vectors matches their type
+struct numeric_list_s {
+  cell_type_e type;
+  std::vector<int64_t> integers;
+  std::vector<double> doubles;
+
+  //! \brief Create storage holding a number of copies of a value
+  //! \param value The numeric value to copy
+  //! \param count The number of items
+  numeric_list_s(const value_s &value, const std::size_t count)
+      : type(value.type) {
+    if (type == cell_type_e::INTEGER) {
+      integers.assign(count, value.i);
+    } else {
+      doubles.assign(count, value.d);
+    }
+  }
+
+  //! \brief Create storage holding the given integers
+  numeric_list_s(std::vector<int64_t> items)
+      : type(cell_type_e::INTEGER), integers(std::move(items)) {}
+
+  //! \brief Create storage holding the given doubles
+  numeric_list_s(std::vector<double> items)
+      : type(cell_type_e::DOUBLE), doubles(std::move(items)) {}
+
+  //! \brief Get the number of items
+  inline std::size_t size() const {
+    return type == cell_type_e::INTEGER ? integers.size() : doubles.size();
+  }
+
+  //! \brief Get an item as a value
+  inline void get(const std::size_t index, value_s &out) const {
+    if (type == cell_type_e::INTEGER) {
+      out.set(integers[index]);
+    } else {
+      out.set(doubles[index]);
+    }
+  }
+
+  //! \brief Set an item from a value
+  //! \returns false if the value is not a number of the same type
+  inline bool set(const std::size_t index, const value_s &value) {
+    if (value.type != type) {
+      return false;
+    }
+    if (type == cell_type_e::INTEGER) {
+      integers[index] = value.i;
+    } else {
+      doubles[index] = value.d;
+    }
+    return true;
+  }
+
+  //! \brief Insert an item from a value before a given index
+  //! \returns false if the value is not a number of the same type
+  inline bool insert(const std::size_t index, const value_s &value) {
+    if (value.type != type) {
+      return false;
+    }
+    if (type == cell_type_e::INTEGER) {
+      integers.insert(integers.begin() + index, value.i);
+    } else {
+      doubles.insert(doubles.begin() + index, value.d);
+    }
+    return true;
+  }
+
+  //! \brief Remove an item
+  inline void erase(const std::size_t index) {
+    if (type == cell_type_e::INTEGER) {
+      integers.erase(integers.begin() + index);
+    } else {
+      doubles.erase(doubles.begin() + index);
+    }
+  }
 };
 
 //! \brief List wrapper that holds list meta data
+//! \note  Lists that are executed often are compiled to bytecode
+//!        by the interpreter. The compiled form belongs to this list
+//!        alone, so it is not carried over when the list is copied.
+//!        The same goes for being marked as a tail call, which only
+//!        holds for the list where it sits in the body of a lambda
+//! \note  Data lists of numbers may hold them in numeric storage
+//!        rather than in cells, in which case the list of cells is
+//!        empty. Cells are given the items once something other than
+//!        the list builtins needs to reach them
 struct list_info_s {
   list_types_e type;
   cell_list_t list;
+  std::unique_ptr<numeric_list_s> numeric{nullptr};
+  std::shared_ptr<bytecode_s> bytecode{nullptr};
+  uint32_t executions{0};
+  bool tail_call{false};
   list_info_s(list_types_e type, cell_list_t list) : type(type), list(list) {}
 
   list_info_s(list_types_e type) : type(type) {
@@ -124,12 +321,39 @@ struct list_info_s {
     list.reserve(CELL_VEC_RESERVE_SIZE);
 #endif
   }
+
+  list_info_s(const list_info_s &other) : type(other.type), list(other.list) {
+    if (other.numeric) {
+      numeric = std::make_unique<numeric_list_s>(*other.numeric);
+    }
+  }
+  list_info_s(list_info_s &&other) = default;
+
+  list_info_s &operator=(const list_info_s &other) {
+    type = other.type;
+    list = other.list;
+    numeric = other.numeric ? std::make_unique<numeric_list_s>(*other.numeric)
+                            : nullptr;
+    bytecode = nullptr;
+    executions = 0;
+    tail_call = false;
+    return *this;
+  }
+  list_info_s &operator=(list_info_s &&other) = default;
 };
 
 // Temporary wrapper to distnguish strings from symbols
 // in the cell constructor
 struct symbol_s {
-  std::string data;
+  symbol_id_t id;
+};
+
+//! \brief Symbol information that can be encoded into a cell
+//! \note  Each symbol cell is its own call site, so it carries the
+//!        cache of where it was last found
+struct symbol_info_s {
+  symbol_id_t id;
+  lookup_cache_s cache{};
 };
 
 //! \brief Environment information that can be encoded into a cell
@@ -181,6 +405,12 @@ public:
   //! \brief Clone the cell
   virtual aberrant_cell_if *clone() = 0;
 
+  //! \brief Copy the cell for use on another thread
+  //! \return nullptr if the cell can't be used from other threads
+  //! \note  Called from the thread the copy is for, while the thread
+  //!        the cell belongs to waits
+  virtual aberrant_cell_if *share() { return nullptr; }
+
   //! \brief Get the tag of the cell
   std::size_t get_tag() const { return tag_; }
 
@@ -200,49 +430,101 @@ private:
   std::size_t tag_{0};
 };
 
+//! \brief Out of line cell data that clones of a cell share
+//! \note  Shared data is copied the first time that one of the cells
+//!        sharing it is accessed in a way that could modify it
+//! \note  Data produced by cloning holds no symbols, so it can be
+//!        shared outright when cloned again. Anything else, like a
+//!        list taken straight from the source, is deep copied when
+//!        first cloned so that its symbols are resolved
+template <typename T> struct shared_data_s {
+  T value;
+  uint32_t shares{1};
+  bool resolved{false};
+
+  template <typename... Args>
+  shared_data_s(Args &&...args) : value(std::forward<Args>(args)...) {}
+};
+
+//! \brief The payload of a cell
+//! \note  Numeric values are stored inline, while all complex
+//!        types are stored out of line and owned by the cell.
+//!        Strings, lists and dicts may be shared between cells.
+//!        Which member is active is determined by the cell type
+union cell_data_u {
+  int64_t i;
+  double d;
+  shared_data_s<std::string> *str;
+  symbol_info_s *sym;
+  shared_data_s<list_info_s> *list;
+  shared_data_s<cell_dict_t> *dict;
+  function_info_s *fn;
+  environment_info_s *env;
+  aberrant_cell_if *aberrant;
+};
+
 //! \brief A cell
-class cell_c {
+class cell_c : public ref_counted_c {
 public:
   //! \brief Create a cell with a given type
   cell_c(cell_type_e type) : type(type) {
     // Initialize the data based on given type
     switch (type) {
     case cell_type_e::NIL:
-      [[fallthrough]];
+      data.i = 0;
+      break;
     case cell_type_e::ABERRANT:
-      data = nullptr;
+      data.aberrant = nullptr;
       break;
     case cell_type_e::ENVIRONMENT:
-      data = environment_info_s{"", nullptr};
+      data.env = new environment_info_s{"", nullptr};
       break;
     case cell_type_e::FUNCTION:
-      data = function_info_s("", nullptr, function_type_e::UNSET);
+      data.fn = new function_info_s("", nullptr, function_type_e::UNSET);
       break;
     case cell_type_e::INTEGER:
-      data = int64_t(0);
+      data.i = 0;
       break;
     case cell_type_e::DOUBLE:
-      data = double(0.00);
+      data.d = 0.00;
       break;
     case cell_type_e::STRING:
-      [[fallthrough]];
+      data.str = new shared_data_s<std::string>();
+      break;
     case cell_type_e::SYMBOL:
-      data = std::string();
+      data.sym = new symbol_info_s{intern_symbol("")};
       break;
     case cell_type_e::LIST:
-      data = list_info_s(list_types_e::DATA);
+      data.list = new shared_data_s<list_info_s>(list_types_e::DATA);
+      break;
+    case cell_type_e::DICT:
+      data.dict = new shared_data_s<cell_dict_t>();
       break;
     }
   }
-  cell_c(int64_t data) : type(cell_type_e::INTEGER), data(data) {}
-  cell_c(double data) : type(cell_type_e::DOUBLE), data(data) {}
-  cell_c(std::string data) : type(cell_type_e::STRING), data(data) {}
-  cell_c(symbol_s data) : type(cell_type_e::SYMBOL), data(data.data) {}
-  cell_c(list_info_s list) : type(cell_type_e::LIST), data(list) {}
-  cell_c(aberrant_cell_if *acif) : type(cell_type_e::ABERRANT), data(acif) {}
-  cell_c(function_info_s fn) : type(cell_type_e::FUNCTION), data(fn) {}
-  cell_c(environment_info_s env) : type(cell_type_e::ENVIRONMENT), data(env) {}
-  cell_c(cell_dict_t dict) : type(cell_type_e::DICT), data(dict) {}
+  cell_c(int64_t value) : type(cell_type_e::INTEGER) { data.i = value; }
+  cell_c(double value) : type(cell_type_e::DOUBLE) { data.d = value; }
+  cell_c(std::string value) : type(cell_type_e::STRING) {
+    data.str = new shared_data_s<std::string>(std::move(value));
+  }
+  cell_c(symbol_s value) : type(cell_type_e::SYMBOL) {
+    data.sym = new symbol_info_s{value.id};
+  }
+  cell_c(list_info_s list) : type(cell_type_e::LIST) {
+    data.list = new shared_data_s<list_info_s>(std::move(list));
+  }
+  cell_c(aberrant_cell_if *acif) : type(cell_type_e::ABERRANT) {
+    data.aberrant = acif;
+  }
+  cell_c(function_info_s fn) : type(cell_type_e::FUNCTION) {
+    data.fn = new function_info_s(std::move(fn));
+  }
+  cell_c(environment_info_s env) : type(cell_type_e::ENVIRONMENT) {
+    data.env = new environment_info_s(std::move(env));
+  }
+  cell_c(cell_dict_t dict) : type(cell_type_e::DICT) {
+    data.dict = new shared_data_s<cell_dict_t>(std::move(dict));
+  }
 
   cell_c() = delete;
   cell_c(const cell_c &other) = delete;
@@ -251,33 +533,70 @@ public:
   cell_c &operator=(cell_c &&other) = delete;
   virtual ~cell_c();
 
+#if CELL_ALLOCATOR_USE_POOL
+  static void *operator new(std::size_t size) {
+    return cell_memory_allocate(size);
+  }
+  static void operator delete(void *block, std::size_t size) {
+    cell_memory_free(block, size);
+  }
+#endif
+
   cell_type_e type{cell_type_e::NIL};
-  std::any data{0};
+  cell_data_u data;
   locator_ptr locator{nullptr};
 
   //! \brief Deep copy the cell
+  //! \note  Strings, lists and dicts that have already been cloned
+  //!        share their data with the clone until either is modified
   cell_ptr clone(env_c &env);
 
   //! \brief Update the cell data and type to match another cell
   //! \param other The other cell to match
   //! \note This will not update the locator
+  //! \note As with clone, the data of the other cell may be shared
   void update_from(cell_c &other, env_c &env);
 
+  //! \brief Update the cell data and type to match a value
+  //! \param value The value to match
+  //! \note Numeric values are written in place without allocating
+  void update_from(value_s &value, env_c &env);
+
   //! \brief Get a copy of the cell value
   //! \throws cell_access_exception_c if the cell is not an integer type
-  int64_t to_integer();
+  inline int64_t to_integer() {
+    if (type == cell_type_e::DOUBLE) {
+      return (int64_t)data.d;
+    }
+    return as_integer();
+  }
 
   //! \brief Get a reference to the cell value
   //! \throws cell_access_exception_c if the cell is not an integer type
-  int64_t &as_integer();
+  inline int64_t &as_integer() {
+    if (type != cell_type_e::INTEGER) [[unlikely]] {
+      throw_access_error(cell_type_e::INTEGER);
+    }
+    return data.i;
+  }
 
   //! \brief Get a copy of the cell value
   //! \throws cell_access_exception_c if the cell is not a double type
-  double to_double();
+  inline double to_double() {
+    if (type == cell_type_e::INTEGER) {
+      return (double)data.i;
+    }
+    return as_double();
+  }
 
   //! \brief Get a reference to the cell value
   //! \throws cell_access_exception_c if the cell is not a double type
-  double &as_double();
+  inline double &as_double() {
+    if (type != cell_type_e::DOUBLE) [[unlikely]] {
+      throw_access_error(cell_type_e::DOUBLE);
+    }
+    return data.d;
+  }
 
   //! \brief Attempt to convert whatever data type exists to a string
   //!        and return it
@@ -291,11 +610,25 @@ public:
 
   //! \brief Get the string data as a reference
   //! \throws cell_access_exception_c if the cell is not a string type
+  //! \note   Data shared with other cells is copied first
   std::string &as_string();
 
-  //! \brief Get the symbol value
+  //! \brief Get the string data as a reference that can only be read
+  //! \throws cell_access_exception_c if the cell is not a string type
+  const std::string &read_string();
+
+  //! \brief Get the name of the symbol
   //! \throws cell_access_exception_c if the cell is not a symbol type
-  std::string &as_symbol();
+  const std::string &as_symbol();
+
+  //! \brief Get the interned id of the symbol
+  //! \throws cell_access_exception_c if the cell is not a symbol type
+  inline symbol_id_t as_symbol_id() {
+    if (type != cell_type_e::SYMBOL) [[unlikely]] {
+      throw_access_error(cell_type_e::SYMBOL);
+    }
+    return data.sym->id;
+  }
 
   //! \brief Get a copy of the cell value
   //! \throws cell_access_exception_c if the cell is not a list type
@@ -303,14 +636,31 @@ public:
 
   //! \brief Get a reference to the cell value
   //! \throws cell_access_exception_c if the cell is not a list type
+  //! \note   Data shared with other cells is copied first
   list_info_s &as_list_info();
 
+  //! \brief Get a reference to the cell value that can only be read
+  //! \throws cell_access_exception_c if the cell is not a list type
+  const list_info_s &read_list_info();
+
+  //! \brief Get the numeric storage of a list
+  //! \returns nullptr if the list holds its items in cells
+  //! \throws cell_access_exception_c if the cell is not a list type
+  //! \note   Data shared with other cells is copied first
+  numeric_list_s *as_numeric_list();
+
+  //! \brief Get the numeric storage of a list that can only be read
+  //! \returns nullptr if the list holds its items in cells
+  //! \throws cell_access_exception_c if the cell is not a list type
+  const numeric_list_s *read_numeric_list();
+
   //! \brief Get a copy of the cell value
   //! \throws cell_access_exception_c if the cell is not a list type
   cell_list_t to_list();
 
   //! \brief Get a reference to the cell value
   //! \throws cell_access_exception_c if the cell is not a list type
+  //! \note   Data shared with other cells is copied first
   cell_list_t &as_list();
 
   //! \brief Get a copy of the cell value
@@ -327,11 +677,104 @@ public:
 
   // \brief Get a reference of the cell value
   // \throws cell_access_exception_c if the cell is not a dict type
+  // \note   Data shared with other cells is copied first
   cell_dict_t &as_dict();
 
+  // \brief Get a reference of the cell value that can only be read
+  // \throws cell_access_exception_c if the cell is not a dict type
+  const cell_dict_t &read_dict();
+
   //! \brief Check if a cell is a numeric type
   inline bool is_numeric() const {
     return type == cell_type_e::INTEGER || type == cell_type_e::DOUBLE;
   }
+
+  //! \brief Check if a cell is a list that holds its items unboxed
+  inline bool is_numeric_list() const {
+    return type == cell_type_e::LIST && data.list->value.numeric;
+  }
+
+private:
+  // Free any out of line data held by the cell
+  void release_data();
+
+  // Copy the cell without resolving symbols, sharing any data that
+  // can be shared
+  cell_ptr copy();
+
+  // Give the cell its own copy of data that it shares
+  void unshare_data();
+
+  // Move the items of a list out of numeric storage into cells
+  void box_numeric_list();
+
+  // Throw the access exception for a mismatched type request
+  [[noreturn]] void throw_access_error(cell_type_e requested);
 };
+
+inline void value_s::set(cell_ptr value) {
+  switch (value->type) {
+  case cell_type_e::INTEGER:
+    set(value->data.i);
+    cell = nullptr;
+    return;
+  case cell_type_e::DOUBLE:
+    set(value->data.d);
+    cell = nullptr;
+    return;
+  default:
+    type = value->type;
+    cell = std::move(value);
+    return;
+  }
+}
+
+inline int64_t value_s::to_integer() {
+  switch (type) {
+  case cell_type_e::INTEGER:
+    return i;
+  case cell_type_e::DOUBLE:
+    return (int64_t)d;
+  default:
+    return cell->to_integer();
+  }
+}
+
+inline double value_s::to_double() {
+  switch (type) {
+  case cell_type_e::INTEGER:
+    return (double)i;
+  case cell_type_e::DOUBLE:
+    return d;
+  default:
+    return cell->to_double();
+  }
+}
+
+inline std::string value_s::to_string() {
+  switch (type) {
+  case cell_type_e::INTEGER:
+    return std::to_string(i);
+  case cell_type_e::DOUBLE:
+    return std::to_string(d);
+  default:
+    return cell->to_string();
+  }
+}
+
+inline cell_ptr value_s::box(locator_ptr locator) {
+  cell_ptr boxed{nullptr};
+  switch (type) {
+  case cell_type_e::INTEGER:
+    boxed = allocate_cell(i);
+    break;
+  case cell_type_e::DOUBLE:
+    boxed = allocate_cell(d);
+    break;
+  default:
+    return cell;
+  }
+  boxed->locator = locator;
+  return boxed;
+}
 } // namespace nibi
@@ -10,5 +10,11 @@ static constexpr const char *NIBI_MODULE_TEST_DIR = "tests";
 static constexpr const char *NIBI_APP_ENTRY_FILE_NAME = "main.nibi";
 static constexpr const char *NIBI_SYSTEM_CONFIG_FILE_NAME = "config.nibi";
 static constexpr uint32_t NIBI_MODULE_ABERRANT_ID_SIZE = 32;
+static constexpr const char *NIBI_THREADS_ENV = "NIBI_THREADS";
+static constexpr uint32_t NIBI_INTAKE_CHUNK_SIZE = 64 * 1024;
+static constexpr uint32_t NIBI_SOURCE_MAP_MIN_SIZE = 64 * 1024;
+static constexpr const char *NIBI_CACHE_PATH_ENV = "NIBI_CACHE_PATH";
+static constexpr const char *NIBI_CACHE_DIR_NAME = "cache";
+static constexpr uint32_t NIBI_CACHE_MIN_SIZE = 1024;
 } // namespace config
 } // namespace nibi
@@ -1,11 +1,220 @@
 #include "libnibi/environment.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
 namespace nibi {
-env_c::~env_c() {}
 
-env_c::env_c(env_c *parent_env) : parent_env_(parent_env) {}
+namespace {
+
+// Every environment is given an id that is never reused, so a cache
+// entry can't be mistaken as belonging to an environment that has
+// since taken the place of the one it was looked up from
+std::atomic<uint64_t> next_env_id{1};
+
+// Bumped whenever a cell is removed from an environment, which
+// is the only way the storage that a cache entry points to can
+// be released while the environment it was looked up from lives
+std::atomic<uint64_t> binding_epoch{1};
+
+thread_local lookup_cache_stats_s lookup_cache_stats;
+
+inline uint64_t generate_env_id() {
+  return next_env_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void invalidate_lookup_caches() {
+  binding_epoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace
+
+lookup_cache_stats_s get_lookup_cache_stats() { return lookup_cache_stats; }
+
+cell_ptr *env_slot_stack_c::acquire(const std::size_t count) {
+  if (count > BLOCK_SIZE) {
+    return nullptr;
+  }
+
+  if (blocks_.empty()) {
+    blocks_.push_back(std::make_unique<cell_ptr[]>(BLOCK_SIZE));
+  }
+
+  // Slots are never split across blocks, what is left
+  // of a block is skipped until the stack unwinds past it
+  if (top_ + count > BLOCK_SIZE) {
+    block_++;
+    top_ = 0;
+    if (block_ == blocks_.size()) {
+      blocks_.push_back(std::make_unique<cell_ptr[]>(BLOCK_SIZE));
+    }
+  }
+
+  auto *slots = blocks_[block_].get() + top_;
+  top_ += count;
+  return slots;
+}
+
+void env_slot_stack_c::release(cell_ptr *slots) {
+  auto address = reinterpret_cast<std::uintptr_t>(slots);
+  while (true) {
+    auto start = reinterpret_cast<std::uintptr_t>(blocks_[block_].get());
+    if (address >= start && address < start + BLOCK_SIZE * sizeof(cell_ptr)) {
+      top_ = slots - blocks_[block_].get();
+      return;
+    }
+    block_--;
+  }
+}
+
+env_c::env_c() : id_(generate_env_id()) {}
+
+env_c::~env_c() { release_locals(); }
 
-env_c *env_c::get_env(const std::string &name) {
+env_c::env_c(env_c *parent_env)
+    : id_(generate_env_id()), parent_env_(parent_env) {}
+
+env_c::env_c(env_c *parent_env, std::shared_ptr<const env_layout_t> layout)
+    : id_(generate_env_id()), parent_env_(parent_env),
+      layout_(std::move(layout)) {
+  allocate_locals(nullptr);
+}
+
+env_c::env_c(env_c *parent_env, std::shared_ptr<const env_layout_t> layout,
+             env_slot_stack_c &slot_stack)
+    : id_(generate_env_id()), parent_env_(parent_env),
+      layout_(std::move(layout)) {
+  allocate_locals(&slot_stack);
+}
+
+env_c::env_c(const env_c &other)
+    : std::enable_shared_from_this<env_c>(), id_(generate_env_id()),
+      parent_env_(other.parent_env_), cell_map_(other.cell_map_),
+      loaded_modules_(other.loaded_modules_), layout_(other.layout_) {
+  allocate_locals(nullptr);
+  std::copy(other.locals_, other.locals_ + local_count(), locals_);
+}
+
+env_c &env_c::operator=(const env_c &other) {
+  if (this == &other) {
+    return *this;
+  }
+
+  // The cells currently held are released
+  invalidate_lookup_caches();
+  id_ = generate_env_id();
+  parent_env_ = other.parent_env_;
+  cell_map_ = other.cell_map_;
+  loaded_modules_ = other.loaded_modules_;
+
+  // Slots taken from a slot stack are kept where they can be,
+  // as they can only be returned in the order they were taken
+  if (local_count() != other.local_count()) {
+    release_locals();
+    layout_ = other.layout_;
+    allocate_locals(nullptr);
+  }
+  layout_ = other.layout_;
+  std::copy(other.locals_, other.locals_ + local_count(), locals_);
+  return *this;
+}
+
+void env_c::allocate_locals(env_slot_stack_c *slot_stack) {
+  auto count = local_count();
+  if (!count) {
+    return;
+  }
+  if (slot_stack) {
+    locals_ = slot_stack->acquire(count);
+    if (locals_) {
+      slot_stack_ = slot_stack;
+      return;
+    }
+  }
+  locals_ = new cell_ptr[count];
+}
+
+void env_c::release_locals() {
+  if (!locals_) {
+    return;
+  }
+  if (slot_stack_) {
+    // The slots are handed out again, so they can't hold on to anything
+    std::fill(locals_, locals_ + local_count(), nullptr);
+    slot_stack_->release(locals_);
+    slot_stack_ = nullptr;
+  } else {
+    delete[] locals_;
+  }
+  locals_ = nullptr;
+}
+
+void env_c::release_captures() {
+  auto captured_here = [this](const cell_ptr &cell) {
+    return cell && cell->type == cell_type_e::FUNCTION &&
+           cell->data.fn->captured_env.get() == this && cell.use_count() == 1;
+  };
+
+  std::size_t captures{0};
+  for (std::size_t i = 0; i < local_count(); i++) {
+    captures += captured_here(locals_[i]);
+  }
+  for (auto &[name, cell] : cell_map_) {
+    captures += captured_here(cell);
+  }
+
+  // Anything sharing the environment other than the functions it holds
+  // and the owner releasing them means something was kept from the call
+  if (!captures ||
+      weak_from_this().use_count() != static_cast<long>(captures + 1)) {
+    return;
+  }
+
+  for (std::size_t i = 0; i < local_count(); i++) {
+    if (captured_here(locals_[i])) {
+      locals_[i] = nullptr;
+    }
+  }
+  for (auto &[name, cell] : cell_map_) {
+    if (captured_here(cell)) {
+      cell = nullptr;
+    }
+  }
+}
+
+cell_ptr *env_c::find_local(const symbol_id_t name) {
+  if (!layout_) {
+    return nullptr;
+  }
+
+  // Searched from the back so that a repeated name
+  // refers to the last slot given that name
+  for (std::size_t i = layout_->size(); i > 0; i--) {
+    if ((*layout_)[i - 1] == name) {
+      return &locals_[i - 1];
+    }
+  }
+  return nullptr;
+}
+
+bool env_c::is_empty() const {
+  if (!cell_map_.empty()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < local_count(); i++) {
+    if (locals_[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+env_c *env_c::get_env(const symbol_id_t name) {
+
+  if (auto local = find_local(name); local && *local) {
+    return this;
+  }
 
   if (cell_map_.find(name) != cell_map_.end()) {
     return this;
@@ -18,20 +227,51 @@ env_c *env_c::get_env(const std::string &name) {
   return nullptr;
 }
 
-cell_ptr env_c::get(const std::string &name) {
+cell_ptr *env_c::find_binding(const symbol_id_t name) {
+  if (auto local = find_local(name); local && *local) {
+    return local;
+  }
+
   auto it = cell_map_.find(name);
   if (it != cell_map_.end()) {
-    return it->second;
+    return &it->second;
   }
 
   if (parent_env_) {
-    return parent_env_->get(name);
+    return parent_env_->find_binding(name);
   }
 
   return nullptr;
 }
 
-bool env_c::do_set(const std::string &name, const cell_ptr &cell) {
+cell_ptr env_c::get(const symbol_id_t name) {
+  auto binding = find_binding(name);
+  return binding ? *binding : nullptr;
+}
+
+cell_ptr env_c::get(symbol_info_s &symbol) {
+  auto &cache = symbol.cache;
+  auto epoch = binding_epoch.load(std::memory_order_relaxed);
+  if (cache.env == id_ && cache.epoch == epoch) {
+    lookup_cache_stats.hits++;
+    return *cache.binding;
+  }
+
+  lookup_cache_stats.misses++;
+  auto binding = find_binding(symbol.id);
+  if (!binding) {
+    return nullptr;
+  }
+  cache = {id_, epoch, binding};
+  return *binding;
+}
+
+bool env_c::do_set(const symbol_id_t name, const cell_ptr &cell) {
+
+  if (auto local = find_local(name); local && *local) {
+    *local = cell;
+    return true;
+  }
 
   auto it = cell_map_.find(name);
   if (it != cell_map_.end()) {
@@ -46,17 +286,51 @@ bool env_c::do_set(const std::string &name, const cell_ptr &cell) {
   return false;
 }
 
-void env_c::set(const std::string &name, const cell_ptr &cell) {
-  if (!do_set(name, cell)) {
-    cell_map_[name] = cell;
+void env_c::set(const symbol_id_t name, const cell_ptr &cell) {
+  if (do_set(name, cell)) {
+    return;
+  }
+
+  // New cells named in the layout are held in their slot
+  if (auto local = find_local(name)) {
+    *local = cell;
+    return;
   }
+  cell_map_[name] = cell;
 }
 
-bool env_c::drop(const std::string &name) {
+void env_c::define(const symbol_id_t name, const cell_ptr &cell) {
+  bool created{false};
+  if (auto local = find_local(name)) {
+    created = !*local;
+    *local = cell;
+  } else {
+    auto [it, inserted] = cell_map_.try_emplace(name, cell);
+    if (!inserted) {
+      it->second = cell;
+    }
+    created = inserted;
+  }
+
+  // Lookups that found a cell in a parent environment
+  // may now need to find this one instead
+  if (created) {
+    invalidate_lookup_caches();
+  }
+}
+
+bool env_c::drop(const symbol_id_t name) {
+
+  if (auto local = find_local(name); local && *local) {
+    *local = nullptr;
+    invalidate_lookup_caches();
+    return true;
+  }
 
   auto it = cell_map_.find(name);
   if (it != cell_map_.end()) {
     cell_map_.erase(it);
+    invalidate_lookup_caches();
     return true;
   }
 
@@ -2,15 +2,54 @@
 
 #include "cell.hpp"
 
+#include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <map>
 
 namespace nibi {
+
+//! \brief Statistics on symbol lookups made through a lookup cache
+struct lookup_cache_stats_s {
+  uint64_t hits{0};
+  uint64_t misses{0};
+};
+
+//! \brief Get the lookup cache statistics for the calling thread
+extern lookup_cache_stats_s get_lookup_cache_stats();
+
+//! \brief Slots for the locals of environments that are created
+//!        and destroyed in stack order, such as those of calls
+//! \note  Slots are handed out from fixed size blocks so that
+//!        they never move once they have been handed out
+class env_slot_stack_c {
+public:
+  //! \brief Take slots from the top of the stack
+  //! \param count The number of slots to take
+  //! \return The slots, or nullptr if more are asked for than
+  //!         a single block holds
+  cell_ptr *acquire(const std::size_t count);
+
+  //! \brief Return slots to the stack
+  //! \param slots The slots, which must be the last that were taken
+  //!        and must have been emptied
+  void release(cell_ptr *slots);
+
+private:
+  static constexpr std::size_t BLOCK_SIZE = 4096;
+
+  std::vector<std::unique_ptr<cell_ptr[]>> blocks_;
+  std::size_t block_{0};
+  std::size_t top_{0};
+};
+
 //! \brief The environment object that will be used to store
 //!        and manage the cells that are used in different scopes
-class env_c {
+//! \note  Environments of lambdas that define functions are shared
+//!        with those functions, so that they outlive the call
+class env_c : public std::enable_shared_from_this<env_c> {
 public:
   // The current implementation has been perfomance tested
   // with the following maps via test_perfs:
@@ -22,21 +61,53 @@ public:
   // followed by phmap::parallel_node_hash_map
   // and then std::unordered_map
   //
-  using env_map_t = std::map<std::string, cell_ptr>;
+  // Cells are keyed by their interned symbol so that lookups
+  // compare integers rather than names
+  using env_map_t = std::map<symbol_id_t, cell_ptr>;
 
-  env_c() = default;
+  env_c();
   ~env_c();
 
+  //! \brief Copy the cells of another environment
+  //! \note  The copy is a distinct environment as far as
+  //!        lookup caches are concerned
+  env_c(const env_c &other);
+  env_c &operator=(const env_c &other);
+
   //! \brief Create an environment object without parameters
   //! \param parent_env The parent environment to use for searching
   //!        upper level scopes
   env_c(env_c *parent_env);
 
+  //! \brief Create an environment object with slots for locals
+  //! \param parent_env The parent environment to use for searching
+  //!        upper level scopes
+  //! \param layout The names of the locals held in slots, which
+  //!        are empty until set
+  //! \note  Locals are found by name like any other cell, but code
+  //!        that has been resolved against the layout can access
+  //!        them directly by slot
+  env_c(env_c *parent_env, std::shared_ptr<const env_layout_t> layout);
+
+  //! \brief Create an environment object with slots for locals
+  //!        taken from a slot stack
+  //! \param parent_env The parent environment to use for searching
+  //!        upper level scopes
+  //! \param layout The names of the locals held in slots
+  //! \param slot_stack The stack that the slots are taken from
+  //! \note  The environment must be destroyed before any other
+  //!        environment that takes slots from the stack after it
+  env_c(env_c *parent_env, std::shared_ptr<const env_layout_t> layout,
+        env_slot_stack_c &slot_stack);
+
   //! \brief Get the env that a cell is in
   //! \param name The name of the cell
   //! \return The env if it exists in this environment or
   //!         a parent environment. otherwise, nullptr
-  env_c *get_env(const std::string &name);
+  env_c *get_env(const symbol_id_t name);
+  env_c *get_env(const std::string &name) {
+    return get_env(intern_symbol(name));
+  }
 
   //! \brief Get a cell from the environment
   //! \param name The name of the cell
@@ -45,18 +116,36 @@ public:
   //! \note Use this function to get a cell from the environment
   //!       that needs to be updated if we want to ensure it exists
   //!       in the environment or in the parent
-  cell_ptr get(const std::string &name);
+  cell_ptr get(const symbol_id_t name);
+  cell_ptr get(const std::string &name) { return get(intern_symbol(name)); }
+
+  //! \brief Get the cell a symbol refers to from the environment
+  //! \param symbol The symbol, whose cache is used and updated
+  //! \return The cell if it exists in this environment or
+  //!         a parent environment. otherwise, nullptr
+  cell_ptr get(symbol_info_s &symbol);
 
   //! \brief Set a cell in the environment
   //! \param name The name of the cell
   //! \param cell The cell to set
-  void set(const std::string &name, const cell_ptr &cell);
+  void set(const symbol_id_t name, const cell_ptr &cell);
+  void set(const std::string &name, const cell_ptr &cell) {
+    set(intern_symbol(name), cell);
+  }
+
+  //! \brief Set a cell in this environment without looking
+  //!        for it in parent environments
+  //! \param name The name of the cell
+  //! \param cell The cell to set
+  //! \note  This can shadow a cell of a parent environment
+  void define(const symbol_id_t name, const cell_ptr &cell);
 
   //! \brief Drop a cell from the environment, or parent environment(s)
   //! \param name The name of the cell
   //! \returns True if the cell was dropped, false if item not found
   //! \post The cell will be erased from the environment and marked for deletion
-  bool drop(const std::string &name);
+  bool drop(const symbol_id_t name);
+  bool drop(const std::string &name) { return drop(intern_symbol(name)); }
 
   //! \brief Get the map of cells in the environment
   //! \return The map of cells in the environment
@@ -64,6 +153,44 @@ public:
   //!       retrieval for specific environments
   env_map_t &get_map() { return cell_map_; }
 
+  //! \brief Get the layout of the locals held in slots
+  //! \return The layout, or nullptr if the environment has no slots
+  const std::shared_ptr<const env_layout_t> &get_layout() const {
+    return layout_;
+  }
+
+  //! \brief Get a local by its slot in the layout
+  //! \param slot The slot of the local
+  //! \return The cell held in the slot, nullptr if it has not been set
+  cell_ptr &get_local(std::size_t slot) { return locals_[slot]; }
+
+  //! \brief Get the parent environment
+  //! \return The parent environment, nullptr if this is the root
+  env_c *get_parent() const { return parent_env_; }
+
+  //! \brief Check if an environment is this one or within it
+  //! \param env The environment to check
+  //! \return True if this environment is found by walking up from `env`
+  bool encloses(const env_c *env) const {
+    for (; env; env = env->parent_env_) {
+      if (env == this) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //! \brief Release the functions defined in the environment that
+  //!        share it, as long as nothing else refers to them or it
+  //! \note  Functions defined within a lambda keep the environment of
+  //!        the call alive while it holds them. Unless something has
+  //!        been kept from the call, both can go once it returns
+  void release_captures();
+
+  //! \brief Check if anything is held in the environment
+  //! \return True if there are no cells held in the map or the slots
+  bool is_empty() const;
+
   //! \brief Indicate that a module has been loaded
   //! \param module_name The name of the module
   void indicate_loaded_module(const std::string &module_name) {
@@ -85,11 +212,39 @@ public:
     return false;
   }
 
+  //! \brief Get the modules that have been loaded into this environment
+  const std::set<std::string> &get_loaded_modules() const {
+    return loaded_modules_;
+  }
+
 private:
+  uint64_t id_;
   env_c *parent_env_{nullptr};
   env_map_t cell_map_;
   std::set<std::string> loaded_modules_;
+  std::shared_ptr<const env_layout_t> layout_{nullptr};
+
+  // The slots of the locals named in the layout, which are
+  // owned unless they were taken from a slot stack
+  cell_ptr *locals_{nullptr};
+  env_slot_stack_c *slot_stack_{nullptr};
+
+  inline std::size_t local_count() const {
+    return layout_ ? layout_->size() : 0;
+  }
+
+  void allocate_locals(env_slot_stack_c *slot_stack);
+  void release_locals();
+
+  inline bool do_set(const symbol_id_t name, const cell_ptr &cell);
+
+  //! \brief Find where a cell is held within this environment
+  //!        or a parent environment
+  //! \return The storage of the cell, or nullptr if not found
+  cell_ptr *find_binding(const symbol_id_t name);
 
-  inline bool do_set(const std::string &name, const cell_ptr &cell);
+  //! \brief Find the slot for a local by name
+  //! \return The slot, or nullptr if the name is not in the layout
+  inline cell_ptr *find_local(const symbol_id_t name);
 };
 } // namespace nibi
@@ -14,7 +14,7 @@ void error_c::draw(bool markup) const {
   }
 
   if (locator_) {
-    draw_locator(*locator_);
+    draw_locator(locator_);
   }
 
   std::cout << rang::fg::cyan << "\nMessage: " << rang::fg::reset << message_
@@ -21,7 +21,9 @@ public:
   bool has_locator() const { return locator_ != nullptr; }
 
   //! \brief Get the locator interface.
-  const locator_if *get_locator() const { return locator_.get(); }
+  const locator_c *get_locator() const {
+    return (locator_) ? &locator_ : nullptr;
+  }
 
   //! \brief Get the error message.
   const std::string get_message() const { return message_; }
@@ -5,9 +5,11 @@
 #include "libnibi/interfaces/file_interpreter_if.hpp"
 #include "libnibi/interpreter/builtins/builtins.hpp"
 #include "libnibi/interpreter/interpreter.hpp"
+#include "libnibi/platform.hpp"
+#include "libnibi/snapshot.hpp"
 #include "libnibi/source.hpp"
 #include <filesystem>
-#include <fstream>
+#include <optional>
 
 namespace nibi {
 
@@ -15,17 +17,22 @@ class file_interpreter_c : public file_interpreter_if {
 public:
   //! \brief Interpret a file.
   //! \param error_callback Callback to report errors.
-  file_interpreter_c(error_callback_f error_callback)
+  //! \param options Options for the interpreter.
+  file_interpreter_c(error_callback_f error_callback,
+                     interpreter_options_s options = {})
       : error_callback_(error_callback),
-        interpreter_(environment_, source_manager_),
+        interpreter_(environment_, source_manager_, options),
         intake_(interpreter_, error_callback, source_manager_,
                 nibi::builtins::get_builtin_symbols_map()) {}
 
   //! \brief Interpret a file and populate a specific environment.
   //! \param error_callback Callback to report errors.
   //! \param env Environment to populate.
-  file_interpreter_c(error_callback_f error_callback, env_c &env)
-      : error_callback_(error_callback), interpreter_(env, source_manager_),
+  //! \param options Options for the interpreter.
+  file_interpreter_c(error_callback_f error_callback, env_c &env,
+                     interpreter_options_s options = {})
+      : error_callback_(error_callback),
+        interpreter_(env, source_manager_, options),
         intake_(interpreter_, error_callback, source_manager_,
                 nibi::builtins::get_builtin_symbols_map()) {}
 
@@ -34,10 +41,11 @@ public:
   //! \param error_callback Callback to report errors.
   //! \param env Environment to populate.
   //! \param sm Source manager to use.
+  //! \param options Options for the interpreter.
   file_interpreter_c(error_callback_f error_callback, env_c &env,
-                     source_manager_c &sm)
-      : error_callback_(error_callback), interpreter_(env, sm),
-        intake_(interpreter_, error_callback, source_manager_,
+                     source_manager_c &sm, interpreter_options_s options = {})
+      : error_callback_(error_callback), interpreter_(env, sm, options),
+        intake_(interpreter_, error_callback, sm,
                 nibi::builtins::get_builtin_symbols_map()) {}
   ~file_interpreter_c() { indicate_complete(); }
 
@@ -47,20 +55,33 @@ public:
       return;
     }
 
-    file_.open(filename);
-    if (!file_.is_open()) {
+    std::optional<parse_cache_c> cache;
+    if (auto *platform = interpreter_.get_platform()) {
+      if (auto cache_path = platform->get_cache_path()) {
+        cache.emplace(*cache_path);
+      }
+    }
+
+    if (!intake_.read_file(filename.string(), cache ? &*cache : nullptr)) {
       error_callback_(error_c("Could not open file: " + filename.string()));
       return;
     }
+  }
+
+  void indicate_complete() override { intake_.end_of_file(); }
 
-    intake_.read(filename.string(), file_);
+  //! \brief Exits are not caught here, they leave the interpreter as an
+  //!        interpreter_c::exit_c for whatever holds it to handle.
+  std::optional<int64_t> get_exit_code() override { return std::nullopt; }
+
+  bool save_snapshot(std::filesystem::path snapshot,
+                     std::filesystem::path file) override {
+    return snapshot_c::save(snapshot, file.string(), interpreter_);
   }
 
-  void indicate_complete() override {
-    if (file_.is_open()) {
-      file_.close();
-    }
-    intake_.end_of_file();
+  bool restore_snapshot(std::filesystem::path snapshot,
+                        std::filesystem::path file) override {
+    return snapshot_c::restore(snapshot, file.string(), interpreter_);
   }
 
 private:
@@ -69,7 +90,6 @@ private:
   source_manager_c source_manager_;
   interpreter_c interpreter_;
   intake_c intake_;
-  std::ifstream file_;
 };
 
 } // namespace nibi
@@ -1,28 +1,30 @@
 #include "intake.hpp"
+#include "libnibi/config.hpp"
 #include <cassert>
+#include <charconv>
 #include <iostream>
 #include <limits>
-#include <regex>
+#include <map>
 
 namespace nibi {
 
 namespace {
 
-token_c generate_type_token(token_e token, locator_ptr locator) {
+token_c generate_type_token(token_e token, const position_s &position) {
 
   switch (token) {
   case token_e::NIL:
-    return token_c(locator, token_e::NIL, "");
+    return token_c(position, token_e::NIL);
   case token_e::TRUE:
-    return token_c(locator, token_e::TRUE, "1");
+    return token_c(position, token_e::TRUE);
   case token_e::FALSE:
-    return token_c(locator, token_e::FALSE, "0");
+    return token_c(position, token_e::FALSE);
   case token_e::NOT_A_NUMBER:
-    return token_c(locator, token_e::NOT_A_NUMBER,
-                   std::to_string(std::numeric_limits<double>::quiet_NaN()));
+    return token_c(position, token_e::NOT_A_NUMBER,
+                   std::numeric_limits<double>::quiet_NaN());
   case token_e::INF:
-    return token_c(locator, token_e::INF,
-                   std::to_string(std::numeric_limits<double>::infinity()));
+    return token_c(position, token_e::INF,
+                   std::numeric_limits<double>::infinity());
   default:
     std::cerr << "INTERNAL ERROR: Invalid type token: " << (int)token
               << std::endl;
@@ -32,7 +34,7 @@ token_c generate_type_token(token_e token, locator_ptr locator) {
   }
 }
 
-static std::map<std::string, token_e> type_map = {
+static std::map<std::string, token_e, std::less<>> type_map = {
     {"nil", token_e::NIL},
     {"true", token_e::TRUE},
     {"false", token_e::FALSE},
@@ -53,6 +55,153 @@ inline std::string closing_sym_from_token(const token_e token) {
     return "";
   }
 }
+
+// Characters that end a symbol or a number
+inline bool is_delimiter(const char c) {
+  switch (c) {
+  case '(':
+  case ')':
+  case '[':
+  case ']':
+  case '{':
+  case '}':
+    return true;
+  default:
+    return std::isspace(static_cast<unsigned char>(c));
+  }
+}
+
+enum class scan_result_e { OK, MALFORMED, OUT_OF_RANGE };
+
+inline bool is_digit_of(const char c, const int base) {
+  switch (base) {
+  case 2:
+    return c == '0' || c == '1';
+  case 16:
+    return std::isxdigit(static_cast<unsigned char>(c));
+  default:
+    return std::isdigit(static_cast<unsigned char>(c));
+  }
+}
+
+// Scan a numeric literal in a single pass, giving the value it holds
+//
+//    [-] digits [. digits] [(e|E) [+|-] digits]    decimal, real if it
+//                                                  has a point or exponent
+//    [-] (0x|0X) hex digits                        hexadecimal integer
+//    [-] (0b|0B) binary digits                     binary integer
+//
+// Digits may be separated by single underscores. Hexadecimal and binary
+// literals may use all 64 bits, so those above the largest integer wrap
+// around to negative values
+scan_result_e scan_number(std::string_view literal, token_e &kind,
+                          int64_t &integer, double &real) {
+  bool negative = literal.starts_with('-');
+  if (negative) {
+    literal.remove_prefix(1);
+  }
+
+  int base = 10;
+  if (literal.size() > 2 && literal[0] == '0') {
+    if (literal[1] == 'x' || literal[1] == 'X') {
+      base = 16;
+    } else if (literal[1] == 'b' || literal[1] == 'B') {
+      base = 2;
+    }
+    if (base != 10) {
+      literal.remove_prefix(2);
+    }
+  }
+
+  // Separators are checked and dropped before the digits are converted
+  std::string without_separators;
+  if (literal.find('_') != std::string_view::npos) {
+    for (std::size_t i = 0; i < literal.size(); i++) {
+      if (literal[i] != '_') {
+        without_separators += literal[i];
+        continue;
+      }
+      if (i == 0 || i + 1 == literal.size() ||
+          !is_digit_of(literal[i - 1], base) ||
+          !is_digit_of(literal[i + 1], base)) {
+        return scan_result_e::MALFORMED;
+      }
+    }
+    literal = without_separators;
+  }
+
+  auto first = literal.data();
+  auto last = literal.data() + literal.size();
+
+  if (base != 10) {
+    uint64_t value{0};
+    auto [end, ec] = std::from_chars(first, last, value, base);
+    if (ec == std::errc::result_out_of_range) {
+      return scan_result_e::OUT_OF_RANGE;
+    }
+    if (ec != std::errc() || end != last) {
+      return scan_result_e::MALFORMED;
+    }
+    kind = token_e::RAW_INTEGER;
+    integer = static_cast<int64_t>(negative ? 0 - value : value);
+    return scan_result_e::OK;
+  }
+
+  // Check the shape of a decimal literal, from_chars would accept less
+  std::size_t i{0};
+  auto digits = [&]() {
+    auto from = i;
+    while (i < literal.size() && is_digit_of(literal[i], 10)) {
+      i++;
+    }
+    return i > from;
+  };
+  bool is_real{false};
+  if (!digits()) {
+    return scan_result_e::MALFORMED;
+  }
+  if (i < literal.size() && literal[i] == '.') {
+    i++;
+    is_real = true;
+    if (!digits()) {
+      return scan_result_e::MALFORMED;
+    }
+  }
+  if (i < literal.size() && (literal[i] == 'e' || literal[i] == 'E')) {
+    i++;
+    is_real = true;
+    if (i < literal.size() && (literal[i] == '+' || literal[i] == '-')) {
+      i++;
+    }
+    if (!digits()) {
+      return scan_result_e::MALFORMED;
+    }
+  }
+  if (i != literal.size()) {
+    return scan_result_e::MALFORMED;
+  }
+
+  if (is_real) {
+    auto [end, ec] = std::from_chars(first, last, real);
+    if (ec != std::errc()) {
+      return scan_result_e::OUT_OF_RANGE;
+    }
+    kind = token_e::RAW_FLOAT;
+    real = negative ? -real : real;
+    return scan_result_e::OK;
+  }
+
+  uint64_t value{0};
+  auto [end, ec] = std::from_chars(first, last, value);
+  uint64_t limit = negative ? uint64_t{1} << 63
+                            : std::numeric_limits<int64_t>::max();
+  if (ec != std::errc() || value > limit) {
+    return scan_result_e::OUT_OF_RANGE;
+  }
+  kind = token_e::RAW_INTEGER;
+  integer = static_cast<int64_t>(negative ? 0 - value : value);
+  return scan_result_e::OK;
+}
 } // namespace
 
 #define NIBI_PARSER_SCAN_LIST(___sym_open, ___sym_close, ___fn)                \
@@ -83,27 +232,101 @@ inline std::string closing_sym_from_token(const token_e token) {
     return nullptr;                                                            \
   }
 
-static std::regex is_number("[+-]?([0-9]*[.])?[0-9]+");
-
 intake_c::intake_c(instruction_processor_if &proc, error_callback_f error_cb,
-                   source_manager_c &sm, function_router_t &router)
+                   source_manager_c &sm, const function_router_t &router)
     : processor_(proc), error_cb_(error_cb), sm_(sm), symbol_router_(router) {
-  parser_ = std::make_unique<parser_c>(symbol_router_, error_cb_);
+  parser_ = std::make_unique<parser_c>(*this, symbol_router_, error_cb_);
 }
 
 void intake_c::read(std::string_view source, std::istream &is) {
 
-  std::string line;
   auto source_origin = sm_.get_source(std::string(source));
 
+  // The stream is read a chunk at a time and lines are scanned where they
+  // sit in the chunk, only those that run over the end of one are copied
+  std::vector<char> chunk(config::NIBI_INTAKE_CHUNK_SIZE);
+  std::string spanning;
+
   bool continue_intake = true;
-  while (continue_intake && std::getline(is, line)) {
+  while (continue_intake && is) {
+    is.read(chunk.data(), chunk.size());
+    std::string_view remaining(chunk.data(), is.gcount());
+
+    while (continue_intake) {
+      auto end = remaining.find('\n');
+      if (end == std::string_view::npos) {
+        spanning.append(remaining);
+        break;
+      }
+
+      auto line = remaining.substr(0, end);
+      remaining.remove_prefix(end + 1);
+
+      tracker_.line_count++;
+      if (spanning.empty()) {
+        continue_intake = process_line(line, source_origin);
+        continue;
+      }
+      spanning.append(line);
+      continue_intake = process_line(spanning, source_origin);
+      spanning.clear();
+    }
+  }
+
+  // The last line need not end with a newline
+  if (continue_intake && !spanning.empty()) {
     tracker_.line_count++;
-    continue_intake = process_line(line, source_origin);
+    process_line(spanning, source_origin);
   }
   check_for_complete_expression();
 }
 
+bool intake_c::read_file(std::string_view source,
+                         const parse_cache_c *cache) {
+
+  auto source_origin = sm_.load_source(std::string(source));
+  if (!source_origin) {
+    return false;
+  }
+
+  // Files that are small enough are parsed quicker than they are cached
+  auto text = source_origin->get_text();
+  recording_.reset();
+  if (cache && text->get_data().size() >= config::NIBI_CACHE_MIN_SIZE) {
+    if (auto instructions =
+            cache->load(std::string(source), *text, source_origin->get_id(),
+                        symbol_router_)) {
+      for (auto &instruction : *instructions) {
+        if (instruction->as_list().size()) {
+          processor_.instruction_ind(instruction);
+        }
+      }
+      return true;
+    }
+    recording_ = std::make_unique<parse_cache_c::recording_c>(symbol_router_);
+  }
+
+  // Lines are scanned where they sit in the loaded text
+  for (std::size_t line = 1; line <= text->get_line_count(); line++) {
+    tracker_.line_count++;
+    if (!process_line(text->get_line(line), source_origin, nullptr, true)) {
+      if (recording_) {
+        recording_->fail();
+      }
+      break;
+    }
+  }
+  check_for_complete_expression();
+
+  if (recording_) {
+    auto recording = std::move(recording_);
+    if (tokens_.empty()) {
+      cache->store(std::string(source), *text, *recording);
+    }
+  }
+  return true;
+}
+
 void intake_c::read_line(std::string_view line,
                          std::shared_ptr<source_origin_c> origin) {
   tracker_.line_count++;
@@ -120,23 +343,57 @@ void intake_c::evaluate(std::string_view data,
 
 void intake_c::end_of_file() { tracker_ = tracker_s(); }
 
+void intake_c::discard_pending() {
+  auto line_count = tracker_.line_count;
+  tracker_ = tracker_s();
+  tracker_.line_count = line_count;
+  tokens_.clear();
+  held_lines_.clear();
+  recording_.reset();
+}
+
 void intake_c::check_for_complete_expression() {
   if (tokens_.size()) {
-    error_cb_(error_c(tokens_.front().get_locator(), "Incomplete expression"));
+    error_cb_(error_c(locate(tokens_.front().get_position()),
+                      "Incomplete expression"));
   }
 }
 
+locator_ptr intake_c::locate(const position_s &position) const {
+  return locator_c(position.source, position.line, position.column);
+}
+
 bool intake_c::process_line(std::string_view data,
                             std::shared_ptr<source_origin_c> origin,
-                            locator_ptr loc_override) {
+                            locator_ptr loc_override, bool text_is_kept) {
+
+  auto result = scan_line(data, origin->get_id(), loc_override);
+
+  // Tokens of an expression that isn't complete are left with views of
+  // the line, which is copied if it won't be around for them
+  if (!text_is_kept && !tokens_.empty()) {
+    auto &held = held_lines_.emplace_back(data);
+    for (auto &token : tokens_) {
+      token.move_data(data, held.data());
+    }
+  }
+  return result;
+}
+
+bool intake_c::scan_line(std::string_view data, const uint32_t source,
+                         locator_ptr loc_override) {
+
+  // Tokens only note where they are, locators are made from that for
+  // errors and for the cells that are parsed from them
+  auto position = [&](const std::size_t col) {
+    return position_s{
+        source, static_cast<uint32_t>(tracker_.line_count),
+        static_cast<uint32_t>(
+            (loc_override) ? loc_override->get_column() + 1 + col : col)};
+  };
 
   for (std::size_t col = 0; col < data.size(); col++) {
-    auto locator =
-        (loc_override)
-            ? origin->get_locator(tracker_.line_count,
-                                  loc_override->get_column() + 1 + col)
-            : origin->get_locator(tracker_.line_count, col);
-    if (std::isspace(data[col])) {
+    if (std::isspace(static_cast<unsigned char>(data[col]))) {
       continue;
     }
     switch (data[col]) {
@@ -144,70 +401,70 @@ bool intake_c::process_line(std::string_view data,
       return true;
     }
     case '(': {
-      tracker_.instruction_stack_.push(locator);
-      process_token(token_c(locator, token_e::L_PAREN));
+      auto at = position(col);
+      tracker_.instruction_stack_.push(at);
+      process_token(token_c(at, token_e::L_PAREN));
       break;
     }
     case ')': {
+      auto at = position(col);
       if (tracker_.instruction_stack_.empty()) {
-        error_cb_(error_c(locator, "Unmatched closing paren"));
+        error_cb_(error_c(locate(at), "Unmatched closing paren"));
         return false;
       }
       tracker_.instruction_stack_.pop();
-      process_token(token_c(locator, token_e::R_PAREN));
+      process_token(token_c(at, token_e::R_PAREN));
       break;
     }
     case '[': {
-      tracker_.data_stack_.push(locator);
-      process_token(token_c(locator, token_e::L_BRACKET));
+      auto at = position(col);
+      tracker_.data_stack_.push(at);
+      process_token(token_c(at, token_e::L_BRACKET));
       break;
     }
     case ']': {
+      auto at = position(col);
       if (tracker_.data_stack_.empty()) {
-        error_cb_(error_c(locator, "Unmatched closing bracket"));
+        error_cb_(error_c(locate(at), "Unmatched closing bracket"));
         return false;
       }
       tracker_.data_stack_.pop();
-      process_token(token_c(locator, token_e::R_BRACKET));
+      process_token(token_c(at, token_e::R_BRACKET));
       break;
     }
     case '{': {
-      tracker_.access_stack_.push(locator);
-      process_token(token_c(locator, token_e::L_BRACE));
+      auto at = position(col);
+      tracker_.access_stack_.push(at);
+      process_token(token_c(at, token_e::L_BRACE));
       break;
     }
     case '}': {
+      auto at = position(col);
       if (tracker_.access_stack_.empty()) {
-        error_cb_(error_c(locator, "Unmatched closing brace"));
+        error_cb_(error_c(locate(at), "Unmatched closing brace"));
         return false;
       }
       tracker_.access_stack_.pop();
-      process_token(token_c(locator, token_e::R_BRACE));
+      process_token(token_c(at, token_e::R_BRACE));
       break;
     }
     case '"': {
-      bool in_str{true};
-      std::string value = "\"";
+      auto at = position(col);
       decltype(col) start = col++;
-      while (col < data.size()) {
-        if (data[col] == '"') {
-          if (col > 0 && data[col - 1] != '\\') {
-            value += data[col];
-            break;
-          }
-        }
-        value += data[col++];
+
+      // Quotes preceded by a backslash don't end the string
+      while (col < data.size() &&
+             (data[col] != '"' || data[col - 1] == '\\')) {
+        col++;
       }
 
-      if (!value.ends_with('"')) {
-        error_cb_(error_c(locator, "Unterminated string"));
+      if (col >= data.size()) {
+        error_cb_(error_c(locate(at), "Unterminated string"));
         return false;
       }
 
-      // Remove the quotes
-      value = value.substr(1, value.size() - 2);
-
-      process_token(token_c(locator, token_e::RAW_STRING, value));
+      process_token(token_c(at, token_e::RAW_STRING,
+                            data.substr(start + 1, col - start - 1)));
       break;
     }
     default: {
@@ -217,54 +474,58 @@ bool intake_c::process_line(std::string_view data,
         // check for negative number vs subtraction
         if (data[col] == '-' && col + 1 < data.size() &&
             !std::isdigit(data[col + 1])) {
-          process_token(token_c(locator, token_e::SYMBOL, "-"));
+          process_token(token_c(position(col), token_e::SYMBOL, "-"));
           break;
         } else if (data[col] == '-' && col == data.size() - 1) {
-          process_token(token_c(locator, token_e::SYMBOL, "-"));
+          process_token(token_c(position(col), token_e::SYMBOL, "-"));
           break;
         }
 
-        std::string number;
-        number += data[col];
-        while (col + 1 < data.size() &&
-               (std::isdigit(data[col + 1]) || data[col + 1] == '.')) {
-          number += data[col + 1];
+        auto at = position(col);
+        decltype(col) start = col;
+        while (col + 1 < data.size() && !is_delimiter(data[col + 1])) {
           col++;
         }
-
-        if (std::regex_match(number, is_number)) {
-          if (number.find('.') != std::string::npos) {
-            process_token(token_c(locator, token_e::RAW_FLOAT, number));
+        auto literal = data.substr(start, col - start + 1);
+
+        token_e kind{token_e::RAW_INTEGER};
+        int64_t integer{0};
+        double real{0.0};
+        switch (scan_number(literal, kind, integer, real)) {
+        case scan_result_e::OK:
+          if (kind == token_e::RAW_FLOAT) {
+            process_token(token_c(at, kind, real));
           } else {
-            process_token(token_c(locator, token_e::RAW_INTEGER, number));
+            process_token(token_c(at, kind, integer));
           }
           break;
-        } else {
-          error_cb_(error_c(locator, "Malformed numerical value"));
+        case scan_result_e::OUT_OF_RANGE:
+          error_cb_(error_c(locate(at), "Numerical value out of range: " +
+                                         std::string(literal)));
+          return false;
+        default:
+          error_cb_(error_c(locate(at), "Malformed numerical value"));
           return false;
         }
         break;
       }
 
-      std::string word;
-      word += data[col];
-      while (col + 1 < data.size() && !std::isspace(data[col + 1]) &&
-             data[col + 1] != '(' && data[col + 1] != ')' &&
-             data[col + 1] != '[' && data[col + 1] != ']' &&
-             data[col + 1] != '{' && data[col + 1] != '}') {
-        word += data[col + 1];
+      auto at = position(col);
+      decltype(col) start = col;
+      while (col + 1 < data.size() && !is_delimiter(data[col + 1])) {
         col++;
       }
+      auto word = data.substr(start, col - start + 1);
 
       {
         auto item = type_map.find(word);
         if (item != type_map.end()) {
-          process_token(generate_type_token(item->second, locator));
+          process_token(generate_type_token(item->second, at));
           break;
         }
       }
 
-      process_token(token_c(locator, token_e::SYMBOL, word));
+      process_token(token_c(at, token_e::SYMBOL, word));
       break;
     }
     }
@@ -272,9 +533,9 @@ bool intake_c::process_line(std::string_view data,
   return true;
 }
 
-void intake_c::process_token(token_c token) {
+void intake_c::process_token(token_c &&token) {
 
-  tokens_.push_back(token);
+  tokens_.push_back(std::move(token));
 
   if (!tracker_.instruction_stack_.empty()) {
     return;
@@ -282,12 +543,24 @@ void intake_c::process_token(token_c token) {
 
   auto instruction = parser_->parse(tokens_);
 
+  // The tokens are done with before the instruction is run, in case
+  // running it leaves the intake
+  tokens_.clear();
+  held_lines_.clear();
+
+  // Instructions are recorded before they are run, as running them
+  // may change them
+  if (recording_) {
+    if (instruction) {
+      recording_->add(*instruction);
+    } else {
+      recording_->fail();
+    }
+  }
+
   if (instruction && instruction->as_list().size()) {
     processor_.instruction_ind(instruction);
   }
-
-  tokens_.clear();
-  return;
 }
 
 cell_ptr intake_c::parser_c::parse(std::vector<token_c> &tokens) {
@@ -299,7 +572,7 @@ cell_ptr intake_c::parser_c::parse(std::vector<token_c> &tokens) {
   list = instruction_list();
 
   if (!list) {
-    error_cb_(error_c(tokens[0].get_locator(),
+    error_cb_(error_c(intake_.locate(tokens[0].get_position()),
                       "Invalid instruction list - Expected '('"));
     return nullptr;
   }
@@ -467,12 +740,12 @@ cell_ptr intake_c::parser_c::symbol() {
     return nullptr;
   }
 
-  auto symbol_raw = current_data();
+  auto symbol_id = intern_symbol(current_data());
 
-  auto router_location = symbol_router_.find(symbol_raw);
+  auto router_location = symbol_router_.find(symbol_id);
 
   if (router_location == symbol_router_.end()) {
-    auto cell = allocate_cell(symbol_s{symbol_raw});
+    auto cell = allocate_cell(symbol_s{symbol_id});
     cell->locator = current_location();
 
     next();
@@ -510,18 +783,7 @@ cell_ptr intake_c::parser_c::integer() {
     return nullptr;
   }
 
-  auto stringed_value = current_data();
-
-  int64_t value_actual{0};
-  try {
-    value_actual = std::stoll(stringed_value);
-  } catch (std::exception &e) {
-    error_cb_(error_c(current_location(),
-                      {"Invalid integer value: " + stringed_value}));
-    return nullptr;
-  }
-
-  auto cell = allocate_cell((int64_t)value_actual);
+  auto cell = allocate_cell(current_integer());
   cell->locator = current_location();
 
   next();
@@ -550,18 +812,7 @@ cell_ptr intake_c::parser_c::real() {
     return nullptr;
   }
 
-  auto stringed_value = current_data();
-
-  double value_actual{0.00};
-  try {
-    value_actual = std::stod(stringed_value);
-  } catch (std::exception &e) {
-    error_cb_(error_c(current_location(),
-                      {"Invalid double value: " + stringed_value}));
-    return nullptr;
-  }
-
-  auto cell = allocate_cell((double)value_actual);
+  auto cell = allocate_cell(current_real());
   cell->locator = current_location();
 
   next();
@@ -574,7 +825,7 @@ cell_ptr intake_c::parser_c::string() {
     return nullptr;
   }
 
-  auto cell = allocate_cell(current_data());
+  auto cell = allocate_cell(std::string(current_data()));
   cell->locator = current_location();
 
   next();
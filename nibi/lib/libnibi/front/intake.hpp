@@ -5,7 +5,9 @@
 #include "libnibi/interfaces/instruction_processor_if.hpp"
 #include "libnibi/source.hpp"
 #include "libnibi/types.hpp"
+#include "parse_cache.hpp"
 #include "token.hpp"
+#include <deque>
 #include <functional>
 #include <istream>
 #include <memory>
@@ -25,13 +27,22 @@ public:
   //! \param sm Source manager to use for source tracking
   //! \param router Map of symbols to their implementations
   intake_c(instruction_processor_if &processor, error_callback_f error_cb,
-           source_manager_c &sm, function_router_t &router);
+           source_manager_c &sm, const function_router_t &router);
 
   //! \brief Read from a stream
   //! \param source Name of the source
   //! \param is Stream to read from
   void read(std::string_view source, std::istream &is);
 
+  //! \brief Read a file, loading its text into the source manager
+  //!        so that it can be shown when reporting errors
+  //! \param source Path of the file
+  //! \param cache Cache to take the instructions of the file from if they
+  //!        are there, and to record them in if not
+  //! \return false if the file could not be loaded
+  bool read_file(std::string_view source,
+                 const parse_cache_c *cache = nullptr);
+
   //! \brief Read from a string
   //! \param processor Processor to use
   void read_line(std::string_view line,
@@ -47,6 +58,10 @@ public:
   //! \brief Indicate the end of a file
   void end_of_file();
 
+  //! \brief Drop whatever has been taken in of an expression that was
+  //!        not completed, or was stopped as it was executed
+  void discard_pending();
+
 private:
   /*
       Simple grammar that defines list building
@@ -60,15 +75,22 @@ private:
       list              - instruction_list | data_list | access_list
       data              - symbol | number | string | nil
       number            - integer | real | boolean
-      integer           - [-]? <digit>+
-      real              - [-]? <integer> '.' <integer> | not-a-number (NaN) |
-     inf string            - '"' <any> '"' symbol            - <any>
+      integer           - [-]? <digit>+ | [-]? '0x' <hex digit>+ |
+                          [-]? '0b' <binary digit>+
+      real              - [-]? <digit>+ '.' <digit>+ [<exponent>]? |
+                          [-]? <digit>+ <exponent> | not-a-number (NaN) | inf
+      exponent          - ('e' | 'E') ('+' | '-')? <digit>+
+      string            - '"' <any> '"'
+      symbol            - <any>
+
+      Digits of numbers may be separated by single underscores
    */
   class parser_c {
   public:
     parser_c() = delete;
-    parser_c(function_router_t &router, error_callback_f ecb)
-        : symbol_router_(router), error_cb_(ecb){};
+    parser_c(const intake_c &intake, const function_router_t &router,
+             error_callback_f ecb)
+        : intake_(intake), symbol_router_(router), error_cb_(ecb){};
     cell_ptr parse(std::vector<token_c> &tokens);
     bool has_next() { return index_ < tokens_->size(); }
     void next() {
@@ -84,13 +106,18 @@ private:
       return (*tokens_)[index_].get_token();
     }
 
-    locator_ptr current_location() { return (*tokens_)[index_].get_locator(); }
-    std::string current_data() { return (*tokens_)[index_].get_data(); }
+    locator_ptr current_location() {
+      return intake_.locate((*tokens_)[index_].get_position());
+    }
+    std::string_view current_data() { return (*tokens_)[index_].get_data(); }
+    int64_t current_integer() { return (*tokens_)[index_].get_integer(); }
+    double current_real() { return (*tokens_)[index_].get_real(); }
 
   private:
     std::size_t index_{0};
     std::vector<token_c> *tokens_{nullptr};
-    function_router_t &symbol_router_;
+    const intake_c &intake_;
+    const function_router_t &symbol_router_;
     cell_list_t current_list_;
     error_callback_f error_cb_;
 
@@ -112,9 +139,9 @@ private:
   };
 
   struct tracker_s {
-    std::stack<locator_ptr> instruction_stack_;
-    std::stack<locator_ptr> data_stack_;
-    std::stack<locator_ptr> access_stack_;
+    std::stack<position_s> instruction_stack_;
+    std::stack<position_s> data_stack_;
+    std::stack<position_s> access_stack_;
     std::size_t line_count{0};
   };
 
@@ -122,17 +149,37 @@ private:
   instruction_processor_if &processor_;
   error_callback_f error_cb_;
   source_manager_c &sm_;
-  function_router_t &symbol_router_;
+  const function_router_t &symbol_router_;
   std::vector<token_c> tokens_;
   std::unique_ptr<parser_c> parser_;
 
+  // Copies of lines that tokens of an incomplete expression were read
+  // from, for sources that don't keep their text
+  std::deque<std::string> held_lines_;
+
+  // Instructions of the file being read, to be cached once it is all read
+  std::unique_ptr<parse_cache_c::recording_c> recording_;
+
   void check_for_complete_expression();
 
+  //! \brief Make a locator for a position
+  locator_ptr locate(const position_s &position) const;
+
+  //! \brief Read a line
+  //! \param line The line
+  //! \param origin Source of the line
+  //! \param loc_override Location of the source the line was taken from
+  //! \param text_is_kept If the line is part of a source text that
+  //!        outlives the intake, tokens may be left referring to it
   bool process_line(std::string_view line,
                     std::shared_ptr<source_origin_c> origin,
-                    locator_ptr loc_override = nullptr);
+                    locator_ptr loc_override = nullptr,
+                    bool text_is_kept = false);
+
+  bool scan_line(std::string_view line, const uint32_t source,
+                 locator_ptr loc_override);
 
-  void process_token(token_c token);
+  void process_token(token_c &&token);
 };
 
 } // namespace nibi
@@ -0,0 +1,415 @@
+#include "parse_cache.hpp"
+#include "libnibi/serial.hpp"
+#include "libnibi/symbols.hpp"
+#include "libnibi/version.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <system_error>
+
+/*
+    An entry holds a header that identifies what it was made from,
+    the names of the symbols and builtins used by its instructions,
+    and then the instructions themselves. Everything is written in
+    the byte order of the machine, entries made on another are
+    rejected by the byte order mark.
+
+    header        - magic format_version byte_order_mark
+                    string(libnibi version) string(path)
+                    i64(modification time) u64(size) u64(content hash)
+                    u64(checksum)
+    names         - u32(count) string+
+    instructions  - u32(count) cell+
+    string        - u32(length) <bytes>
+    cell          - u8(tag) [u32(line) u32(column)]? <data>
+
+    The tag is the type of the cell, with its high bit set if the cell
+    has a locator. Symbols and builtins are stored as the index of their
+    name, lists as their type and count followed by their items.
+    The checksum is of everything that follows it in the entry.
+*/
+
+namespace nibi {
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'N', 'I', 'B', 'I', 'P', 'R', 'S', 'E'};
+constexpr uint32_t CACHE_FORMAT_VERSION = 2;
+constexpr uint32_t CACHE_BYTE_ORDER_MARK = 0x01020304;
+constexpr const char *CACHE_FILE_EXTENSION = ".nibic";
+
+constexpr uint8_t TAG_HAS_LOCATOR = 0x80;
+constexpr uint8_t TAG_NIL = 0;
+constexpr uint8_t TAG_INTEGER = 1;
+constexpr uint8_t TAG_DOUBLE = 2;
+constexpr uint8_t TAG_STRING = 3;
+constexpr uint8_t TAG_SYMBOL = 4;
+constexpr uint8_t TAG_BUILTIN = 5;
+constexpr uint8_t TAG_LIST = 6;
+
+// The fewest bytes taken by a name and by a cell
+constexpr std::size_t MIN_NAME_SIZE = sizeof(uint32_t);
+constexpr std::size_t MIN_CELL_SIZE = sizeof(uint8_t);
+
+struct key_s {
+  std::string path;
+  int64_t modified{0};
+  uint64_t size{0};
+  uint64_t hash{0};
+};
+
+std::optional<key_s> make_key(const std::string &path,
+                              const source_text_c &text) {
+  std::error_code ec;
+  auto absolute = std::filesystem::absolute(path, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  auto modified = std::filesystem::last_write_time(absolute, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  return key_s{absolute.lexically_normal().string(),
+               static_cast<int64_t>(modified.time_since_epoch().count()),
+               text.get_data().size(), text.get_hash()};
+}
+
+// Rebuilds the cells of instructions read from an entry
+class decoder_c {
+public:
+  decoder_c(serial_reader_c &reader, const uint32_t source,
+            const function_router_t &router)
+      : reader_(reader), source_(source), router_(router) {}
+
+  bool decode_names() {
+    uint32_t count{0};
+    if (!reader_.read_count(count, MIN_NAME_SIZE)) {
+      return false;
+    }
+    names_.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+      std::string_view name;
+      if (!reader_.read_string(name)) {
+        return false;
+      }
+      names_.push_back(intern_symbol(name));
+    }
+    return true;
+  }
+
+  cell_ptr decode() {
+    uint8_t tag{0};
+    if (!reader_.read(tag)) {
+      return nullptr;
+    }
+
+    locator_ptr locator{nullptr};
+    if (tag & TAG_HAS_LOCATOR) {
+      uint32_t line{0};
+      uint32_t column{0};
+      if (!reader_.read(line) || !reader_.read(column)) {
+        return nullptr;
+      }
+      locator = locator_c(source_, line, column);
+    }
+
+    auto cell = decode_data(tag & ~TAG_HAS_LOCATOR);
+    if (cell) {
+      cell->locator = locator;
+    }
+    return cell;
+  }
+
+private:
+  serial_reader_c &reader_;
+  uint32_t source_;
+  const function_router_t &router_;
+  std::vector<symbol_id_t> names_;
+
+  bool read_name(symbol_id_t &id) {
+    uint32_t index{0};
+    if (!reader_.read(index) || index >= names_.size()) {
+      return false;
+    }
+    id = names_[index];
+    return true;
+  }
+
+  cell_ptr decode_data(const uint8_t tag) {
+    switch (tag) {
+    case TAG_NIL:
+      return allocate_cell(cell_type_e::NIL);
+    case TAG_INTEGER: {
+      int64_t value{0};
+      return reader_.read(value) ? allocate_cell(value) : nullptr;
+    }
+    case TAG_DOUBLE: {
+      double value{0.0};
+      return reader_.read(value) ? allocate_cell(value) : nullptr;
+    }
+    case TAG_STRING: {
+      std::string_view value;
+      return reader_.read_string(value) ? allocate_cell(std::string(value))
+                                        : nullptr;
+    }
+    case TAG_SYMBOL: {
+      symbol_id_t id{0};
+      return read_name(id) ? allocate_cell(symbol_s{id}) : nullptr;
+    }
+    case TAG_BUILTIN: {
+      // Builtins are bound again, in case they have moved since
+      symbol_id_t id{0};
+      if (!read_name(id)) {
+        return nullptr;
+      }
+      auto builtin = router_.find(id);
+      if (builtin == router_.end()) {
+        return nullptr;
+      }
+      return allocate_cell(builtin->second);
+    }
+    case TAG_LIST: {
+      uint8_t type{0};
+      uint32_t count{0};
+      if (!reader_.read(type) ||
+          type > static_cast<uint8_t>(list_types_e::ACCESS) ||
+          !reader_.read_count(count, MIN_CELL_SIZE)) {
+        return nullptr;
+      }
+      cell_list_t items;
+#if CELL_LIST_USE_STD_VECTOR
+      items.reserve(count);
+#endif
+      for (uint32_t i = 0; i < count; i++) {
+        auto item = decode();
+        if (!item) {
+          return nullptr;
+        }
+        items.push_back(item);
+      }
+      return allocate_cell(
+          list_info_s{static_cast<list_types_e>(type), std::move(items)});
+    }
+    default:
+      return nullptr;
+    }
+  }
+};
+
+} // namespace
+
+void parse_cache_c::recording_c::add(cell_c &instruction) {
+  if (failed_) {
+    return;
+  }
+  if (!encode(instruction)) {
+    fail();
+    return;
+  }
+  count_++;
+}
+
+uint32_t parse_cache_c::recording_c::name_id(const std::string &name) {
+  auto it = name_ids_.find(name);
+  if (it != name_ids_.end()) {
+    return it->second;
+  }
+  auto id = static_cast<uint32_t>(name_ids_.size());
+  serial_writer_c(names_).write_string(name);
+
+  // Names are interned, so views of them stay valid
+  name_ids_.emplace(std::string_view(name), id);
+  return id;
+}
+
+bool parse_cache_c::recording_c::encode(cell_c &cell) {
+  uint8_t tag{0};
+  switch (cell.type) {
+  case cell_type_e::NIL:
+    tag = TAG_NIL;
+    break;
+  case cell_type_e::INTEGER:
+    tag = TAG_INTEGER;
+    break;
+  case cell_type_e::DOUBLE:
+    tag = TAG_DOUBLE;
+    break;
+  case cell_type_e::STRING:
+    tag = TAG_STRING;
+    break;
+  case cell_type_e::SYMBOL:
+    tag = TAG_SYMBOL;
+    break;
+  case cell_type_e::FUNCTION: {
+    // Only builtins that can be bound again by name are stored
+    auto &info = cell.as_function_info();
+    auto builtin = router_.find(intern_symbol(info.name));
+    if (builtin == router_.end() || builtin->second.fn != info.fn) {
+      return false;
+    }
+    tag = TAG_BUILTIN;
+    break;
+  }
+  case cell_type_e::LIST:
+    if (cell.read_numeric_list()) {
+      return false;
+    }
+    tag = TAG_LIST;
+    break;
+  default:
+    return false;
+  }
+
+  serial_writer_c out(instructions_);
+  if (cell.locator) {
+    out.write(static_cast<uint8_t>(tag | TAG_HAS_LOCATOR));
+    out.write(static_cast<uint32_t>(cell.locator.get_line()));
+    out.write(static_cast<uint32_t>(cell.locator.get_column()));
+  } else {
+    out.write(tag);
+  }
+
+  switch (tag) {
+  case TAG_INTEGER:
+    out.write(cell.data.i);
+    break;
+  case TAG_DOUBLE:
+    out.write(cell.data.d);
+    break;
+  case TAG_STRING:
+    out.write_string(cell.read_string());
+    break;
+  case TAG_SYMBOL:
+    out.write(name_id(cell.as_symbol()));
+    break;
+  case TAG_BUILTIN:
+    out.write(
+        name_id(symbol_name(intern_symbol(cell.as_function_info().name))));
+    break;
+  case TAG_LIST: {
+    auto &info = cell.read_list_info();
+    out.write(static_cast<uint8_t>(info.type));
+    out.write(static_cast<uint32_t>(info.list.size()));
+    for (auto &item : info.list) {
+      if (!encode(*item)) {
+        return false;
+      }
+    }
+    break;
+  }
+  }
+  return true;
+}
+
+std::filesystem::path
+parse_cache_c::entry_path(const std::string &path) const {
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx",
+                static_cast<unsigned long long>(
+                    std::hash<std::string_view>()(path)));
+  return directory_ / (std::string(name) + CACHE_FILE_EXTENSION);
+}
+
+std::optional<cell_list_t>
+parse_cache_c::load(const std::string &path, const source_text_c &text,
+                    const uint32_t source,
+                    const function_router_t &router) const {
+  auto key = make_key(path, text);
+  if (!key) {
+    return std::nullopt;
+  }
+
+  // The entry isn't split into lines, a missing one fails to load
+  auto entry = source_text_c::load(entry_path(key->path).string(), false);
+  if (!entry) {
+    return std::nullopt;
+  }
+
+  serial_reader_c reader(entry->get_data());
+  char magic[sizeof(CACHE_MAGIC)];
+  uint32_t format_version{0};
+  uint32_t byte_order_mark{0};
+  std::string_view version;
+  std::string_view entry_path;
+  key_s entry_key;
+  uint64_t checksum{0};
+  if (!reader.read(magic) ||
+      std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 ||
+      !reader.read(format_version) ||
+      format_version != CACHE_FORMAT_VERSION ||
+      !reader.read(byte_order_mark) ||
+      byte_order_mark != CACHE_BYTE_ORDER_MARK ||
+      !reader.read_string(version) || version != LIBNIBI_VERSION ||
+      !reader.read_string(entry_path) || entry_path != key->path ||
+      !reader.read(entry_key.modified) ||
+      entry_key.modified != key->modified || !reader.read(entry_key.size) ||
+      entry_key.size != key->size || !reader.read(entry_key.hash) ||
+      entry_key.hash != key->hash || !reader.read(checksum) ||
+      checksum != serial_checksum(reader.remaining())) {
+    return std::nullopt;
+  }
+
+  // Every instruction is decoded before any are handed back,
+  // so a damaged entry is never partly used
+  decoder_c decoder(reader, source, router);
+  uint32_t count{0};
+  if (!decoder.decode_names() || !reader.read_count(count, MIN_CELL_SIZE)) {
+    return std::nullopt;
+  }
+  cell_list_t instructions;
+#if CELL_LIST_USE_STD_VECTOR
+  instructions.reserve(count);
+#endif
+  for (uint32_t i = 0; i < count; i++) {
+    auto instruction = decoder.decode();
+    if (!instruction || instruction->type != cell_type_e::LIST) {
+      return std::nullopt;
+    }
+    instructions.push_back(instruction);
+  }
+  if (!reader.at_end()) {
+    return std::nullopt;
+  }
+  return {std::move(instructions)};
+}
+
+void parse_cache_c::store(const std::string &path, const source_text_c &text,
+                          const recording_c &recording) const {
+  if (recording.has_failed()) {
+    return;
+  }
+  auto key = make_key(path, text);
+  if (!key) {
+    return;
+  }
+
+  std::string entry;
+  serial_writer_c out(entry);
+  entry.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  out.write(CACHE_FORMAT_VERSION);
+  out.write(CACHE_BYTE_ORDER_MARK);
+  out.write_string(LIBNIBI_VERSION);
+  out.write_string(key->path);
+  out.write(key->modified);
+  out.write(key->size);
+  out.write(key->hash);
+
+  std::string payload;
+  serial_writer_c payload_out(payload);
+  payload_out.write(static_cast<uint32_t>(recording.name_ids_.size()));
+  payload.append(recording.names_);
+  payload_out.write(recording.count_);
+  payload.append(recording.instructions_);
+  out.write(serial_checksum(payload));
+  entry.append(payload);
+
+  std::error_code ec;
+  std::filesystem::create_directories(directory_, ec);
+  if (ec) {
+    return;
+  }
+  serial_replace_file(entry_path(key->path), entry);
+}
+
+} // namespace nibi
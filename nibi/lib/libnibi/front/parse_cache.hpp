@@ -0,0 +1,91 @@
+#pragma once
+
+#include "libnibi/cell.hpp"
+#include "libnibi/source.hpp"
+#include "libnibi/types.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace nibi {
+
+//! \brief A cache of the instructions parsed from source files, kept on
+//!        disk so that files that haven't changed aren't parsed again.
+//! \note Entries are keyed by the path of the file, and are only used
+//!       while its modification time, size and content hash, along with
+//!       the version of libnibi and of the cache format, all match what
+//!       was recorded with them. Entries are memory mapped when loaded.
+class parse_cache_c {
+public:
+  parse_cache_c() = delete;
+
+  //! \brief Create a cache.
+  //! \param directory The directory that entries are kept in, it is
+  //!        created when the first entry is stored.
+  parse_cache_c(std::filesystem::path directory)
+      : directory_(std::move(directory)) {}
+
+  //! \brief The instructions of a file, recorded as they are parsed.
+  class recording_c {
+  public:
+    recording_c() = delete;
+
+    //! \brief Create a recording.
+    //! \param router Map of symbols to their implementations, that the
+    //!        builtins in instructions are bound from.
+    recording_c(const function_router_t &router) : router_(router) {}
+
+    //! \brief Record an instruction.
+    //! \note An instruction holding something that can't be stored
+    //!       fails the recording.
+    void add(cell_c &instruction);
+    //! \brief Fail the recording, so that it isn't stored.
+    void fail() { failed_ = true; }
+    //! \brief Check if the recording has failed.
+    bool has_failed() const { return failed_; }
+
+  private:
+    friend class parse_cache_c;
+
+    const function_router_t &router_;
+    bool failed_{false};
+    uint32_t count_{0};
+    std::string names_;
+    std::string instructions_;
+    std::unordered_map<std::string_view, uint32_t> name_ids_;
+
+    bool encode(cell_c &cell);
+    uint32_t name_id(const std::string &name);
+  };
+
+  //! \brief Load the instructions cached for a file.
+  //! \param path The path of the file.
+  //! \param text The text of the file as it is now.
+  //! \param source The id of the source, for locators.
+  //! \param router Map of symbols to their implementations.
+  //! \return std::nullopt if there is no usable entry for the file.
+  std::optional<cell_list_t> load(const std::string &path,
+                                  const source_text_c &text,
+                                  const uint32_t source,
+                                  const function_router_t &router) const;
+
+  //! \brief Store the instructions recorded for a file.
+  //! \param path The path of the file.
+  //! \param text The text that the instructions were parsed from.
+  //! \param recording The recorded instructions.
+  //! \note Nothing is stored for a recording that has failed, and errors
+  //!       writing the entry are ignored, it will just be parsed again.
+  void store(const std::string &path, const source_text_c &text,
+             const recording_c &recording) const;
+
+private:
+  std::filesystem::path directory_;
+
+  std::filesystem::path entry_path(const std::string &path) const;
+};
+
+} // namespace nibi
@@ -1,11 +1,13 @@
 #pragma once
 
 #include "libnibi/source.hpp"
+#include <cstdint>
 #include <memory>
+#include <string_view>
 
 namespace nibi {
 
-enum class token_e {
+enum class token_e : uint8_t {
   NIL,
   TRUE,
   FALSE,
@@ -23,31 +25,91 @@ enum class token_e {
   SYMBOL,
 };
 
+//! \brief Where a token is within a source.
+//! \note The source is the id that it is registered with, so that a
+//!       locator can be made for the token if one is needed.
+struct position_s {
+  uint32_t source{0};
+  uint32_t line{0};
+  uint32_t column{0};
+};
+
 //! \brief A token.
+//! \note The text of a token is a view of the source that it was read
+//!       from, so the source must outlive the token.
 class token_c {
 public:
   //! \brief Create a token.
-  //! \param locator The locator interface.
+  //! \param position Where the token is.
   //! \param token The token value.
-  token_c(locator_ptr locator, const token_e token)
-      : locator_(locator), token_(token) {}
+  token_c(const position_s &position, const token_e token)
+      : position_(position), token_(token) {
+    value_.integer = 0;
+  }
   //! \brief Create a token.
-  //! \param locator The locator interface.
+  //! \param position Where the token is.
+  //! \param token The token value.
+  //! \param data The text of the token.
+  token_c(const position_s &position, const token_e token,
+          std::string_view data)
+      : position_(position), token_(token) {
+    value_.text = {data.data(), data.size()};
+  }
+  //! \brief Create a token holding an integer.
+  //! \param position Where the token is.
+  //! \param token The token value.
+  //! \param integer The integer scanned for the token.
+  token_c(const position_s &position, const token_e token,
+          const int64_t integer)
+      : position_(position), token_(token) {
+    value_.integer = integer;
+  }
+  //! \brief Create a token holding a real number.
+  //! \param position Where the token is.
   //! \param token The token value.
-  //! \param data The data associated with the token.
-  token_c(locator_ptr locator, const token_e token, const std::string &data)
-      : locator_(locator), token_(token), data_(data) {}
+  //! \param real The real number scanned for the token.
+  token_c(const position_s &position, const token_e token, const double real)
+      : position_(position), token_(token) {
+    value_.real = real;
+  }
   //! \brief Get the token value.
   const token_e get_token() const { return token_; }
-  //! \brief Get the locator interface.
-  const locator_ptr get_locator() const { return locator_; }
-  //! \brief Get the data associated with the token.
-  const std::string get_data() const { return data_; }
+  //! \brief Get where the token is.
+  const position_s &get_position() const { return position_; }
+  //! \brief Check if the token has text.
+  bool has_data() const {
+    return token_ == token_e::SYMBOL || token_ == token_e::RAW_STRING;
+  }
+  //! \brief Get the text of the token.
+  std::string_view get_data() const {
+    return has_data() ? std::string_view(value_.text.data, value_.text.size)
+                      : std::string_view();
+  }
+  //! \brief Point the text of the token at another copy of the source.
+  //! \param from The source that the text is in now.
+  //! \param to The copy of the source.
+  void move_data(std::string_view from, const char *to) {
+    if (has_data() && value_.text.data >= from.data() &&
+        value_.text.data < from.data() + from.size()) {
+      value_.text.data = to + (value_.text.data - from.data());
+    }
+  }
+  //! \brief Get the integer held by the token.
+  int64_t get_integer() const { return value_.integer; }
+  //! \brief Get the real number held by the token.
+  double get_real() const { return value_.real; }
 
 private:
-  locator_ptr locator_{nullptr};
+  position_s position_;
   token_e token_{token_e::NIL};
-  std::string data_{""};
+  union {
+    int64_t integer;
+    double real;
+    struct {
+      const char *data;
+      std::size_t size;
+    } text;
+  } value_;
 };
 
 extern const char *token_to_string(const token_c &token);
@@ -2,10 +2,19 @@
 
 #include "libnibi/cell.hpp"
 #include "libnibi/environment.hpp"
+#include "libnibi/types.hpp"
 
 namespace nibi {
 
 //! \brief Process a cell and return the value
+//! \note  A processor, and every cell and environment it works with, must
+//!        be created, used, and destroyed on a single thread. Cells are
+//!        allocated from pools local to a thread and their references are
+//!        not counted atomically, so they can not be handed to a processor
+//!        on another thread, only copied out of them beforehand.
+//!        Separate processors on separate threads share nothing but the
+//!        symbol table, which is safe to use from any thread, so any
+//!        number of them can run at once
 class cell_processor_if {
 public:
   virtual ~cell_processor_if() = default;
@@ -19,6 +28,27 @@ public:
   virtual cell_ptr process_cell(cell_ptr instruction, env_c &env,
                                 const bool process_data_cell = false) = 0;
 
+  //! \brief Execute a single instruction, producing a value
+  //! \param instruction The instruction to execute
+  //! \param env The environment that will be used during execution
+  //! \param out The value that the result will be stored in
+  //! \param process_data_cell If true, a data list [] will be iterated and each
+  //! item processed
+  //! \note Numeric results are left unboxed, so this should be preferred
+  //!       over process_cell when the result is consumed immediately
+  virtual void process_value(const cell_ptr &instruction, env_c &env,
+                             value_s &out,
+                             const bool process_data_cell = false) = 0;
+
+  //! \brief Execute a lambda function
+  //! \param function The lambda function to execute
+  //! \param list The list the function is called from, with the
+  //!        arguments following the function
+  //! \param env The environment that the arguments will be processed in
+  //! \return The result of the lambda
+  virtual cell_ptr execute_lambda(const cell_ptr &function, cell_list_t &list,
+                                  env_c &env) = 0;
+
   //! \brief Check if the interpreter is yielding a value
   virtual bool is_yielding() = 0;
 
@@ -42,6 +72,17 @@ public:
   //! \brief Load a module
   //! \param module_name The name of the module to load
   virtual void load_module(cell_ptr &module_name) = 0;
+
+  //! \brief Get the options that the processor was created with
+  virtual const interpreter_options_s &get_options() = 0;
+
+  //! \brief Get the platform used to locate files and modules
+  //! \return The platform given in the options, or the global platform
+  virtual platform_c *get_platform() = 0;
+
+  //! \brief Stop execution with an exit code
+  //! \note  Unless the processor is contained this ends the process
+  [[noreturn]] virtual void request_exit(int64_t code) = 0;
 };
 
 } // namespace nibi
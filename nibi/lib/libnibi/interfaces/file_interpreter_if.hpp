@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <optional>
 
 namespace nibi {
 
@@ -14,6 +16,25 @@ public:
 
   //! \brief Indicate that interpretation is complete.
   virtual void indicate_complete() = 0;
+
+  //! \brief Get the code given to `exit`, if a contained interpreter
+  //!        was stopped by it.
+  virtual std::optional<int64_t> get_exit_code() = 0;
+
+  //! \brief Save a snapshot of the environment, after interpreting a file.
+  //! \param snapshot The file to save the snapshot to.
+  //! \param file The file that was interpreted.
+  //! \return false if the snapshot could not be saved.
+  virtual bool save_snapshot(std::filesystem::path snapshot,
+                             std::filesystem::path file) = 0;
+
+  //! \brief Restore a snapshot of the environment in place of interpreting
+  //!        a file, if nothing that went into it has changed.
+  //! \param snapshot The file that the snapshot was saved to.
+  //! \param file The file that the snapshot must have been made from.
+  //! \return false if the file should be interpreted instead.
+  virtual bool restore_snapshot(std::filesystem::path snapshot,
+                                std::filesystem::path file) = 0;
 };
 
 } // namespace nibi
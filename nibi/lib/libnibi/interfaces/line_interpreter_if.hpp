@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
 namespace nibi {
@@ -14,6 +16,10 @@ public:
 
   //! \brief Get the result of the last line interpreted.
   virtual std::string get_result() = 0;
+
+  //! \brief Get the code given to `exit`, if a contained interpreter
+  //!        was stopped by it.
+  virtual std::optional<int64_t> get_exit_code() = 0;
 };
 
 } // namespace nibi
@@ -14,90 +14,146 @@ namespace nibi {
 namespace builtins {
 
 #define PERFORM_OPERATION(___op_fn)                                            \
-  auto first_arg = ci.process_cell(list[1], env);                              \
-  switch (first_arg->type) {                                                   \
+  switch (first_arg.type) {                                                    \
   case cell_type_e::INTEGER: {                                                 \
-    return allocate_cell(___op_fn<int64_t>(                                    \
-        first_arg->to_integer(), ci,                                           \
-        [](cell_ptr arg) -> int64_t { return arg->to_integer(); }, list,       \
-        env));                                                                 \
+    out.set(___op_fn<int64_t>(first_arg.i, list, args));                       \
+    return;                                                                    \
   }                                                                            \
   case cell_type_e::DOUBLE: {                                                  \
-    return allocate_cell(___op_fn<double>(                                     \
-        first_arg->to_double(), ci,                                            \
-        [](cell_ptr arg) -> double { return arg->to_double(); }, list, env));  \
+    out.set(___op_fn<double>(first_arg.d, list, args));                        \
+    return;                                                                    \
   }                                                                            \
   default: {                                                                   \
     std::string msg = "Incorrect argument type for arithmetic function: ";     \
-    msg += cell_type_to_string(first_arg->type);                               \
+    msg += cell_type_to_string(first_arg.type);                                \
     throw interpreter_c::exception_c(msg, list[0]->locator);                   \
     break;                                                                     \
   }                                                                            \
+  }
+
+// Declare the value function that loads arguments from the list as they are
+// needed, and the apply function used by bytecode that is handed arguments
+// that have already been evaluated
+#define ARITHMETIC_VALUE_FN(___name, ___kw)                                    \
+  void builtin_value_arithmetic_##___name(cell_processor_if &ci,               \
+                                          cell_list_t &list, env_c &env,       \
+                                          value_s &out) {                      \
+    NIBI_LIST_ENFORCE_SIZE(___kw, >=, 2)                                       \
+    value_s first_arg;                                                         \
+    ci.process_value(list[1], env, first_arg);                                 \
+    perform_##___name(first_arg, list, NIBI_LIST_ARGUMENT_LOADER, out);        \
   }                                                                            \
-  return allocate_cell(cell_type_e::NIL);
+  void builtin_apply_arithmetic_##___name(value_s *args, cell_list_t &list,    \
+                                          value_s &out) {                      \
+    NIBI_LIST_ENFORCE_SIZE(___kw, >=, 2)                                       \
+    perform_##___name(args[0], list, NIBI_VALUE_ARGUMENT_LOADER, out);         \
+  }
 
-cell_ptr builtin_fn_arithmetic_add(cell_processor_if &ci, cell_list_t &list,
-                                   env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::ADD, >=, 2)
+namespace {
+
+template <typename Args>
+inline void perform_add(value_s &first_arg, cell_list_t &list, Args &&args,
+                        value_s &out) {
+  if (first_arg.type == cell_type_e::STRING) {
+    std::string accumulate{first_arg.to_string()};
+    for (std::size_t n = 2; n < list.size(); n++) {
+      accumulate += args(n).to_string();
+    }
+    out.set(allocate_cell(accumulate));
+    return;
+  }
+  PERFORM_OPERATION(list_perform_add)
+}
+
+template <typename Args>
+inline void perform_sub(value_s &first_arg, cell_list_t &list, Args &&args,
+                        value_s &out) {
+  PERFORM_OPERATION(list_perform_sub)
+}
+
+template <typename Args>
+inline void perform_div(value_s &first_arg, cell_list_t &list, Args &&args,
+                        value_s &out) {
+  PERFORM_OPERATION(list_perform_div)
+}
 
-  auto first_item = ci.process_cell(list[1], env);
-  if (first_item->type == cell_type_e::STRING) {
-    std::string accumulate{first_item->to_string()};
-    NIBI_LIST_ITER_AND_LOAD_SKIP_N(2, { accumulate += arg->to_string(); })
-    return allocate_cell(accumulate);
+template <typename Args>
+inline void perform_mul(value_s &first_arg, cell_list_t &list, Args &&args,
+                        value_s &out) {
+  if (first_arg.type == cell_type_e::STRING) {
+    std::string accumulate{first_arg.to_string()};
+    for (std::size_t n = 2; n < list.size(); n++) {
+      int64_t times = args(n).to_integer() - 1;
+      for (int64_t i = 0; i < times; i++)
+        accumulate += first_arg.to_string();
+    }
+    out.set(allocate_cell(accumulate));
+    return;
+  }
+  PERFORM_OPERATION(list_perform_mul)
+}
+
+template <typename Args>
+inline void perform_mod(value_s &first_arg, cell_list_t &list, Args &&args,
+                        value_s &out) {
+  if (first_arg.type == cell_type_e::DOUBLE) {
+    double accumulate{first_arg.to_double()};
+    for (std::size_t n = 2; n < list.size(); n++) {
+      accumulate = std::fmod(accumulate, args(n).to_double());
+    }
+    out.set(accumulate);
   } else {
-    PERFORM_OPERATION(list_perform_add)
+    int64_t accumulate{first_arg.to_integer()};
+    for (std::size_t n = 2; n < list.size(); n++) {
+      accumulate %= args(n).to_integer();
+    }
+    out.set(accumulate);
   }
 }
 
+template <typename Args>
+inline void perform_pow(value_s &first_arg, cell_list_t &list, Args &&args,
+                        value_s &out) {
+  PERFORM_OPERATION(list_perform_pow)
+}
+
+} // namespace
+
+ARITHMETIC_VALUE_FN(add, nibi::kw::ADD)
+ARITHMETIC_VALUE_FN(sub, nibi::kw::SUB)
+ARITHMETIC_VALUE_FN(div, nibi::kw::DIV)
+ARITHMETIC_VALUE_FN(mul, nibi::kw::MUL)
+ARITHMETIC_VALUE_FN(mod, nibi::kw::MOD)
+ARITHMETIC_VALUE_FN(pow, nibi::kw::POW)
+
+cell_ptr builtin_fn_arithmetic_add(cell_processor_if &ci, cell_list_t &list,
+                                   env_c &env) {
+  BOX_VALUE_FN(builtin_value_arithmetic_add)
+}
+
 cell_ptr builtin_fn_arithmetic_sub(cell_processor_if &ci, cell_list_t &list,
-                                   env_c &env){
-    NIBI_LIST_ENFORCE_SIZE(nibi::kw::SUB, >=, 2)
-        PERFORM_OPERATION(list_perform_sub)}
+                                   env_c &env) {
+  BOX_VALUE_FN(builtin_value_arithmetic_sub)
+}
 
 cell_ptr builtin_fn_arithmetic_div(cell_processor_if &ci, cell_list_t &list,
-                                   env_c &env){
-    NIBI_LIST_ENFORCE_SIZE(nibi::kw::SUB, >=, 2)
-        PERFORM_OPERATION(list_perform_div)}
+                                   env_c &env) {
+  BOX_VALUE_FN(builtin_value_arithmetic_div)
+}
 
 cell_ptr builtin_fn_arithmetic_mul(cell_processor_if &ci, cell_list_t &list,
                                    env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::MUL, >=, 2)
-
-  auto first_item = ci.process_cell(list[1], env);
-  if (first_item->type == cell_type_e::STRING) {
-    std::string accumulate{first_item->to_string()};
-    NIBI_LIST_ITER_AND_LOAD_SKIP_N(2, {
-      int64_t times = arg->to_integer() - 1;
-      for (int64_t i = 0; i < times; i++)
-        accumulate += first_item->to_string();
-    })
-    return allocate_cell(accumulate);
-  } else {
-    PERFORM_OPERATION(list_perform_mul)
-  }
+  BOX_VALUE_FN(builtin_value_arithmetic_mul)
 }
 
 cell_ptr builtin_fn_arithmetic_mod(cell_processor_if &ci, cell_list_t &list,
                                    env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::MOD, >=, 2)
-  auto first_arg = ci.process_cell(list[1], env);
-  if (first_arg->type == cell_type_e::DOUBLE) {
-    double accumulate{first_arg->to_double()};
-    NIBI_LIST_ITER_AND_LOAD_SKIP_N(
-        2, { accumulate = std::fmod(accumulate, arg->to_double()); })
-    return allocate_cell(accumulate);
-  } else {
-    int64_t accumulate{first_arg->to_integer()};
-    NIBI_LIST_ITER_AND_LOAD_SKIP_N(2, { accumulate %= arg->to_integer(); })
-    return allocate_cell(accumulate);
-  }
+  BOX_VALUE_FN(builtin_value_arithmetic_mod)
 }
 
 cell_ptr builtin_fn_arithmetic_pow(cell_processor_if &ci, cell_list_t &list,
                                    env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::POW, >=, 2)
-  PERFORM_OPERATION(list_perform_pow)
+  BOX_VALUE_FN(builtin_value_arithmetic_pow)
 }
 
 } // namespace builtins
@@ -6,65 +6,100 @@
 
 namespace nibi {
 
-template <typename T>
-static inline T list_perform_add(T base_value, cell_processor_if &ci,
-                                 std::function<T(cell_ptr)> conversion_method,
-                                 cell_list_t &list, env_c &env) {
+// Builtins that produce numeric results are implemented as value functions
+// so nested instructions can be carried out without boxing intermediate
+// results. The cell function is only used when the result escapes
+#define BOX_VALUE_FN(___value_fn)                                              \
+  value_s result;                                                              \
+  ___value_fn(ci, list, env, result);                                          \
+  return result.box(list.front()->locator);
+
+template <typename T> static inline T value_as(value_s &value);
+
+template <> inline int64_t value_as<int64_t>(value_s &value) {
+  return value.to_integer();
+}
+
+template <> inline double value_as<double>(value_s &value) {
+  return value.to_double();
+}
+
+// Arithmetic is carried out over arguments produced by an argument loader,
+// where `args(n)` yields the value of list[n]. Builtins load arguments from
+// the list as they are needed, while bytecode hands over values that have
+// already been evaluated
+#define NIBI_LIST_ARGUMENT_LOADER                                              \
+  [&ci, &list, &env](const std::size_t n) {                                    \
+    value_s arg;                                                               \
+    ci.process_value(list[n], env, arg);                                       \
+    return arg;                                                                \
+  }
+
+#define NIBI_VALUE_ARGUMENT_LOADER                                             \
+  [args](const std::size_t n) -> value_s & { return args[n - 1]; }
+
+template <typename T, typename Args>
+static inline T list_perform_add(T base_value, cell_list_t &list,
+                                 Args &&args) {
   T accumulate{base_value};
-  NIBI_LIST_ITER_AND_LOAD_SKIP_N(
-      2, { accumulate += conversion_method(std::move(arg)); })
+  for (std::size_t n = 2; n < list.size(); n++) {
+    auto &&arg = args(n);
+    accumulate += value_as<T>(arg);
+  }
   return accumulate;
 }
 
-template <typename T>
-static inline T list_perform_sub(T base_value, cell_processor_if &ci,
-                                 std::function<T(cell_ptr)> conversion_method,
-                                 cell_list_t &list, env_c &env) {
+template <typename T, typename Args>
+static inline T list_perform_sub(T base_value, cell_list_t &list,
+                                 Args &&args) {
   T accumulate{base_value};
 
   if (list.size() == 2) {
-    return 0 - conversion_method(ci.process_cell(list[1], env));
+    return 0 - base_value;
   }
 
-  NIBI_LIST_ITER_AND_LOAD_SKIP_N(
-      2, { accumulate -= conversion_method(std::move(arg)); })
+  for (std::size_t n = 2; n < list.size(); n++) {
+    auto &&arg = args(n);
+    accumulate -= value_as<T>(arg);
+  }
   return accumulate;
 }
 
-template <typename T>
-static inline T list_perform_div(T base_value, cell_processor_if &ci,
-                                 std::function<T(cell_ptr)> conversion_method,
-                                 cell_list_t &list, env_c &env) {
+template <typename T, typename Args>
+static inline T list_perform_div(T base_value, cell_list_t &list,
+                                 Args &&args) {
   T accumulate{base_value};
-  NIBI_LIST_ITER_AND_LOAD_SKIP_N(2, {
-    auto r = conversion_method(std::move(arg));
+  for (std::size_t n = 2; n < list.size(); n++) {
+    auto &&arg = args(n);
+    auto r = value_as<T>(arg);
     if (r == 0) {
-      throw interpreter_c::exception_c("Division by zero", arg->locator);
+      throw interpreter_c::exception_c("Division by zero", list[n]->locator);
       return accumulate;
     }
     accumulate /= r;
-  })
+  }
   return accumulate;
 }
 
-template <typename T>
-static inline T list_perform_mul(T base_value, cell_processor_if &ci,
-                                 std::function<T(cell_ptr)> conversion_method,
-                                 cell_list_t &list, env_c &env) {
+template <typename T, typename Args>
+static inline T list_perform_mul(T base_value, cell_list_t &list,
+                                 Args &&args) {
   T accumulate{base_value};
-  NIBI_LIST_ITER_AND_LOAD_SKIP_N(
-      2, { accumulate *= conversion_method(std::move(arg)); })
+  for (std::size_t n = 2; n < list.size(); n++) {
+    auto &&arg = args(n);
+    accumulate *= value_as<T>(arg);
+  }
   return accumulate;
 }
 
-template <typename T>
-static inline T list_perform_pow(T base_value, cell_processor_if &ci,
-                                 std::function<T(cell_ptr)> conversion_method,
-                                 cell_list_t &list, env_c &env) {
+template <typename T, typename Args>
+static inline T list_perform_pow(T base_value, cell_list_t &list,
+                                 Args &&args) {
   T accumulate{base_value};
-  NIBI_LIST_ITER_AND_LOAD_SKIP_N(2, {
-    accumulate = std::pow(accumulate, conversion_method(std::move(arg)));
-  })
+  for (std::size_t n = 2; n < list.size(); n++) {
+    auto &&arg = args(n);
+    accumulate = std::pow(accumulate, value_as<T>(arg));
+  }
   return accumulate;
 }
 
@@ -15,22 +15,28 @@ namespace builtins {
 // arithmetic
 static function_info_s builtin_add_inf = {
     nibi::kw::ADD, builtin_fn_arithmetic_add,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_arithmetic_add, builtin_apply_arithmetic_add};
 static function_info_s builtin_sub_inf = {
     nibi::kw::SUB, builtin_fn_arithmetic_sub,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_arithmetic_sub, builtin_apply_arithmetic_sub};
 static function_info_s builtin_div_inf = {
     nibi::kw::DIV, builtin_fn_arithmetic_div,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_arithmetic_div, builtin_apply_arithmetic_div};
 static function_info_s builtin_mul_inf = {
     nibi::kw::MUL, builtin_fn_arithmetic_mul,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_arithmetic_mul, builtin_apply_arithmetic_mul};
 static function_info_s builtin_mod_inf = {
     nibi::kw::MOD, builtin_fn_arithmetic_mod,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_arithmetic_mod, builtin_apply_arithmetic_mod};
 static function_info_s builtin_pow_inf = {
     nibi::kw::POW, builtin_fn_arithmetic_pow,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_arithmetic_pow, builtin_apply_arithmetic_pow};
 
 // bitwise
 static function_info_s builtin_bitwise_lsh_inf = {
@@ -52,6 +58,35 @@ static function_info_s builtin_bitwise_not_inf = {
     nibi::kw::BW_NOT, builtin_fn_bitwise_not,
     function_type_e::BUILTIN_CPP_FUNCTION};
 
+// vector
+static function_info_s builtin_vector_add_inf = {
+    nibi::kw::VEC_ADD, builtin_fn_vector_add,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_vector_sub_inf = {
+    nibi::kw::VEC_SUB, builtin_fn_vector_sub,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_vector_mul_inf = {
+    nibi::kw::VEC_MUL, builtin_fn_vector_mul,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_vector_div_inf = {
+    nibi::kw::VEC_DIV, builtin_fn_vector_div,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_vector_scale_inf = {
+    nibi::kw::VEC_SCALE, builtin_fn_vector_scale,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_vector_dot_inf = {
+    nibi::kw::VEC_DOT, builtin_fn_vector_dot,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_vector_sum_inf = {
+    nibi::kw::VEC_SUM, builtin_fn_vector_sum,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_vector_min_inf = {
+    nibi::kw::VEC_MIN, builtin_fn_vector_min,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_vector_max_inf = {
+    nibi::kw::VEC_MAX, builtin_fn_vector_max,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+
 // environment
 static function_info_s builtin_assignment_inf = {
     nibi::kw::ASSIGN, builtin_fn_env_assignment,
@@ -81,31 +116,40 @@ static function_info_s builtin_assert_inf = {
 // comparison
 static function_info_s builtin_comparison_eq_inf = {
     nibi::kw::EQ, builtin_fn_comparison_eq,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_comparison_eq, builtin_apply_comparison_eq};
 static function_info_s builtin_comparison_neq_inf = {
     nibi::kw::NEQ, builtin_fn_comparison_neq,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_comparison_neq, builtin_apply_comparison_neq};
 static function_info_s builtin_comparison_lt_inf = {
     nibi::kw::LT, builtin_fn_comparison_lt,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_comparison_lt, builtin_apply_comparison_lt};
 static function_info_s builtin_comparison_gt_inf = {
     nibi::kw::GT, builtin_fn_comparison_gt,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_comparison_gt, builtin_apply_comparison_gt};
 static function_info_s builtin_comparison_lte_inf = {
     nibi::kw::LTE, builtin_fn_comparison_lte,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_comparison_lte, builtin_apply_comparison_lte};
 static function_info_s builtin_comparison_gte_inf = {
     nibi::kw::GTE, builtin_fn_comparison_gte,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_comparison_gte, builtin_apply_comparison_gte};
 static function_info_s builtin_comparison_and_inf = {
     nibi::kw::AND, builtin_fn_comparison_and,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_comparison_and, builtin_apply_comparison_and};
 static function_info_s builtin_comparison_or_inf = {
     nibi::kw::OR, builtin_fn_comparison_or,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_comparison_or, builtin_apply_comparison_or};
 static function_info_s builtin_comparison_not_inf = {
     nibi::kw::NOT, builtin_fn_comparison_not,
-    function_type_e::BUILTIN_CPP_FUNCTION};
+    function_type_e::BUILTIN_CPP_FUNCTION, nullptr,
+    builtin_value_comparison_not, builtin_apply_comparison_not};
 
 // lists
 static function_info_s builtin_list_push_front_inf = {
@@ -120,8 +164,54 @@ static function_info_s builtin_list_spawn_inf = {
 static function_info_s builtin_list_iter_inf = {
     nibi::kw::ITER, builtin_fn_list_iter,
     function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_list_parallel_iter_inf = {
+    nibi::kw::PITER, builtin_fn_list_parallel_iter,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_list_parallel_map_inf = {
+    nibi::kw::PMAP, builtin_fn_list_parallel_map,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+
+// tasks and channels
+static function_info_s builtin_task_spawn_inf = {
+    nibi::kw::TASK, builtin_fn_task_spawn,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_task_join_inf = {
+    nibi::kw::TASK_JOIN, builtin_fn_task_join,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_chan_create_inf = {
+    nibi::kw::CHAN, builtin_fn_chan_create,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_chan_send_inf = {
+    nibi::kw::CHAN_SEND, builtin_fn_chan_send,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_chan_recv_inf = {
+    nibi::kw::CHAN_RECV, builtin_fn_chan_recv,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_chan_close_inf = {
+    nibi::kw::CHAN_CLOSE, builtin_fn_chan_close,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+
+// generators
+static function_info_s builtin_gen_create_inf = {
+    nibi::kw::GEN, builtin_fn_gen_create,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_gen_emit_inf = {
+    nibi::kw::EMIT, builtin_fn_gen_emit, function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_gen_next_inf = {
+    nibi::kw::GEN_NEXT, builtin_fn_gen_next,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_gen_take_inf = {
+    nibi::kw::GEN_TAKE, builtin_fn_gen_take,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_gen_map_inf = {
+    nibi::kw::GEN_MAP, builtin_fn_gen_map,
+    function_type_e::BUILTIN_CPP_FUNCTION};
+static function_info_s builtin_gen_filter_inf = {
+    nibi::kw::GEN_FILTER, builtin_fn_gen_filter,
+    function_type_e::BUILTIN_CPP_FUNCTION};
 static function_info_s builtin_list_at_inf = {
-    nibi::kw::AT, builtin_fn_list_at, function_type_e::BUILTIN_CPP_FUNCTION};
+    nibi::kw::AT, builtin_fn_list_at, function_type_e::BUILTIN_CPP_FUNCTION,
+    nullptr, builtin_value_list_at};
 static function_info_s builtin_list_pop_front_inf = {
     nibi::kw::POP_FRONT, builtin_fn_list_pop_front,
     function_type_e::BUILTIN_CPP_FUNCTION};
@@ -163,7 +253,7 @@ static function_info_s builtin_common_nop_inf = {
     nibi::kw::NOP, builtin_fn_common_nop,
     function_type_e::BUILTIN_CPP_FUNCTION};
 static function_info_s builtin_common_macro_inf = {
-    nibi::kw::NOP, builtin_fn_common_macro,
+    nibi::kw::MACRO, builtin_fn_common_macro,
     function_type_e::BUILTIN_CPP_FUNCTION};
 
 // conversion functions
@@ -194,64 +284,100 @@ static function_info_s builtin_extern_call_inf = {
     function_type_e::BUILTIN_CPP_FUNCTION};
 
 // This map is used to look up the function info struct for a given symbol
-static function_router_t keyword_map = {
-    {nibi::kw::EQ, builtin_comparison_eq_inf},
-    {nibi::kw::NEQ, builtin_comparison_neq_inf},
-    {nibi::kw::LT, builtin_comparison_lt_inf},
-    {nibi::kw::GT, builtin_comparison_gt_inf},
-    {nibi::kw::LTE, builtin_comparison_lte_inf},
-    {nibi::kw::GTE, builtin_comparison_gte_inf},
-    {nibi::kw::AND, builtin_comparison_and_inf},
-    {nibi::kw::OR, builtin_comparison_or_inf},
-    {nibi::kw::NOT, builtin_comparison_not_inf},
-    {nibi::kw::ADD, builtin_add_inf},
-    {nibi::kw::SUB, builtin_sub_inf},
-    {nibi::kw::DIV, builtin_div_inf},
-    {nibi::kw::MUL, builtin_mul_inf},
-    {nibi::kw::MOD, builtin_mod_inf},
-    {nibi::kw::POW, builtin_pow_inf},
-    {nibi::kw::ASSIGN, builtin_assignment_inf},
-    {nibi::kw::SET, builtin_set_inf},
-    {nibi::kw::FN, builtin_fn_inf},
-    {nibi::kw::DICT, builtin_dict_inf},
-    {nibi::kw::DROP, builtin_drop_inf},
-    {nibi::kw::TRY, builtin_try_inf},
-    {nibi::kw::THROW, builtin_throw_inf},
-    {nibi::kw::ASSERT, builtin_assert_inf},
-    {nibi::kw::PUSH_FRONT, builtin_list_push_front_inf},
-    {nibi::kw::PUSH_BACK, builtin_list_push_back_inf},
-    {nibi::kw::POP_FRONT, builtin_list_pop_front_inf},
-    {nibi::kw::POP_BACK, builtin_list_pop_back_inf},
-    {nibi::kw::SPAWN, builtin_list_spawn_inf},
-    {nibi::kw::ITER, builtin_list_iter_inf},
-    {nibi::kw::AT, builtin_list_at_inf},
-    {nibi::kw::LEN, builtin_common_len_inf},
-    {nibi::kw::YIELD, builtin_common_yield_inf},
-    {nibi::kw::LOOP, builtin_common_loop_inf},
-    {nibi::kw::IF, builtin_common_if_inf},
-    {nibi::kw::CLONE, builtin_common_clone_inf},
-    {nibi::kw::IMPORT, builtin_common_import_inf},
-    {nibi::kw::USE, builtin_common_use_inf},
-    {nibi::kw::EXIT, builtin_common_exit_inf},
-    {nibi::kw::EVAL, builtin_common_eval_inf},
-    {nibi::kw::QUOTE, builtin_common_quote_inf},
-    {nibi::kw::NOP, builtin_common_nop_inf},
-    {nibi::kw::MACRO, builtin_common_macro_inf},
-    {nibi::kw::BW_LSH, builtin_bitwise_lsh_inf},
-    {nibi::kw::BW_RSH, builtin_bitwise_rsh_inf},
-    {nibi::kw::BW_AND, builtin_bitwise_and_inf},
-    {nibi::kw::BW_OR, builtin_bitwise_or_inf},
-    {nibi::kw::BW_XOR, builtin_bitwise_xor_inf},
-    {nibi::kw::BW_NOT, builtin_bitwise_not_inf},
-    {nibi::kw::STR, builtin_cvt_string_inf},
-    {nibi::kw::INT, builtin_cvt_int_inf},
-    {nibi::kw::FLOAT, builtin_cvt_float_inf},
-    {nibi::kw::SPLIT, builtin_cvt_split_inf},
-    {nibi::kw::TYPE, builtin_reflect_type_inf},
-    {nibi::kw::EXTERN_CALL, builtin_extern_call_inf}};
+static const function_router_t keyword_map = {
+    {intern_symbol(nibi::kw::EQ), builtin_comparison_eq_inf},
+    {intern_symbol(nibi::kw::NEQ), builtin_comparison_neq_inf},
+    {intern_symbol(nibi::kw::LT), builtin_comparison_lt_inf},
+    {intern_symbol(nibi::kw::GT), builtin_comparison_gt_inf},
+    {intern_symbol(nibi::kw::LTE), builtin_comparison_lte_inf},
+    {intern_symbol(nibi::kw::GTE), builtin_comparison_gte_inf},
+    {intern_symbol(nibi::kw::AND), builtin_comparison_and_inf},
+    {intern_symbol(nibi::kw::OR), builtin_comparison_or_inf},
+    {intern_symbol(nibi::kw::NOT), builtin_comparison_not_inf},
+    {intern_symbol(nibi::kw::ADD), builtin_add_inf},
+    {intern_symbol(nibi::kw::SUB), builtin_sub_inf},
+    {intern_symbol(nibi::kw::DIV), builtin_div_inf},
+    {intern_symbol(nibi::kw::MUL), builtin_mul_inf},
+    {intern_symbol(nibi::kw::MOD), builtin_mod_inf},
+    {intern_symbol(nibi::kw::POW), builtin_pow_inf},
+    {intern_symbol(nibi::kw::ASSIGN), builtin_assignment_inf},
+    {intern_symbol(nibi::kw::SET), builtin_set_inf},
+    {intern_symbol(nibi::kw::FN), builtin_fn_inf},
+    {intern_symbol(nibi::kw::DICT), builtin_dict_inf},
+    {intern_symbol(nibi::kw::DROP), builtin_drop_inf},
+    {intern_symbol(nibi::kw::TRY), builtin_try_inf},
+    {intern_symbol(nibi::kw::THROW), builtin_throw_inf},
+    {intern_symbol(nibi::kw::ASSERT), builtin_assert_inf},
+    {intern_symbol(nibi::kw::PUSH_FRONT), builtin_list_push_front_inf},
+    {intern_symbol(nibi::kw::PUSH_BACK), builtin_list_push_back_inf},
+    {intern_symbol(nibi::kw::POP_FRONT), builtin_list_pop_front_inf},
+    {intern_symbol(nibi::kw::POP_BACK), builtin_list_pop_back_inf},
+    {intern_symbol(nibi::kw::SPAWN), builtin_list_spawn_inf},
+    {intern_symbol(nibi::kw::ITER), builtin_list_iter_inf},
+    {intern_symbol(nibi::kw::PITER), builtin_list_parallel_iter_inf},
+    {intern_symbol(nibi::kw::PMAP), builtin_list_parallel_map_inf},
+    {intern_symbol(nibi::kw::TASK), builtin_task_spawn_inf},
+    {intern_symbol(nibi::kw::TASK_JOIN), builtin_task_join_inf},
+    {intern_symbol(nibi::kw::CHAN), builtin_chan_create_inf},
+    {intern_symbol(nibi::kw::CHAN_SEND), builtin_chan_send_inf},
+    {intern_symbol(nibi::kw::CHAN_RECV), builtin_chan_recv_inf},
+    {intern_symbol(nibi::kw::CHAN_CLOSE), builtin_chan_close_inf},
+    {intern_symbol(nibi::kw::GEN), builtin_gen_create_inf},
+    {intern_symbol(nibi::kw::EMIT), builtin_gen_emit_inf},
+    {intern_symbol(nibi::kw::GEN_NEXT), builtin_gen_next_inf},
+    {intern_symbol(nibi::kw::GEN_TAKE), builtin_gen_take_inf},
+    {intern_symbol(nibi::kw::GEN_MAP), builtin_gen_map_inf},
+    {intern_symbol(nibi::kw::GEN_FILTER), builtin_gen_filter_inf},
+    {intern_symbol(nibi::kw::AT), builtin_list_at_inf},
+    {intern_symbol(nibi::kw::LEN), builtin_common_len_inf},
+    {intern_symbol(nibi::kw::YIELD), builtin_common_yield_inf},
+    {intern_symbol(nibi::kw::LOOP), builtin_common_loop_inf},
+    {intern_symbol(nibi::kw::IF), builtin_common_if_inf},
+    {intern_symbol(nibi::kw::CLONE), builtin_common_clone_inf},
+    {intern_symbol(nibi::kw::IMPORT), builtin_common_import_inf},
+    {intern_symbol(nibi::kw::USE), builtin_common_use_inf},
+    {intern_symbol(nibi::kw::EXIT), builtin_common_exit_inf},
+    {intern_symbol(nibi::kw::EVAL), builtin_common_eval_inf},
+    {intern_symbol(nibi::kw::QUOTE), builtin_common_quote_inf},
+    {intern_symbol(nibi::kw::NOP), builtin_common_nop_inf},
+    {intern_symbol(nibi::kw::MACRO), builtin_common_macro_inf},
+    {intern_symbol(nibi::kw::BW_LSH), builtin_bitwise_lsh_inf},
+    {intern_symbol(nibi::kw::BW_RSH), builtin_bitwise_rsh_inf},
+    {intern_symbol(nibi::kw::BW_AND), builtin_bitwise_and_inf},
+    {intern_symbol(nibi::kw::BW_OR), builtin_bitwise_or_inf},
+    {intern_symbol(nibi::kw::BW_XOR), builtin_bitwise_xor_inf},
+    {intern_symbol(nibi::kw::BW_NOT), builtin_bitwise_not_inf},
+    {intern_symbol(nibi::kw::VEC_ADD), builtin_vector_add_inf},
+    {intern_symbol(nibi::kw::VEC_SUB), builtin_vector_sub_inf},
+    {intern_symbol(nibi::kw::VEC_MUL), builtin_vector_mul_inf},
+    {intern_symbol(nibi::kw::VEC_DIV), builtin_vector_div_inf},
+    {intern_symbol(nibi::kw::VEC_SCALE), builtin_vector_scale_inf},
+    {intern_symbol(nibi::kw::VEC_DOT), builtin_vector_dot_inf},
+    {intern_symbol(nibi::kw::VEC_SUM), builtin_vector_sum_inf},
+    {intern_symbol(nibi::kw::VEC_MIN), builtin_vector_min_inf},
+    {intern_symbol(nibi::kw::VEC_MAX), builtin_vector_max_inf},
+    {intern_symbol(nibi::kw::STR), builtin_cvt_string_inf},
+    {intern_symbol(nibi::kw::INT), builtin_cvt_int_inf},
+    {intern_symbol(nibi::kw::FLOAT), builtin_cvt_float_inf},
+    {intern_symbol(nibi::kw::SPLIT), builtin_cvt_split_inf},
+    {intern_symbol(nibi::kw::TYPE), builtin_reflect_type_inf},
+    {intern_symbol(nibi::kw::EXTERN_CALL), builtin_extern_call_inf}};
 
 // Retrieve the map of symbols to function info structs
-function_router_t &get_builtin_symbols_map() { return keyword_map; }
+const function_router_t &get_builtin_symbols_map() { return keyword_map; }
+
+// Functions called by the faux functions that builtins make
+extern cell_ptr handle_dict_access(cell_processor_if &ci, cell_list_t &list,
+                                   env_c &env);
+extern cell_ptr assemble_macro(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env);
+
+cell_fn_t get_faux_function(const std::string &name) {
+  static const std::unordered_map<std::string, cell_fn_t> faux_map = {
+      {"dict", handle_dict_access}, {"assemble_macro", assemble_macro}};
+  auto it = faux_map.find(name);
+  return it != faux_map.end() ? it->second : nullptr;
+}
 
 } // namespace builtins
 } // namespace nibi
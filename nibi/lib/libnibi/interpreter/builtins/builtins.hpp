@@ -13,7 +13,15 @@ namespace builtins {
 
 //! \brief Retrieve a reference to a map that ties symbols to their
 //!        corresponding builtin function.
-function_router_t &get_builtin_symbols_map();
+//! \note  The map is never modified, so it can be shared by interpreters
+//!        on any number of threads
+const function_router_t &get_builtin_symbols_map();
+
+//! \brief Get the function called by faux functions of a given name,
+//!        which are made by builtins rather than bound to keywords
+//! \param name The name of the faux function
+//! \return nullptr if no faux function has the name
+extern cell_fn_t get_faux_function(const std::string &name);
 
 //! \brief A function similar to the builtins that
 //!        will load a lambda function and execute it
@@ -23,6 +31,15 @@ function_router_t &get_builtin_symbols_map();
 extern cell_ptr execute_suspected_lambda(cell_processor_if &ci,
                                          cell_list_t &list, env_c &env);
 
+//! \brief Mark the calls that a lambda body ends with, so that
+//!        the interpreter can make them in place of the lambda
+//! \param body The body of the lambda
+extern void mark_tail_calls(cell_ptr &body);
+
+//! \brief Check if a lambda body defines functions anywhere within it
+//! \param body The body of the lambda
+extern bool defines_functions(const cell_ptr &body);
+
 // Environment modification functions
 
 extern cell_ptr builtin_fn_env_assignment(cell_processor_if &ci,
@@ -51,6 +68,36 @@ extern cell_ptr builtin_fn_list_push_back(cell_processor_if &ci,
                                           cell_list_t &list, env_c &env);
 extern cell_ptr builtin_fn_list_iter(cell_processor_if &ci, cell_list_t &list,
                                      env_c &env);
+extern cell_ptr builtin_fn_list_parallel_iter(cell_processor_if &ci,
+                                              cell_list_t &list, env_c &env);
+extern cell_ptr builtin_fn_list_parallel_map(cell_processor_if &ci,
+                                             cell_list_t &list, env_c &env);
+
+// Tasks and channels
+extern cell_ptr builtin_fn_task_spawn(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
+extern cell_ptr builtin_fn_task_join(cell_processor_if &ci, cell_list_t &list,
+                                     env_c &env);
+extern cell_ptr builtin_fn_chan_create(cell_processor_if &ci,
+                                       cell_list_t &list, env_c &env);
+extern cell_ptr builtin_fn_chan_send(cell_processor_if &ci, cell_list_t &list,
+                                     env_c &env);
+extern cell_ptr builtin_fn_chan_recv(cell_processor_if &ci, cell_list_t &list,
+                                     env_c &env);
+extern cell_ptr builtin_fn_chan_close(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
+extern cell_ptr builtin_fn_gen_create(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
+extern cell_ptr builtin_fn_gen_emit(cell_processor_if &ci, cell_list_t &list,
+                                    env_c &env);
+extern cell_ptr builtin_fn_gen_next(cell_processor_if &ci, cell_list_t &list,
+                                    env_c &env);
+extern cell_ptr builtin_fn_gen_take(cell_processor_if &ci, cell_list_t &list,
+                                    env_c &env);
+extern cell_ptr builtin_fn_gen_map(cell_processor_if &ci, cell_list_t &list,
+                                   env_c &env);
+extern cell_ptr builtin_fn_gen_filter(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
 extern cell_ptr builtin_fn_list_at(cell_processor_if &ci, cell_list_t &list,
                                    env_c &env);
 extern cell_ptr builtin_fn_list_spawn(cell_processor_if &ci, cell_list_t &list,
@@ -60,6 +107,19 @@ extern cell_ptr builtin_fn_list_pop_front(cell_processor_if &ci,
 extern cell_ptr builtin_fn_list_pop_back(cell_processor_if &ci,
                                          cell_list_t &list, env_c &env);
 
+// List value functions
+
+extern void builtin_value_list_at(cell_processor_if &ci, cell_list_t &list,
+                                  env_c &env, value_s &out);
+
+//! \brief Set the item of a list that an `at` instruction refers to
+//! \param list The `at` instruction
+//! \param value_cell The cell holding the value to set the item to
+//! \note  Numbers held unboxed by a list have no cell for `set` to
+//!        update, so they are set through the list instead
+extern cell_ptr set_list_item(cell_processor_if &ci, cell_list_t &list,
+                              cell_ptr &value_cell, env_c &env);
+
 // Common functions
 
 extern cell_ptr builtin_fn_common_clone(cell_processor_if &ci,
@@ -107,6 +167,42 @@ extern cell_ptr builtin_fn_arithmetic_mod(cell_processor_if &ci,
 extern cell_ptr builtin_fn_arithmetic_pow(cell_processor_if &ci,
                                           cell_list_t &list, env_c &env);
 
+// Arithmetic value functions
+
+extern void builtin_value_arithmetic_add(cell_processor_if &ci,
+                                         cell_list_t &list, env_c &env,
+                                         value_s &out);
+extern void builtin_value_arithmetic_sub(cell_processor_if &ci,
+                                         cell_list_t &list, env_c &env,
+                                         value_s &out);
+extern void builtin_value_arithmetic_div(cell_processor_if &ci,
+                                         cell_list_t &list, env_c &env,
+                                         value_s &out);
+extern void builtin_value_arithmetic_mul(cell_processor_if &ci,
+                                         cell_list_t &list, env_c &env,
+                                         value_s &out);
+extern void builtin_value_arithmetic_mod(cell_processor_if &ci,
+                                         cell_list_t &list, env_c &env,
+                                         value_s &out);
+extern void builtin_value_arithmetic_pow(cell_processor_if &ci,
+                                         cell_list_t &list, env_c &env,
+                                         value_s &out);
+
+// Arithmetic apply functions
+
+extern void builtin_apply_arithmetic_add(value_s *args, cell_list_t &list,
+                                         value_s &out);
+extern void builtin_apply_arithmetic_sub(value_s *args, cell_list_t &list,
+                                         value_s &out);
+extern void builtin_apply_arithmetic_div(value_s *args, cell_list_t &list,
+                                         value_s &out);
+extern void builtin_apply_arithmetic_mul(value_s *args, cell_list_t &list,
+                                         value_s &out);
+extern void builtin_apply_arithmetic_mod(value_s *args, cell_list_t &list,
+                                         value_s &out);
+extern void builtin_apply_arithmetic_pow(value_s *args, cell_list_t &list,
+                                         value_s &out);
+
 // Bitwise functions
 
 extern cell_ptr builtin_fn_bitwise_lsh(cell_processor_if &ci, cell_list_t &list,
@@ -122,6 +218,27 @@ extern cell_ptr builtin_fn_bitwise_xor(cell_processor_if &ci, cell_list_t &list,
 extern cell_ptr builtin_fn_bitwise_not(cell_processor_if &ci, cell_list_t &list,
                                        env_c &env);
 
+// Vector functions
+
+extern cell_ptr builtin_fn_vector_add(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
+extern cell_ptr builtin_fn_vector_sub(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
+extern cell_ptr builtin_fn_vector_mul(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
+extern cell_ptr builtin_fn_vector_div(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
+extern cell_ptr builtin_fn_vector_scale(cell_processor_if &ci,
+                                        cell_list_t &list, env_c &env);
+extern cell_ptr builtin_fn_vector_dot(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
+extern cell_ptr builtin_fn_vector_sum(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
+extern cell_ptr builtin_fn_vector_min(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
+extern cell_ptr builtin_fn_vector_max(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env);
+
 // Comparison functions
 
 extern cell_ptr builtin_fn_comparison_eq(cell_processor_if &ci,
@@ -143,6 +260,57 @@ extern cell_ptr builtin_fn_comparison_or(cell_processor_if &ci,
 extern cell_ptr builtin_fn_comparison_not(cell_processor_if &ci,
                                           cell_list_t &list, env_c &env);
 
+// Comparison value functions
+
+extern void builtin_value_comparison_eq(cell_processor_if &ci,
+                                        cell_list_t &list, env_c &env,
+                                        value_s &out);
+extern void builtin_value_comparison_neq(cell_processor_if &ci,
+                                         cell_list_t &list, env_c &env,
+                                         value_s &out);
+extern void builtin_value_comparison_lt(cell_processor_if &ci,
+                                        cell_list_t &list, env_c &env,
+                                        value_s &out);
+extern void builtin_value_comparison_gt(cell_processor_if &ci,
+                                        cell_list_t &list, env_c &env,
+                                        value_s &out);
+extern void builtin_value_comparison_lte(cell_processor_if &ci,
+                                         cell_list_t &list, env_c &env,
+                                         value_s &out);
+extern void builtin_value_comparison_gte(cell_processor_if &ci,
+                                         cell_list_t &list, env_c &env,
+                                         value_s &out);
+extern void builtin_value_comparison_and(cell_processor_if &ci,
+                                         cell_list_t &list, env_c &env,
+                                         value_s &out);
+extern void builtin_value_comparison_or(cell_processor_if &ci,
+                                        cell_list_t &list, env_c &env,
+                                        value_s &out);
+extern void builtin_value_comparison_not(cell_processor_if &ci,
+                                         cell_list_t &list, env_c &env,
+                                         value_s &out);
+
+// Comparison apply functions
+
+extern void builtin_apply_comparison_eq(value_s *args, cell_list_t &list,
+                                       value_s &out);
+extern void builtin_apply_comparison_neq(value_s *args, cell_list_t &list,
+                                       value_s &out);
+extern void builtin_apply_comparison_lt(value_s *args, cell_list_t &list,
+                                       value_s &out);
+extern void builtin_apply_comparison_gt(value_s *args, cell_list_t &list,
+                                       value_s &out);
+extern void builtin_apply_comparison_lte(value_s *args, cell_list_t &list,
+                                       value_s &out);
+extern void builtin_apply_comparison_gte(value_s *args, cell_list_t &list,
+                                       value_s &out);
+extern void builtin_apply_comparison_and(value_s *args, cell_list_t &list,
+                                       value_s &out);
+extern void builtin_apply_comparison_or(value_s *args, cell_list_t &list,
+                                       value_s &out);
+extern void builtin_apply_comparison_not(value_s *args, cell_list_t &list,
+                                       value_s &out);
+
 // Conversion functions
 
 extern cell_ptr builtin_fn_cvt_to_string(cell_processor_if &ci,
@@ -33,7 +33,11 @@ cell_ptr builtin_fn_common_len(cell_processor_if &ci, cell_list_t &list,
     return allocate_cell((int64_t)(target_list->to_string(false).size()));
   }
 
-  auto &list_info = target_list->as_list_info();
+  if (auto *numbers = target_list->read_numeric_list()) {
+    return allocate_cell((int64_t)numbers->size());
+  }
+
+  auto &list_info = target_list->read_list_info();
   return allocate_cell((int64_t)list_info.list.size());
 }
 
@@ -76,10 +80,11 @@ cell_ptr builtin_fn_common_loop(cell_processor_if &ci, cell_list_t &list,
   ci.process_cell(pre_condition, loop_env);
 
   cell_ptr result = allocate_cell(cell_type_e::NIL);
+  value_s condition_result;
   while (true) {
-    auto condition_result = ci.process_cell(condition, loop_env);
+    ci.process_value(condition, loop_env, condition_result);
 
-    if (condition_result->to_integer() <= 0) {
+    if (condition_result.to_integer() <= 0) {
       return result;
     }
 
@@ -109,9 +114,16 @@ cell_ptr builtin_fn_common_if(cell_processor_if &ci, cell_list_t &list,
 
   auto if_env = env_c(&env);
 
-  auto condition_result = ci.process_cell(condition, if_env);
+  value_s condition_result;
+  ci.process_value(condition, if_env, condition_result);
+
+  // Only integers are accepted as conditions, so anything else
+  // is boxed to raise the appropriate access error
+  if (condition_result.type != cell_type_e::INTEGER) {
+    condition_result.box(condition->locator)->as_integer();
+  }
 
-  if (condition_result->as_integer() > 0) {
+  if (condition_result.i > 0) {
     return ci.process_cell(true_condition, if_env, true);
   }
 
@@ -149,7 +161,7 @@ cell_ptr builtin_fn_common_import(cell_processor_if &ci, cell_list_t &list,
     auto target = std::filesystem::path((*it)->as_string());
 
     // Locate the item
-    auto item = global_platform->locate_file(target, from);
+    auto item = ci.get_platform()->locate_file(target, from);
 
     if (!item.has_value()) {
       throw interpreter_c::exception_c("Could not locate file for import: " +
@@ -159,7 +171,7 @@ cell_ptr builtin_fn_common_import(cell_processor_if &ci, cell_list_t &list,
 
     // Check that the item hasn't already been imported
     if (!gsm.exists((*item).string())) {
-      file_interpreter_c(error_callback, ci.get_env(), gsm)
+      file_interpreter_c(error_callback, ci.get_env(), gsm, ci.get_options())
           .interpret_file((*item).string());
     }
     std::advance(it, 1);
@@ -187,7 +199,10 @@ cell_ptr builtin_fn_common_exit(cell_processor_if &ci, cell_list_t &list,
   NIBI_LIST_ENFORCE_SIZE(nibi::kw::EXIT, ==, 2)
   auto it = list.begin();
   std::advance(it, 1);
-  std::exit(ci.process_cell((*it), env)->as_integer());
+  ci.request_exit(ci.process_cell((*it), env)->as_integer());
+
+  // Not reached, exits either end the process or are raised
+  return allocate_cell(cell_type_e::NIL);
 }
 
 cell_ptr builtin_fn_common_quote(cell_processor_if &ci, cell_list_t &list,
@@ -208,7 +223,7 @@ cell_ptr builtin_fn_common_eval(cell_processor_if &ci, cell_list_t &list,
 
   auto so = sm.get_source(list[0]->locator->get_source_name());
 
-  interpreter_c eval_ci(env, sm);
+  interpreter_c eval_ci(env, sm, ci.get_options());
 
   intake_c(
       eval_ci,
@@ -229,7 +244,7 @@ cell_ptr builtin_fn_common_nop(cell_processor_if &ci, cell_list_t &list,
 
 cell_ptr assemble_macro(cell_processor_if &ci, cell_list_t &list, env_c &env) {
 
-  auto definition = env.get(list[0]->as_symbol());
+  auto definition = env.get(list[0]->as_symbol_id());
   auto macro_env = definition->as_function_info().operating_env;
   auto macro_params = macro_env->get("$params")->as_list_info();
   auto macro_body = macro_env->get("$body")->as_string();
@@ -13,28 +13,20 @@ namespace nibi {
   {                                                                            \
     switch (target_type) {                                                     \
     case cell_type_e::INTEGER: {                                               \
-      auto r =                                                                 \
-          allocate_cell((int64_t)(lhs.as_integer() ___op rhs.to_integer()));   \
-      r->locator = locator;                                                    \
-      return std::move(r);                                                     \
+      out.set((int64_t)(lhs.i ___op rhs.to_integer()));                        \
+      return;                                                                  \
     }                                                                          \
     case cell_type_e::DOUBLE: {                                                \
-      auto r =                                                                 \
-          allocate_cell((int64_t)(lhs.as_double() ___op rhs.to_double()));     \
-      r->locator = locator;                                                    \
-      return std::move(r);                                                     \
+      out.set((int64_t)(lhs.d ___op rhs.to_double()));                         \
+      return;                                                                  \
     }                                                                          \
     case cell_type_e::STRING: {                                                \
-      auto r =                                                                 \
-          allocate_cell((int64_t)(lhs.as_string() ___op rhs.to_string()));     \
-      r->locator = locator;                                                    \
-      return std::move(r);                                                     \
+      out.set((int64_t)(lhs.cell->read_string() ___op rhs.to_string()));       \
+      return;                                                                  \
     }                                                                          \
     default: {                                                                 \
-      auto r =                                                                 \
-          allocate_cell((int64_t)(lhs.to_string() ___op rhs.to_string()));     \
-      r->locator = locator;                                                    \
-      return std::move(r);                                                     \
+      out.set((int64_t)(lhs.to_string() ___op rhs.to_string()));               \
+      return;                                                                  \
     }                                                                          \
     }                                                                          \
   }
@@ -43,22 +35,18 @@ namespace nibi {
   {                                                                            \
     switch (target_type) {                                                     \
     case cell_type_e::INTEGER: {                                               \
-      auto r =                                                                 \
-          allocate_cell((int64_t)(lhs.as_integer() ___op rhs.to_integer()));   \
-      r->locator = locator;                                                    \
-      return std::move(r);                                                     \
+      out.set((int64_t)(lhs.i ___op rhs.to_integer()));                        \
+      return;                                                                  \
     }                                                                          \
     case cell_type_e::DOUBLE: {                                                \
-      auto r =                                                                 \
-          allocate_cell((int64_t)(lhs.as_double() ___op rhs.to_double()));     \
-      r->locator = locator;                                                    \
-      return std::move(r);                                                     \
+      out.set((int64_t)(lhs.d ___op rhs.to_double()));                         \
+      return;                                                                  \
     }                                                                          \
     default:                                                                   \
       throw interpreter_c::exception_c(                                        \
           "Expected numeric value, got " +                                     \
               std::string(cell_type_to_string(lhs.type)),                      \
-          lhs.locator);                                                        \
+          lhs.cell->locator);                                                  \
     }                                                                          \
   }
 
@@ -76,20 +64,20 @@ enum class op_e {
   OR,
 };
 
-cell_ptr perform_op(locator_ptr locator, op_e op, cell_c &lhs, cell_c &rhs,
-                    bool enforce_numeric = true) {
+void perform_op(op_e op, value_s &lhs, value_s &rhs, value_s &out,
+                bool enforce_numeric = true) {
   if (enforce_numeric) {
     if (!lhs.is_numeric()) {
       throw interpreter_c::exception_c(
           "Expected numeric value, got " +
               std::string(cell_type_to_string(lhs.type)),
-          lhs.locator);
+          lhs.cell->locator);
     }
     if (!rhs.is_numeric()) {
       throw interpreter_c::exception_c(
           "Expected numeric value, got " +
               std::string(cell_type_to_string(rhs.type)),
-          rhs.locator);
+          rhs.cell->locator);
     }
   }
 
@@ -113,77 +101,59 @@ cell_ptr perform_op(locator_ptr locator, op_e op, cell_c &lhs, cell_c &rhs,
     PERFORM_OP_NO_STRING(||)
   }
 
-  throw interpreter_c::exception_c("Unknown comparison operator", lhs.locator);
+  throw interpreter_c::exception_c("Unknown comparison operator");
 }
 } // namespace
 
-cell_ptr builtin_fn_comparison_eq(cell_processor_if &ci, cell_list_t &list,
-                                  env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::EQ, ==, 3)
-  return std::move(perform_op(list.front()->locator, op_e::EQ,
-                              *ci.process_cell(list[1], env),
-                              *ci.process_cell(list[2], env), false));
-}
-cell_ptr builtin_fn_comparison_neq(cell_processor_if &ci, cell_list_t &list,
-                                   env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::NEQ, ==, 3)
-  return std::move(perform_op(list.front()->locator, op_e::NEQ,
-                              *ci.process_cell(list[1], env),
-                              *ci.process_cell(list[2], env), false));
-}
-cell_ptr builtin_fn_comparison_lt(cell_processor_if &ci, cell_list_t &list,
-                                  env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::LT, ==, 3)
-  return std::move(perform_op(list.front()->locator, op_e::LT,
-                              *ci.process_cell(list[1], env),
-                              *ci.process_cell(list[2], env)));
-}
-cell_ptr builtin_fn_comparison_gt(cell_processor_if &ci, cell_list_t &list,
-                                  env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::GT, ==, 3)
-  return std::move(perform_op(list.front()->locator, op_e::GT,
-                              *ci.process_cell(list[1], env),
-                              *ci.process_cell(list[2], env)));
-}
-cell_ptr builtin_fn_comparison_lte(cell_processor_if &ci, cell_list_t &list,
-                                   env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::LTE, ==, 3)
-  return std::move(perform_op(list.front()->locator, op_e::LTE,
-                              *ci.process_cell(list[1], env),
-                              *ci.process_cell(list[2], env)));
-}
-cell_ptr builtin_fn_comparison_gte(cell_processor_if &ci, cell_list_t &list,
-                                   env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::GTE, ==, 3)
-  return std::move(perform_op(list.front()->locator, op_e::GTE,
-                              *ci.process_cell(list[1], env),
-                              *ci.process_cell(list[2], env)));
-}
-cell_ptr builtin_fn_comparison_and(cell_processor_if &ci, cell_list_t &list,
-                                   env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::AND, ==, 3)
-  return std::move(perform_op(list.front()->locator, op_e::AND,
-                              *ci.process_cell(list[1], env),
-                              *ci.process_cell(list[2], env)));
+#define COMPARISON_VALUE_FN(___name, ___kw, ___op, ___enforce_numeric)        \
+  void builtin_value_comparison_##___name(cell_processor_if &ci,               \
+                                          cell_list_t &list, env_c &env,       \
+                                          value_s &out) {                      \
+    NIBI_LIST_ENFORCE_SIZE(___kw, ==, 3)                                       \
+    value_s lhs;                                                               \
+    ci.process_value(list[1], env, lhs);                                       \
+    value_s rhs;                                                               \
+    ci.process_value(list[2], env, rhs);                                       \
+    perform_op(___op, lhs, rhs, out, ___enforce_numeric);                      \
+  }                                                                            \
+  void builtin_apply_comparison_##___name(value_s *args, cell_list_t &list,    \
+                                          value_s &out) {                      \
+    NIBI_LIST_ENFORCE_SIZE(___kw, ==, 3)                                       \
+    perform_op(___op, args[0], args[1], out, ___enforce_numeric);              \
+  }                                                                            \
+  cell_ptr builtin_fn_comparison_##___name(cell_processor_if &ci,              \
+                                           cell_list_t &list, env_c &env) {    \
+    BOX_VALUE_FN(builtin_value_comparison_##___name)                           \
+  }
+
+COMPARISON_VALUE_FN(eq, nibi::kw::EQ, op_e::EQ, false)
+COMPARISON_VALUE_FN(neq, nibi::kw::NEQ, op_e::NEQ, false)
+COMPARISON_VALUE_FN(lt, nibi::kw::LT, op_e::LT, true)
+COMPARISON_VALUE_FN(gt, nibi::kw::GT, op_e::GT, true)
+COMPARISON_VALUE_FN(lte, nibi::kw::LTE, op_e::LTE, true)
+COMPARISON_VALUE_FN(gte, nibi::kw::GTE, op_e::GTE, true)
+COMPARISON_VALUE_FN(and, nibi::kw::AND, op_e::AND, true)
+COMPARISON_VALUE_FN(or, nibi::kw::OR, op_e::OR, true)
+
+void builtin_value_comparison_not(cell_processor_if &ci, cell_list_t &list,
+                                  env_c &env, value_s &out) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::NOT, ==, 2)
+  auto it = list.begin();
+  std::advance(it, 1);
+  value_s item_to_negate;
+  ci.process_value(*it, env, item_to_negate, true);
+  out.set((int64_t)(!item_to_negate.to_integer()));
 }
-cell_ptr builtin_fn_comparison_or(cell_processor_if &ci, cell_list_t &list,
-                                  env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::OR, ==, 3)
-  return std::move(perform_op(list.front()->locator, op_e::OR,
-                              *ci.process_cell(list[1], env),
-                              *ci.process_cell(list[2], env)));
+
+void builtin_apply_comparison_not(value_s *args, cell_list_t &list,
+                                  value_s &out) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::NOT, ==, 2)
+  out.set((int64_t)(!args[0].to_integer()));
 }
 
 cell_ptr builtin_fn_comparison_not(cell_processor_if &ci, cell_list_t &list,
                                    env_c &env) {
-  NIBI_LIST_ENFORCE_SIZE(nibi::kw::NOT, ==, 2)
-  auto it = list.begin();
-  std::advance(it, 1);
-  auto item_to_negate = ci.process_cell(*it, env, true);
-  auto value = item_to_negate->to_integer();
-  auto result = allocate_cell((int64_t)(!value));
-  result->locator = list[0]->locator;
-  return std::move(result);
+  BOX_VALUE_FN(builtin_value_comparison_not)
 }
 
 } // namespace builtins
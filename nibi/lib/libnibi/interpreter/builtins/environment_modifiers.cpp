@@ -24,22 +24,26 @@ cell_ptr builtin_fn_env_assignment(cell_processor_if &ci, cell_list_t &list,
         "Expected symbol as first argument to assign", (*it)->locator);
   }
 
-  auto &target_variable_name = (*it)->as_string();
+  auto target_variable = (*it)->as_symbol_id();
+  auto &target_variable_name = symbol_name(target_variable);
 
   if (target_variable_name[0] == '$' || target_variable_name[0] == ':') {
     throw interpreter_c::exception_c(
         "Cannot assign to a variable starting with '$' or ':'", (*it)->locator);
   }
 
-  auto target_assignment_value = ci.process_cell(list[2], env);
-  // ci.process_cell(ci.process_cell(list[2], env), env);
+  value_s assignment_value;
+  ci.process_value(list[2], env, assignment_value);
 
-  // Explicitly clone the value as we might be reading from
-  // an instruction that will be mutated later
+  // Numeric values are boxed fresh, anything else is explicitly cloned
+  // as we might be reading from an instruction that will be mutated later.
+  // Values that were cloned before only have their data shared
+  auto target_assignment_value =
+      assignment_value.is_numeric()
+          ? assignment_value.box(list[2]->locator)
+          : assignment_value.cell->clone(env);
 
-  target_assignment_value = target_assignment_value->clone(env);
-
-  env.set(target_variable_name, target_assignment_value);
+  env.set(target_variable, target_assignment_value);
 
   // Return a pointer to the new cell so assignments can be chained
   return target_assignment_value;
@@ -50,14 +54,25 @@ cell_ptr builtin_fn_env_set(cell_processor_if &ci, cell_list_t &list,
 
   NIBI_LIST_ENFORCE_SIZE(nibi::kw::SET, ==, 3)
 
+  // Items of lists are set through the list, as they may not have a cell
+  if (list[1]->type == cell_type_e::LIST) {
+    auto &target_info = list[1]->data.list->value;
+    if (target_info.type == list_types_e::INSTRUCTION &&
+        !target_info.list.empty() &&
+        target_info.list.front()->type == cell_type_e::FUNCTION &&
+        target_info.list.front()->data.fn->fn == builtin_fn_list_at) {
+      return set_list_item(ci, target_info.list, list[2], env);
+    }
+  }
+
   auto target_assignment_cell = ci.process_cell(list[1], env);
   // ci.process_cell(ci.process_cell(list[1], env), env);
 
-  auto target_assignment_value = ci.process_cell(list[2], env);
-  // ci.process_cell(ci.process_cell(list[2], env), env);
+  value_s target_assignment_value;
+  ci.process_value(list[2], env, target_assignment_value);
 
   // Then update that cell directly
-  target_assignment_cell->update_from(*target_assignment_value, env);
+  target_assignment_cell->update_from(target_assignment_value, env);
 
   return target_assignment_cell;
 }
@@ -67,7 +82,7 @@ cell_ptr builtin_fn_env_drop(cell_processor_if &ci, cell_list_t &list,
   NIBI_LIST_ENFORCE_SIZE(nibi::kw::DROP, >=, 2)
 
   for (auto it = std::next(list.begin()); it != list.end(); ++it) {
-    if (!env.drop((*it)->as_symbol())) {
+    if (!env.drop((*it)->as_symbol_id())) {
       throw interpreter_c::exception_c("Could not find symbol with name :" +
                                            (*it)->as_symbol(),
                                        (*it)->locator);
@@ -76,6 +91,20 @@ cell_ptr builtin_fn_env_drop(cell_processor_if &ci, cell_list_t &list,
   return allocate_cell((int64_t)0);
 }
 
+namespace {
+// The arguments of a lambda are held in slots of the environment
+// that its body runs in, in the order that they are given
+std::shared_ptr<const env_layout_t>
+resolve_argument_layout(list_info_s &function_argument_list) {
+  auto layout = std::make_shared<env_layout_t>();
+  layout->reserve(function_argument_list.list.size());
+  for (auto &&arg : function_argument_list.list) {
+    layout->push_back(arg->as_symbol_id());
+  }
+  return layout;
+}
+} // namespace
+
 cell_ptr assemble_anonymous_function(cell_processor_if &ci, cell_list_t &list,
                                      env_c &env) {
   auto it = list.begin();
@@ -90,12 +119,7 @@ cell_ptr assemble_anonymous_function(cell_processor_if &ci, cell_list_t &list,
   }
 
   lambda_info_s lambda_info;
-
-  lambda_info.arg_names.reserve(function_argument_list.list.size());
-
-  for (auto &&arg : function_argument_list.list) {
-    lambda_info.arg_names.push_back(arg->as_symbol());
-  }
+  lambda_info.arg_names = resolve_argument_layout(function_argument_list);
 
   std::advance(it, 1);
   lambda_info.body = (*it);
@@ -103,12 +127,18 @@ cell_ptr assemble_anonymous_function(cell_processor_if &ci, cell_list_t &list,
     throw interpreter_c::exception_c("Expected list for function body",
                                      lambda_info.body->locator);
   }
+  mark_tail_calls(lambda_info.body);
+  lambda_info.defines_functions = defines_functions(lambda_info.body);
 
   function_info_s function_info("anon_fn", execute_suspected_lambda,
                                 function_type_e::LAMBDA_FUNCTION, &env);
 
   function_info.lambda = {lambda_info};
 
+  // Defined within a call that is kept alive for as long as its
+  // functions are, which is the only way an environment is shared
+  function_info.captured_env = env.weak_from_this().lock();
+
   auto fn_cell = allocate_cell(function_info);
   fn_cell->locator = list[0]->locator;
 
@@ -127,7 +157,8 @@ cell_ptr builtin_fn_env_fn(cell_processor_if &ci, cell_list_t &list,
 
   std::advance(it, 1);
 
-  auto target_function_name = (*it)->as_symbol();
+  auto target_function = (*it)->as_symbol_id();
+  auto &target_function_name = symbol_name(target_function);
 
   std::advance(it, 1);
 
@@ -139,12 +170,7 @@ cell_ptr builtin_fn_env_fn(cell_processor_if &ci, cell_list_t &list,
   }
 
   lambda_info_s lambda_info;
-
-  lambda_info.arg_names.reserve(function_argument_list.list.size());
-
-  for (auto &&arg : function_argument_list.list) {
-    lambda_info.arg_names.push_back(arg->as_symbol());
-  }
+  lambda_info.arg_names = resolve_argument_layout(function_argument_list);
 
   std::advance(it, 1);
   lambda_info.body = (*it);
@@ -152,17 +178,23 @@ cell_ptr builtin_fn_env_fn(cell_processor_if &ci, cell_list_t &list,
     throw interpreter_c::exception_c("Expected list for function body",
                                      lambda_info.body->locator);
   }
+  mark_tail_calls(lambda_info.body);
+  lambda_info.defines_functions = defines_functions(lambda_info.body);
 
   function_info_s function_info(target_function_name, execute_suspected_lambda,
                                 function_type_e::LAMBDA_FUNCTION, &env);
 
   function_info.lambda = {lambda_info};
 
+  // Defined within a call that is kept alive for as long as its
+  // functions are, which is the only way an environment is shared
+  function_info.captured_env = env.weak_from_this().lock();
+
   auto fn_cell = allocate_cell(function_info);
   fn_cell->locator = list[0]->locator;
 
   // Set the variable
-  env.set(target_function_name, fn_cell);
+  env.set(target_function, fn_cell);
 
   return std::move(fn_cell);
 }
@@ -173,11 +205,12 @@ cell_ptr handle_dict_access(cell_processor_if &ci, cell_list_t &list,
   auto definition = list[0];
 
   if (definition->type == cell_type_e::SYMBOL) {
-    definition = env.get(definition->as_symbol());
+    definition = env.get(definition->as_symbol_id());
   }
 
-  auto fn_info = definition->as_function_info();
-  auto dict = fn_info.operating_env->get("$data");
+  static const auto data_symbol = intern_symbol("$data");
+
+  auto dict = definition->as_function_info().operating_env->get(data_symbol);
 
   // If its just the item then we will load and string the dict
   if (list.size() == 1) {
@@ -188,7 +221,7 @@ cell_ptr handle_dict_access(cell_processor_if &ci, cell_list_t &list,
 
   NIBI_LIST_ENFORCE_SIZE(nibi::kw::DICT, >=, 2)
 
-  auto command = list[1]->as_symbol();
+  auto &command = list[1]->as_symbol();
 
   auto &dict_value = dict->as_dict();
 
@@ -49,16 +49,20 @@ cell_ptr builtin_fn_except_try(cell_processor_if &ci, cell_list_t &list,
   std::advance(it, 1);
   auto recover_cell = (*it);
 
+  std::string message;
   try {
     // Call execute with the process_data_cell flag set to true
     // which will allow us to walk over multiple cells and catch on them
     return ci.process_cell(attempt_cell, env, true);
   } catch (interpreter_c::exception_c &e) {
-    return handle_thrown_error_in_try(e.what(), recover_cell, ci, env);
+    message = e.what();
   } catch (cell_access_exception_c &e) {
-    return handle_thrown_error_in_try(e.what(), recover_cell, ci, env);
+    message = e.what();
   }
-  return allocate_cell(cell_type_e::NIL);
+
+  // The recovery is run once the error has been handled, rather than
+  // within the handler, as a generator can't be suspended within one
+  return handle_thrown_error_in_try(message, recover_cell, ci, env);
 }
 
 cell_ptr builtin_fn_except_throw(cell_processor_if &ci, cell_list_t &list,
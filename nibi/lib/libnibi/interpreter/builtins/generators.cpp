@@ -0,0 +1,312 @@
+#include <memory>
+#include <string>
+
+#include "interpreter/builtins/builtins.hpp"
+#include "interpreter/builtins/generators.hpp"
+#include "interpreter/interpreter.hpp"
+#include "interpreter/native_stack.hpp"
+#include "libnibi/cell.hpp"
+#include "libnibi/keywords.hpp"
+#include "macros.hpp"
+
+/*
+    A generator runs its lambda on a native stack of its own, with an
+    interpreter of its own, so that it can be suspended part way through
+    and resumed later without disturbing the stacks of the interpreter
+    that asked it for a value. Both interpreters run on the same thread
+    and work with the same cells, so nothing has to be copied.
+
+    Generators that are dropped before their lambda has returned have
+    their stack unwound, releasing whatever the lambda was holding.
+*/
+
+namespace nibi {
+namespace builtins {
+
+namespace {
+
+// Calls to lambdas made for generators are given this as their name
+cell_ptr call_name(const char *keyword, locator_ptr locator) {
+  auto name = allocate_cell(symbol_s{intern_symbol(keyword)});
+  name->locator = locator;
+  return name;
+}
+
+// Runs a lambda that emits values, up to each value that is asked for
+class lambda_generator_c final : public generator_if {
+public:
+  lambda_generator_c(cell_processor_if &ci, cell_ptr fn, cell_list_t call)
+      : fn_(fn), call_(std::move(call)),
+        interpreter_(ci.get_env(), ci.get_source_manager(), ci.get_options()),
+        coroutine_(run, this) {}
+
+  bool next(cell_processor_if &, cell_ptr &value) override {
+    // The lambda may drop the last reference to its own generator,
+    // which is kept until the coroutine has switched back to here
+    auto self = shared_from_this();
+    emitted_ = nullptr;
+    if (!coroutine_.resume()) {
+      return false;
+    }
+    value = std::move(emitted_);
+    return true;
+  }
+
+  // Hand a value to whatever asked for one, and wait to be asked again
+  void emit(cell_ptr value) {
+    emitted_ = value;
+    native_coroutine_c::suspend();
+  }
+
+  cell_processor_if &get_processor() { return interpreter_; }
+
+private:
+  cell_ptr fn_;
+  cell_list_t call_;
+  cell_ptr emitted_{nullptr};
+  interpreter_c interpreter_;
+
+  // Destroyed first, so the stack is unwound while
+  // everything it refers to is still around
+  native_coroutine_c coroutine_;
+
+  static void run(void *data) {
+    auto &generator = *static_cast<lambda_generator_c *>(data);
+    generator.interpreter_.execute_lambda(generator.fn_, generator.call_,
+                                          generator.interpreter_.get_env());
+  }
+};
+
+// Produces the items of a list
+class list_generator_c final : public generator_if {
+public:
+  list_generator_c(cell_ptr list) : list_(list) {}
+
+  bool next(cell_processor_if &, cell_ptr &value) override {
+    if (auto *numbers = list_->read_numeric_list()) {
+      if (index_ >= numbers->size()) {
+        return false;
+      }
+      value_s number;
+      numbers->get(index_++, number);
+      value = number.box(list_->locator);
+      return true;
+    }
+    auto &items = list_->as_list_info().list;
+    if (index_ >= items.size()) {
+      return false;
+    }
+    value = items[index_++];
+    return true;
+  }
+
+private:
+  cell_ptr list_;
+  std::size_t index_{0};
+};
+
+// Produces the values of another generator, as given by a lambda
+class map_generator_c final : public generator_if {
+public:
+  map_generator_c(std::shared_ptr<generator_if> source, cell_ptr fn,
+                  locator_ptr locator)
+      : source_(source), fn_(fn),
+        name_(call_name(nibi::kw::GEN_MAP, locator)) {}
+
+  bool next(cell_processor_if &ci, cell_ptr &value) override {
+    cell_ptr item{nullptr};
+    if (!source_->next(ci, item)) {
+      return false;
+    }
+    cell_list_t call{name_, item};
+    value = ci.execute_lambda(fn_, call, ci.get_env());
+    return true;
+  }
+
+private:
+  std::shared_ptr<generator_if> source_;
+  cell_ptr fn_;
+  cell_ptr name_;
+};
+
+// Produces the values of another generator that a lambda accepts
+class filter_generator_c final : public generator_if {
+public:
+  filter_generator_c(std::shared_ptr<generator_if> source, cell_ptr fn,
+                     locator_ptr locator)
+      : source_(source), fn_(fn),
+        name_(call_name(nibi::kw::GEN_FILTER, locator)) {}
+
+  bool next(cell_processor_if &ci, cell_ptr &value) override {
+    cell_ptr item{nullptr};
+    while (source_->next(ci, item)) {
+      cell_list_t call{name_, item};
+      if (ci.execute_lambda(fn_, call, ci.get_env())->as_integer()) {
+        value = item;
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  std::shared_ptr<generator_if> source_;
+  cell_ptr fn_;
+  cell_ptr name_;
+};
+
+// Copies of a generator cell share the generator, and so where it is
+// up to, as a lambda can't be copied part way through
+class generator_cell_c final : public aberrant_cell_if {
+public:
+  generator_cell_c(std::shared_ptr<generator_if> generator)
+      : generator_(generator) {}
+  virtual std::string represent_as_string() override { return "GENERATOR"; }
+  virtual aberrant_cell_if *clone() override {
+    return new generator_cell_c(generator_);
+  }
+  std::shared_ptr<generator_if> &get_generator() { return generator_; }
+
+private:
+  std::shared_ptr<generator_if> generator_;
+};
+
+cell_ptr make_generator_cell(std::shared_ptr<generator_if> generator) {
+  return allocate_cell(
+      static_cast<aberrant_cell_if *>(new generator_cell_c(generator)));
+}
+
+// Get the generator of a cell, or a generator over the items of a list
+std::shared_ptr<generator_if> get_source(const char *keyword, cell_ptr cell,
+                                         locator_ptr locator) {
+  if (cell->type == cell_type_e::ABERRANT) {
+    if (auto *handle = dynamic_cast<generator_cell_c *>(cell->as_aberrant())) {
+      return handle->get_generator();
+    }
+  }
+  if (cell->type == cell_type_e::LIST) {
+    return std::make_shared<list_generator_c>(cell);
+  }
+  throw interpreter_c::exception_c(
+      std::string(keyword) + " expects a generator or a list", locator);
+}
+
+cell_ptr get_lambda(const char *keyword, cell_processor_if &ci,
+                    cell_list_t &list, std::size_t index, env_c &env) {
+  auto fn = ci.process_cell(list[index], env);
+  if (fn->type != cell_type_e::FUNCTION ||
+      fn->as_function_info().type != function_type_e::LAMBDA_FUNCTION) {
+    throw interpreter_c::exception_c(std::string(keyword) +
+                                         " expects a lambda",
+                                     list[index]->locator);
+  }
+  return fn;
+}
+
+} // namespace
+
+generator_if *as_generator(cell_c &cell) {
+  if (cell.type != cell_type_e::ABERRANT) {
+    return nullptr;
+  }
+  auto *handle = dynamic_cast<generator_cell_c *>(cell.as_aberrant());
+  return handle ? handle->get_generator().get() : nullptr;
+}
+
+cell_ptr builtin_fn_gen_create(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::GEN, >=, 2)
+
+  auto fn = get_lambda(nibi::kw::GEN, ci, list, 1, env);
+
+  cell_list_t call{call_name(nibi::kw::GEN, list[0]->locator)};
+  for (std::size_t i = 2; i < list.size(); i++) {
+    call.push_back(ci.process_cell(list[i], env));
+  }
+
+  return make_generator_cell(
+      std::make_shared<lambda_generator_c>(ci, fn, std::move(call)));
+}
+
+cell_ptr builtin_fn_gen_emit(cell_processor_if &ci, cell_list_t &list,
+                             env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::EMIT, ==, 2)
+
+  // Only the interpreter of the generator being run can emit,
+  // others running on its stack belong to something else
+  lambda_generator_c *generator{nullptr};
+  if (auto *coroutine = native_coroutine_c::running()) {
+    generator = static_cast<lambda_generator_c *>(coroutine->get_data());
+  }
+  if (!generator || &generator->get_processor() != &ci) {
+    throw interpreter_c::exception_c(
+        std::string(nibi::kw::EMIT) +
+            " can only be used within the lambda of a generator",
+        list[0]->locator);
+  }
+
+  // The lambda may go on to change what it emitted, so a copy is handed over
+  auto value = ci.process_cell(list[1], env);
+  if (!native_coroutine_c::can_suspend()) {
+    throw interpreter_c::exception_c(
+        std::string(nibi::kw::EMIT) +
+            " can not be used while an error is being handled",
+        list[0]->locator);
+  }
+  generator->emit(value->clone(env));
+  return value;
+}
+
+cell_ptr builtin_fn_gen_next(cell_processor_if &ci, cell_list_t &list,
+                             env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::GEN_NEXT, ==, 2)
+
+  auto source = get_source(nibi::kw::GEN_NEXT, ci.process_cell(list[1], env),
+                           list[1]->locator);
+  cell_ptr value{nullptr};
+  if (!source->next(ci, value)) {
+    return allocate_cell(cell_type_e::NIL);
+  }
+  return value;
+}
+
+cell_ptr builtin_fn_gen_take(cell_processor_if &ci, cell_list_t &list,
+                             env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::GEN_TAKE, ==, 3)
+
+  auto source = get_source(nibi::kw::GEN_TAKE, ci.process_cell(list[1], env),
+                           list[1]->locator);
+  auto count = ci.process_cell(list[2], env)->as_integer();
+
+  list_info_s taken(list_types_e::DATA);
+  cell_ptr value{nullptr};
+  for (int64_t i = 0; i < count && source->next(ci, value); i++) {
+    taken.list.push_back(value);
+  }
+  return allocate_cell(std::move(taken));
+}
+
+cell_ptr builtin_fn_gen_map(cell_processor_if &ci, cell_list_t &list,
+                            env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::GEN_MAP, ==, 3)
+
+  auto source = get_source(nibi::kw::GEN_MAP, ci.process_cell(list[1], env),
+                           list[1]->locator);
+  auto fn = get_lambda(nibi::kw::GEN_MAP, ci, list, 2, env);
+  return make_generator_cell(
+      std::make_shared<map_generator_c>(source, fn, list[0]->locator));
+}
+
+cell_ptr builtin_fn_gen_filter(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::GEN_FILTER, ==, 3)
+
+  auto source = get_source(nibi::kw::GEN_FILTER,
+                           ci.process_cell(list[1], env), list[1]->locator);
+  auto fn = get_lambda(nibi::kw::GEN_FILTER, ci, list, 2, env);
+  return make_generator_cell(
+      std::make_shared<filter_generator_c>(source, fn, list[0]->locator));
+}
+
+} // namespace builtins
+} // namespace nibi
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+
+#include "libnibi/cell.hpp"
+#include "libnibi/interfaces/cell_processor_if.hpp"
+
+namespace nibi {
+namespace builtins {
+
+//! \brief A source of values that are produced as they are asked for
+class generator_if : public std::enable_shared_from_this<generator_if> {
+public:
+  virtual ~generator_if() = default;
+
+  //! \brief Produce the next value
+  //! \param ci The processor asking for the value
+  //! \param value Set to the value produced
+  //! \return false once there are no values left
+  virtual bool next(cell_processor_if &ci, cell_ptr &value) = 0;
+};
+
+//! \brief Get the generator held by a cell
+//! \return nullptr if the cell doesn't hold a generator
+extern generator_if *as_generator(cell_c &cell);
+
+} // namespace builtins
+} // namespace nibi
@@ -0,0 +1,173 @@
+#include "isolator.hpp"
+
+#include "interpreter/interpreter.hpp"
+
+namespace nibi {
+namespace builtins {
+
+void collect_captures(const cell_c &cell, env_c &env,
+                      std::set<symbol_id_t> &seen,
+                      std::vector<capture_s> &captures) {
+  switch (cell.type) {
+  case cell_type_e::SYMBOL: {
+    auto name = cell.data.sym->id;
+    if (!seen.insert(name).second) {
+      return;
+    }
+    auto value = env.get(name);
+    if (!value) {
+      return;
+    }
+    captures.push_back({name, value});
+    collect_captures(*value, env, seen, captures);
+    return;
+  }
+  case cell_type_e::LIST:
+    for (auto &item : cell.data.list->value.list) {
+      collect_captures(*item, env, seen, captures);
+    }
+    return;
+  case cell_type_e::DICT:
+    for (auto &item : cell.data.dict->value) {
+      collect_captures(*item.second, env, seen, captures);
+    }
+    return;
+  case cell_type_e::FUNCTION: {
+    auto &info = *cell.data.fn;
+    if (info.lambda.has_value()) {
+      collect_captures(*info.lambda->body,
+                       info.operating_env ? *info.operating_env : env, seen,
+                       captures);
+    }
+    return;
+  }
+  default:
+    return;
+  }
+}
+
+cell_ptr isolator_c::try_isolate(const cell_c &source) {
+  cell_ptr result{nullptr};
+  switch (source.type) {
+  case cell_type_e::NIL:
+    result = allocate_cell(cell_type_e::NIL);
+    break;
+  case cell_type_e::INTEGER:
+    result = allocate_cell(source.data.i);
+    break;
+  case cell_type_e::DOUBLE:
+    result = allocate_cell(source.data.d);
+    break;
+  case cell_type_e::STRING:
+    result = allocate_cell(std::string(source.data.str->value));
+    break;
+  case cell_type_e::SYMBOL:
+    result = allocate_cell(symbol_s{source.data.sym->id});
+    break;
+  case cell_type_e::LIST:
+    result = isolate_list(source);
+    break;
+  case cell_type_e::DICT: {
+    cell_dict_t dict;
+    for (auto &item : source.data.dict->value) {
+      dict[item.first] = isolate(*item.second);
+    }
+    result = allocate_cell(std::move(dict));
+    result->data.dict->resolved = source.data.dict->resolved;
+    break;
+  }
+  case cell_type_e::FUNCTION:
+    result = isolate_function(source);
+    break;
+  case cell_type_e::ENVIRONMENT: {
+    auto &info = *source.data.env;
+    result =
+        allocate_cell(environment_info_s{info.name, isolate_env(*info.env)});
+    break;
+  }
+  case cell_type_e::ABERRANT: {
+    auto shared = source.data.aberrant ? source.data.aberrant->share()
+                                       : nullptr;
+    if (!shared) {
+      return nullptr;
+    }
+    result = allocate_cell(shared);
+    break;
+  }
+  }
+  result->locator = source.locator;
+  return result;
+}
+
+cell_ptr isolator_c::isolate(const cell_c &source) {
+  auto result = try_isolate(source);
+  if (!result) {
+    throw interpreter_c::exception_c(
+        "Value can not be shared with another thread", source.locator);
+  }
+  return result;
+}
+
+cell_ptr isolator_c::isolate_list(const cell_c &source) {
+  auto &source_info = source.data.list->value;
+  list_info_s info(source_info.type);
+  if (source_info.numeric) {
+    info.numeric = std::make_unique<numeric_list_s>(*source_info.numeric);
+  }
+  info.list.reserve(source_info.list.size());
+  for (auto &item : source_info.list) {
+    info.list.push_back(isolate(*item));
+  }
+  auto result = allocate_cell(std::move(info));
+  result->data.list->value.tail_call = source_info.tail_call;
+  result->data.list->resolved = source.data.list->resolved;
+  return result;
+}
+
+cell_ptr isolator_c::isolate_function(const cell_c &source) {
+  auto &info = *source.data.fn;
+  function_info_s new_info(info.name, info.fn, info.type, nullptr,
+                           info.value_fn, info.apply_fn);
+
+  if (info.lambda.has_value()) {
+    new_info.lambda = lambda_info_s{info.lambda->arg_names,
+                                    isolate(*info.lambda->body),
+                                    info.lambda->defines_functions};
+  }
+
+  if (info.type == function_type_e::FAUX) {
+    // Fauxs own their environment
+    if (info.operating_env) {
+      new_info.operating_env = new env_c();
+      copy_bindings(*info.operating_env, *new_info.operating_env);
+    }
+  } else if (info.operating_env) {
+    new_info.operating_env = &root_;
+    for (auto &[original, copy] : envs_) {
+      if (original == info.operating_env) {
+        new_info.operating_env = copy;
+        break;
+      }
+    }
+  }
+
+  return allocate_cell(std::move(new_info));
+}
+
+std::shared_ptr<env_c> isolator_c::isolate_env(env_c &source) {
+  auto copy = std::make_shared<env_c>(source.get_parent() ? &root_ : nullptr);
+  envs_.push_back({&source, copy.get()});
+  copy_bindings(source, *copy);
+  return copy;
+}
+
+void isolator_c::copy_bindings(env_c &source, env_c &target) {
+  for (auto &[name, value] : source.get_map()) {
+    if (auto copy = try_isolate(*value)) {
+      target.define(name, copy);
+    }
+  }
+}
+
+} // namespace builtins
+} // namespace nibi
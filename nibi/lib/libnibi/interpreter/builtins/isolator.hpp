@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "libnibi/cell.hpp"
+#include "libnibi/environment.hpp"
+
+/*
+    Cells are reference counted without atomics and are allocated from
+    pools owned by the thread that allocated them, so they can't be shared
+    between threads. Code that runs on another thread is given copies of
+    everything it refers to, made by that thread from cells that the
+    thread they belong to has resolved for it.
+
+    Reading a cell doesn't touch its reference count, so the copies can be
+    made from any number of threads at once, as long as the thread the
+    cells belong to waits for them to be done.
+*/
+
+namespace nibi {
+namespace builtins {
+
+//! \brief A value that is referred to by name, resolved on the
+//!        thread that it belongs to
+struct capture_s {
+  symbol_id_t name;
+  cell_ptr value;
+};
+
+//! \brief Find the values that a cell refers to by name, along with
+//!        those that the lambdas among them refer to, as they are
+//!        resolved from where they were defined
+//! \param cell The cell to search
+//! \param env The environment that names are resolved in
+//! \param seen Names that have already been searched for
+//! \param captures The values that have been found
+void collect_captures(const cell_c &cell, env_c &env,
+                      std::set<symbol_id_t> &seen,
+                      std::vector<capture_s> &captures);
+
+//! \brief Copies cells so that the copy shares nothing with the original,
+//!        which is only read
+//! \note  Functions are pointed at the copy of the environment they operate
+//!        in if it was copied, and otherwise at the root environment the
+//!        copies are made for
+class isolator_c {
+public:
+  //! \brief Create the isolator
+  //! \param root The environment that the copies are made for
+  isolator_c(env_c &root) : root_(root) {}
+
+  //! \brief Copy a cell
+  //! \return nullptr if the cell holds something that can't be copied
+  cell_ptr try_isolate(const cell_c &source);
+
+  //! \brief Copy a cell
+  //! \throws interpreter_c::exception_c if the cell holds something
+  //!         that can't be copied
+  cell_ptr isolate(const cell_c &source);
+
+private:
+  env_c &root_;
+
+  // Environments that have been copied, and their copies, which are
+  // owned by the environment cells they were copied for
+  std::vector<std::pair<const env_c *, env_c *>> envs_;
+
+  cell_ptr isolate_list(const cell_c &source);
+  cell_ptr isolate_function(const cell_c &source);
+  std::shared_ptr<env_c> isolate_env(env_c &source);
+
+  // Anything that can't be copied is left out, and found
+  // missing if the copy is ever used
+  void copy_bindings(env_c &source, env_c &target);
+};
+
+} // namespace builtins
+} // namespace nibi
@@ -22,8 +22,7 @@ cell_ptr execute_suspected_lambda(cell_processor_if &ci, cell_list_t &list,
 
   // If the first argument is a symbol, then we need to look it up
   if ((*it)->type == cell_type_e::SYMBOL) {
-    auto target_symbol = (*it)->as_symbol();
-    target_cell = env.get(target_symbol);
+    target_cell = env.get(*(*it)->data.sym);
     if (!target_cell) {
       throw interpreter_c::exception_c("Symbol not found in environment: " +
                                            (*it)->as_symbol(),
@@ -32,46 +31,74 @@ cell_ptr execute_suspected_lambda(cell_processor_if &ci, cell_list_t &list,
     }
   }
 
-  auto &fn_info = target_cell->as_function_info();
+  return ci.execute_lambda(target_cell, list, env);
+}
 
-  if (fn_info.type != function_type_e::LAMBDA_FUNCTION) {
-    throw interpreter_c::exception_c("Expected lambda function",
-                                     (*it)->locator);
+namespace {
+void mark_tail_calls(cell_ptr &cell, const bool in_tail_position) {
+  if (cell->type != cell_type_e::LIST) {
+    return;
   }
 
-  auto &lambda_info = *fn_info.lambda;
-
-  NIBI_LIST_ENFORCE_SIZE((*it)->as_symbol(), ==,
-                         lambda_info.arg_names.size() + 1);
-
-  // Create an environment for the lambda
-  // and populate it with the arguments
-  auto lambda_env = env_c(fn_info.operating_env);
-  auto &map = lambda_env.get_map();
+  auto &list_info = cell->data.list->value;
+  auto &list = list_info.list;
+  if (list.empty() || list_info.type == list_types_e::ACCESS) {
+    return;
+  }
 
-  for (auto &&arg_name : lambda_info.arg_names) {
-    std::advance(it, 1);
-    map[arg_name] = ci.process_cell((*it), env);
+  // Only the last item of a data list is given as its result
+  if (list_info.type == list_types_e::DATA) {
+    for (std::size_t i = 0; i < list.size(); i++) {
+      mark_tail_calls(list[i], in_tail_position && i == list.size() - 1);
+    }
+    return;
   }
 
-  auto &body = lambda_info.body->as_list_info();
+  auto &operation = list.front();
+  if (operation->type != cell_type_e::FUNCTION ||
+      operation->data.fn->type != function_type_e::BUILTIN_CPP_FUNCTION) {
+    list_info.tail_call = in_tail_position;
+    return;
+  }
 
-  cell_ptr result = ci.process_cell(lambda_info.body, lambda_env, true);
+  // Only builtins that hand back the result of what they execute,
+  // or that stop executing once yielded from, can have tail calls
+  // within them. Anything else, such as a `try`, has more to do
+  // once what it is executing returns
+  auto fn = operation->data.fn->fn;
+  if (fn == builtin_fn_common_yield && list.size() == 2) {
+    mark_tail_calls(list[1], true);
+  } else if (fn == builtin_fn_common_if) {
+    for (std::size_t i = 2; i < list.size(); i++) {
+      mark_tail_calls(list[i], in_tail_position);
+    }
+  } else if (fn == builtin_fn_common_loop && list.size() == 5) {
+    mark_tail_calls(list[4], false);
+  } else if (fn == builtin_fn_list_iter && list.size() == 4) {
+    mark_tail_calls(list[3], false);
+  }
+}
+} // namespace
 
-  // Because we have pointers to parametrs stored we don't want the environment
-  // to free them, so we manually remove them here before
+void mark_tail_calls(cell_ptr &body) { mark_tail_calls(body, true); }
 
-  for (auto &&arg_name : lambda_info.arg_names) {
-    map.erase(arg_name);
+bool defines_functions(const cell_ptr &body) {
+  if (body->type != cell_type_e::LIST) {
+    return false;
   }
 
-  // We are out of the function, so we can reset the yield value
-  if (ci.is_yielding()) {
-    ci.set_yield_value(nullptr);
+  auto &list = body->data.list->value.list;
+  if (!list.empty() && list.front()->type == cell_type_e::FUNCTION &&
+      list.front()->data.fn->fn == builtin_fn_env_fn) {
+    return true;
   }
 
-  // Return a copy of the result
-  return result;
+  for (auto &cell : list) {
+    if (defines_functions(cell)) {
+      return true;
+    }
+  }
+  return false;
 }
 
 } // namespace builtins
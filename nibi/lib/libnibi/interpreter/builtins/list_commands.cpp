@@ -1,6 +1,7 @@
 #include <iostream>
 
 #include "interpreter/builtins/builtins.hpp"
+#include "interpreter/builtins/generators.hpp"
 #include "keywords.hpp"
 #include "libnibi/cell.hpp"
 #include "macros.hpp"
@@ -16,6 +17,34 @@ inline void push_front(cell_list_t &list, cell_ptr &&cell) {
 }
 #endif
 
+namespace {
+// Get the index requested of a list, ensuring that it is in bounds
+std::size_t list_index(cell_list_t &list, value_s &requested_idx,
+                       const std::size_t size) {
+  auto actual_idx_val = requested_idx.type == cell_type_e::INTEGER
+                            ? requested_idx.i
+                            : requested_idx.box()->as_integer();
+
+  if (actual_idx_val < 0 || static_cast<std::size_t>(actual_idx_val) >= size) {
+    throw interpreter_c::exception_c("Index out of bounds (OOB)",
+                                     list[2]->locator);
+  }
+  return actual_idx_val;
+}
+
+// Insert a value into the numeric storage of a list, if it has any
+// and the value is a number of the same type
+inline bool insert_number(cell_ptr &target, cell_ptr &value, bool front) {
+  auto *numbers = target->as_numeric_list();
+  if (!numbers) {
+    return false;
+  }
+  value_s item;
+  item.set(value);
+  return numbers->insert(front ? 0 : numbers->size(), item);
+}
+} // namespace
+
 cell_ptr builtin_fn_list_push_front(cell_processor_if &ci, cell_list_t &list,
                                     env_c &env) {
   NIBI_LIST_ENFORCE_SIZE(nibi::kw::PUSH_FRONT, ==, 3)
@@ -26,6 +55,10 @@ cell_ptr builtin_fn_list_push_front(cell_processor_if &ci, cell_list_t &list,
   auto list_to_push_to = std::move(ci.process_cell(list[1], env));
   list_to_push_to->locator = list[1]->locator;
 
+  if (insert_number(list_to_push_to, value_to_push, true)) {
+    return list_to_push_to;
+  }
+
   auto &list_info = list_to_push_to->as_list_info();
 
   // Clone the target and push it back
@@ -48,6 +81,10 @@ cell_ptr builtin_fn_list_push_back(cell_processor_if &ci, cell_list_t &list,
   auto list_to_push_to = std::move(ci.process_cell(list[1], env));
   list_to_push_to->locator = list[1]->locator;
 
+  if (insert_number(list_to_push_to, value_to_push, false)) {
+    return list_to_push_to;
+  }
+
   auto &list_info = list_to_push_to->as_list_info();
 
   // Clone the target and push it back
@@ -63,6 +100,13 @@ cell_ptr builtin_fn_list_pop_back(cell_processor_if &ci, cell_list_t &list,
   auto target = std::move(ci.process_cell(list[1], env));
   target->locator = list[1]->locator;
 
+  if (auto *numbers = target->as_numeric_list()) {
+    if (numbers->size()) {
+      numbers->erase(numbers->size() - 1);
+    }
+    return target;
+  }
+
   auto &list_info = target->as_list_info();
 
   if (list_info.list.empty()) {
@@ -81,6 +125,13 @@ cell_ptr builtin_fn_list_pop_front(cell_processor_if &ci, cell_list_t &list,
   auto target = std::move(ci.process_cell(list[1], env));
   target->locator = list[1]->locator;
 
+  if (auto *numbers = target->as_numeric_list()) {
+    if (numbers->size()) {
+      numbers->erase(0);
+    }
+    return target;
+  }
+
   auto &list_info = target->as_list_info();
 
   if (list_info.list.empty()) {
@@ -104,24 +155,33 @@ cell_ptr builtin_fn_list_iter(cell_processor_if &ci, cell_list_t &list,
   auto list_to_iterate = std::move(ci.process_cell(list[1], env));
   list_to_iterate->locator = list[1]->locator;
 
-  auto &list_info = list_to_iterate->as_list_info();
-
   auto it = list.begin();
 
   std::advance(it, 2);
-  auto symbol_to_bind = (*it)->as_symbol();
+  auto symbol_to_bind = (*it)->as_symbol_id();
 
   std::advance(it, 1);
   auto ins_to_exec_per_item = (*it);
 
   auto iter_env = env_c(&env);
 
-  auto &current_env_map = iter_env.get_map();
+  // Generators are iterated by pulling values from them as they're needed
+  if (auto *found = as_generator(*list_to_iterate)) {
+    // Held here, as the items may go on to drop it from its cell
+    auto generator = found->shared_from_this();
+    cell_ptr value{nullptr};
+    while (generator->next(ci, value)) {
+      iter_env.define(symbol_to_bind, value);
+      ci.process_cell(ins_to_exec_per_item, iter_env, true);
+    }
+    return list_to_iterate;
+  }
+
+  auto &list_info = list_to_iterate->as_list_info();
 
   for (auto cell : list_info.list) {
 
-    current_env_map[symbol_to_bind] =
-        std::move(ci.process_cell(cell, iter_env));
+    iter_env.define(symbol_to_bind, ci.process_cell(cell, iter_env));
 
     ci.process_cell(ins_to_exec_per_item, iter_env, true);
   }
@@ -130,24 +190,73 @@ cell_ptr builtin_fn_list_iter(cell_processor_if &ci, cell_list_t &list,
   return std::move(list_to_iterate);
 }
 
+void builtin_value_list_at(cell_processor_if &ci, cell_list_t &list,
+                           env_c &env, value_s &out) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::AT, ==, 3)
+
+  value_s requested_idx;
+  ci.process_value(list[2], env, requested_idx);
+
+  auto target_list = std::move(ci.process_cell(list[1], env));
+
+  // Numbers held unboxed are read without being given a cell
+  if (auto *numbers = target_list->read_numeric_list()) {
+    numbers->get(list_index(list, requested_idx, numbers->size()), out);
+    return;
+  }
+
+  auto &list_info = target_list->as_list_info();
+  auto idx = list_index(list, requested_idx, list_info.list.size());
+  out.set(ci.process_cell(list_info.list[idx], env));
+}
+
 cell_ptr builtin_fn_list_at(cell_processor_if &ci, cell_list_t &list,
                             env_c &env) {
   NIBI_LIST_ENFORCE_SIZE(nibi::kw::AT, ==, 3)
 
-  auto requested_idx = std::move(ci.process_cell(list[2], env));
+  value_s requested_idx;
+  ci.process_value(list[2], env, requested_idx);
 
   auto target_list = std::move(ci.process_cell(list[1], env));
 
+  // Numbers held unboxed are given a cell of their own, so updating
+  // them has to go through the list, see set_list_item
+  if (auto *numbers = target_list->read_numeric_list()) {
+    value_s item;
+    numbers->get(list_index(list, requested_idx, numbers->size()), item);
+    return item.box(target_list->locator);
+  }
+
   auto &list_info = target_list->as_list_info();
+  auto idx = list_index(list, requested_idx, list_info.list.size());
+  return std::move(ci.process_cell(list_info.list[idx], env));
+}
 
-  auto actual_idx_val = requested_idx->as_integer();
+cell_ptr set_list_item(cell_processor_if &ci, cell_list_t &list,
+                       cell_ptr &value_cell, env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::AT, ==, 3)
 
-  if (actual_idx_val < 0 || actual_idx_val >= list_info.list.size()) {
-    throw interpreter_c::exception_c("Index out of bounds (OOB)",
-                                     list[2]->locator);
+  value_s requested_idx;
+  ci.process_value(list[2], env, requested_idx);
+
+  auto target_list = std::move(ci.process_cell(list[1], env));
+
+  value_s value;
+  ci.process_value(value_cell, env, value);
+
+  if (auto *numbers = target_list->as_numeric_list()) {
+    auto idx = list_index(list, requested_idx, numbers->size());
+    if (numbers->set(idx, value)) {
+      return value.box(value_cell->locator);
+    }
   }
 
-  return std::move(ci.process_cell(list_info.list[actual_idx_val], env));
+  // Anything else means the items need cells of their own
+  auto &list_info = target_list->as_list_info();
+  auto idx = list_index(list, requested_idx, list_info.list.size());
+  auto item = ci.process_cell(list_info.list[idx], env);
+  item->update_from(value, env);
+  return item;
 }
 
 cell_ptr builtin_fn_list_spawn(cell_processor_if &ci, cell_list_t &list,
@@ -163,10 +272,24 @@ cell_ptr builtin_fn_list_spawn(cell_processor_if &ci, cell_list_t &list,
                                      (*it)->locator);
   }
 
+  auto value = ci.process_cell(list[1], env);
+
+#if CELL_LIST_USE_NUMERIC_STORAGE
+  if (value->is_numeric()) {
+    value_s item;
+    item.set(value);
+    list_info_s numeric_info(list_types_e::DATA);
+    numeric_info.numeric =
+        std::make_unique<numeric_list_s>(item, list_size->as_integer());
+    auto spawned = allocate_cell(std::move(numeric_info));
+    spawned->locator = list[1]->locator;
+    return spawned;
+  }
+#endif
+
   auto spawned = allocate_cell(list_info_s{
       list_types_e::DATA,
-      cell_list_t(list_size->as_integer(),
-                  std::move(ci.process_cell(list[1], env)->clone(env)))});
+      cell_list_t(list_size->as_integer(), std::move(value->clone(env)))});
   spawned->locator = list[1]->locator;
   return std::move(spawned);
 }
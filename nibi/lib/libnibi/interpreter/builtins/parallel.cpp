@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <latch>
+#include <optional>
+#include <set>
+#include <vector>
+
+#include "interpreter/builtins/builtins.hpp"
+#include "interpreter/builtins/isolator.hpp"
+#include "interpreter/interpreter.hpp"
+#include "libnibi/cell.hpp"
+#include "libnibi/keywords.hpp"
+#include "libnibi/thread_pool.hpp"
+#include "macros.hpp"
+
+/*
+    Each worker is given an interpreter and an environment of its own,
+    holding copies of everything the body of the instruction refers to,
+    which the worker makes itself while the calling thread waits.
+
+    Results are copied back by the calling thread while the workers wait,
+    after which each worker frees everything that it allocated.
+*/
+
+namespace nibi {
+namespace builtins {
+
+namespace {
+
+// Fewer workers are used for short lists, as each has to copy
+// everything the body refers to before it can start
+static constexpr std::size_t MIN_ITEMS_PER_WORKER = 16;
+
+// Workers claim items in chunks, with enough chunks per worker that
+// those given quick items can pick up the slack of those given slow ones
+static constexpr std::size_t CHUNKS_PER_WORKER = 8;
+
+// An item of the list, by the value the body produced for it
+struct parallel_result_s {
+  value_s value;
+};
+
+// The state shared by the workers of a single instruction. Everything
+// that belongs to the calling thread is only ever read by workers
+struct parallel_job_s {
+  const cell_c *body;
+  symbol_id_t bind;
+  const std::vector<capture_s> *captures;
+  const cell_list_t *items{nullptr};
+  const numeric_list_s *numbers{nullptr};
+  std::size_t count{0};
+  std::size_t chunk_size{1};
+  bool collect{false};
+  interpreter_options_s options;
+
+  std::atomic<std::size_t> next_chunk{0};
+  std::atomic<bool> failed{false};
+
+  // Written by whichever worker processes the item
+  std::vector<parallel_result_s> results;
+
+  // The first error of each worker, with the item it was raised on
+  std::vector<std::pair<std::size_t, std::exception_ptr>> errors;
+};
+
+// The interpreter and environment of a worker, which must be
+// created and destroyed on the thread that the worker runs on
+class parallel_worker_c {
+public:
+  parallel_worker_c(parallel_job_s &job, std::size_t index)
+      : job_(job), index_(index), isolator_(root_),
+        interpreter_(root_, source_manager_, job.options),
+        item_env_(&root_) {}
+
+  ~parallel_worker_c() {
+    // Results that were not numbers are held by cells of this thread
+    if (!job_.collect) {
+      return;
+    }
+    for (auto &[start, end] : claimed_) {
+      for (auto i = start; i < end; i++) {
+        job_.results[i].value.cell = nullptr;
+      }
+    }
+  }
+
+  void run() {
+    std::size_t item{0};
+    try {
+      for (auto &capture : *job_.captures) {
+        if (auto copy = isolator_.try_isolate(*capture.value)) {
+          root_.define(capture.name, copy);
+        }
+      }
+      body_ = isolator_.isolate(*job_.body);
+
+      while (!job_.failed.load(std::memory_order_relaxed)) {
+        auto start = job_.next_chunk.fetch_add(1) * job_.chunk_size;
+        if (start >= job_.count) {
+          break;
+        }
+        auto end = std::min(start + job_.chunk_size, job_.count);
+        claimed_.push_back({start, end});
+        for (item = start; item < end; item++) {
+          run_item(item);
+        }
+      }
+    } catch (...) {
+      job_.errors[index_] = {item, std::current_exception()};
+      job_.failed = true;
+    }
+  }
+
+private:
+  parallel_job_s &job_;
+  std::size_t index_;
+  source_manager_c source_manager_;
+  env_c root_;
+  isolator_c isolator_;
+  interpreter_c interpreter_;
+  env_c item_env_;
+  cell_ptr body_{nullptr};
+  std::vector<std::pair<std::size_t, std::size_t>> claimed_;
+
+  void run_item(std::size_t index) {
+    cell_ptr item{nullptr};
+    if (job_.numbers) {
+      value_s number;
+      job_.numbers->get(index, number);
+      item = number.box();
+    } else {
+      item = isolator_.isolate(*(*job_.items)[index]);
+    }
+    item_env_.define(job_.bind, interpreter_.process_cell(item, item_env_));
+
+    if (!job_.collect) {
+      interpreter_.process_cell(body_, item_env_, true);
+      return;
+    }
+
+    auto &result = job_.results[index].value;
+    interpreter_.process_value(body_, item_env_, result, true);
+    if (result.is_numeric()) {
+      result.cell = nullptr;
+    }
+  }
+};
+
+// Run the body of a piter or pmap instruction for every item of a list
+// Returns the values the body produced, if they are collected
+cell_ptr run_parallel(cell_processor_if &ci, cell_list_t &list, env_c &env,
+                      bool collect) {
+  auto list_cell = ci.process_cell(list[1], env);
+  auto bind = list[2]->as_symbol_id();
+
+  parallel_job_s job;
+  job.body = list[3].get();
+  job.bind = bind;
+  job.collect = collect;
+  job.options = ci.get_options();
+  if ((job.numbers = list_cell->read_numeric_list())) {
+    job.count = job.numbers->size();
+  } else {
+    job.items = &list_cell->data.list->value.list;
+    job.count = job.items->size();
+  }
+
+  std::set<symbol_id_t> seen{bind};
+  std::vector<capture_s> captures;
+  collect_captures(*list[3], env, seen, captures);
+  job.captures = &captures;
+
+  auto &pool = get_thread_pool();
+  auto workers =
+      std::clamp<std::size_t>(job.count / MIN_ITEMS_PER_WORKER, 1,
+                              pool.get_worker_count());
+  job.chunk_size =
+      std::max<std::size_t>(1, job.count / (workers * CHUNKS_PER_WORKER));
+  job.results.resize(collect ? job.count : 0);
+  job.errors.resize(workers);
+
+  // Gather the results into cells of the calling thread
+  cell_ptr collected{nullptr};
+  auto gather = [&]() {
+    if (job.failed || !collect) {
+      return;
+    }
+
+    bool integers{true};
+    bool doubles{true};
+    for (auto &result : job.results) {
+      integers = integers && result.value.type == cell_type_e::INTEGER;
+      doubles = doubles && result.value.type == cell_type_e::DOUBLE;
+    }
+
+    list_info_s info(list_types_e::DATA);
+#if CELL_LIST_USE_NUMERIC_STORAGE
+    if (job.count && (integers || doubles)) {
+      value_s first;
+      first.type = job.results[0].value.type;
+      info.numeric = std::make_unique<numeric_list_s>(first, job.count);
+      for (std::size_t i = 0; i < job.count; i++) {
+        info.numeric->set(i, job.results[i].value);
+      }
+    }
+#endif
+    if (!info.numeric) {
+      isolator_c isolator(env);
+      info.list.reserve(job.count);
+      for (auto &result : job.results) {
+        info.list.push_back(result.value.is_numeric()
+                                ? result.value.box(list[0]->locator)
+                                : isolator.isolate(*result.value.cell));
+      }
+    }
+    collected = allocate_cell(std::move(info));
+    collected->locator = list[0]->locator;
+  };
+
+  std::exception_ptr gather_error{nullptr};
+
+  // Nested parallel instructions run on the worker they are
+  // reached from, as every other worker may be just as busy
+  if (workers == 1 || thread_pool_c::is_worker_thread()) {
+    job.errors.resize(1);
+    parallel_worker_c worker(job, 0);
+    worker.run();
+    try {
+      gather();
+    } catch (...) {
+      gather_error = std::current_exception();
+    }
+  } else {
+    std::latch computed(workers);
+    std::latch released(1);
+    pool.start(workers, [&](std::size_t index) {
+      std::optional<parallel_worker_c> worker;
+      try {
+        worker.emplace(job, index);
+        worker->run();
+      } catch (...) {
+        job.errors[index] = {0, std::current_exception()};
+        job.failed = true;
+      }
+      computed.count_down();
+      released.wait();
+    });
+    computed.wait();
+    try {
+      gather();
+    } catch (...) {
+      gather_error = std::current_exception();
+    }
+    released.count_down();
+    pool.wait();
+  }
+
+  // The error raised on the earliest item is the one that
+  // would have been raised had the items been run in order
+  std::pair<std::size_t, std::exception_ptr> first_error{job.count, nullptr};
+  for (auto &error : job.errors) {
+    if (error.second && error.first < first_error.first) {
+      first_error = error;
+    }
+  }
+  if (first_error.second) {
+    std::rethrow_exception(first_error.second);
+  }
+  if (gather_error) {
+    std::rethrow_exception(gather_error);
+  }
+
+  return collect ? collected : list_cell;
+}
+
+} // namespace
+
+cell_ptr builtin_fn_list_parallel_iter(cell_processor_if &ci,
+                                       cell_list_t &list, env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::PITER, ==, 4)
+  return run_parallel(ci, list, env, false);
+}
+
+cell_ptr builtin_fn_list_parallel_map(cell_processor_if &ci, cell_list_t &list,
+                                      env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::PMAP, ==, 4)
+  return run_parallel(ci, list, env, true);
+}
+
+} // namespace builtins
+} // namespace nibi
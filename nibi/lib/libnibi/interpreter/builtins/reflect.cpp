@@ -26,8 +26,8 @@ inline nibi::cell_ptr type(nibi::cell_processor_if &ci, nibi::cell_list_t &list,
   case nibi::cell_type_e::STRING:
     return nibi::allocate_cell(nibi::types::STRING);
   case nibi::cell_type_e::LIST: {
-    auto list_info = resolved->as_list_info();
-    switch (list_info.type) {
+    // Only the type is needed, so numeric items are left unboxed
+    switch (resolved->data.list->value.type) {
     case nibi::list_types_e::DATA:
       return nibi::allocate_cell(nibi::types::LIST_DATA);
     case nibi::list_types_e::ACCESS:
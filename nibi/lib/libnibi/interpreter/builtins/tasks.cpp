@@ -0,0 +1,403 @@
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "interpreter/builtins/builtins.hpp"
+#include "interpreter/builtins/isolator.hpp"
+#include "interpreter/interpreter.hpp"
+#include "libnibi/cell.hpp"
+#include "libnibi/keywords.hpp"
+#include "macros.hpp"
+
+/*
+    Each task runs a lambda on a thread of its own, with an interpreter
+    and an environment holding copies of everything the lambda refers to.
+    Like the workers of parallel instructions, the task makes the copies
+    itself while the thread that spawned it waits, after which the two
+    share nothing.
+
+    Values are passed between tasks as messages, which hold their data
+    outside of any cell so that they can be built on one thread and
+    turned back into cells on another without either waiting.
+
+    Tasks block whenever they wait on a channel, so they are given
+    threads of their own rather than workers of the shared pool, which
+    could otherwise all be taken by tasks waiting on one that hasn't
+    been able to start.
+*/
+
+namespace nibi {
+namespace builtins {
+
+namespace {
+
+// A value as it is passed between threads, holding nothing that
+// belongs to the thread that it came from
+struct message_s {
+  cell_type_e type{cell_type_e::NIL};
+  int64_t i{0};
+  double d{0.0};
+  symbol_id_t symbol{0};
+  std::string str;
+  list_types_e list_type{list_types_e::DATA};
+  std::vector<message_s> items;
+  std::unique_ptr<numeric_list_s> numeric{nullptr};
+  std::vector<std::pair<std::string, message_s>> dict;
+  std::unique_ptr<aberrant_cell_if> aberrant{nullptr};
+};
+
+message_s pack(const cell_c &cell) {
+  message_s message;
+  message.type = cell.type;
+  switch (cell.type) {
+  case cell_type_e::NIL:
+    break;
+  case cell_type_e::INTEGER:
+    message.i = cell.data.i;
+    break;
+  case cell_type_e::DOUBLE:
+    message.d = cell.data.d;
+    break;
+  case cell_type_e::SYMBOL:
+    message.symbol = cell.data.sym->id;
+    break;
+  case cell_type_e::STRING:
+    message.str = cell.data.str->value;
+    break;
+  case cell_type_e::LIST: {
+    auto &info = cell.data.list->value;
+    message.list_type = info.type;
+    if (info.numeric) {
+      message.numeric = std::make_unique<numeric_list_s>(*info.numeric);
+    }
+    message.items.reserve(info.list.size());
+    for (auto &item : info.list) {
+      message.items.push_back(pack(*item));
+    }
+    break;
+  }
+  case cell_type_e::DICT:
+    message.dict.reserve(cell.data.dict->value.size());
+    for (auto &item : cell.data.dict->value) {
+      message.dict.push_back({item.first, pack(*item.second)});
+    }
+    break;
+  case cell_type_e::ABERRANT:
+    if (cell.data.aberrant) {
+      message.aberrant.reset(cell.data.aberrant->share());
+    }
+    if (!message.aberrant) {
+      throw interpreter_c::exception_c(
+          "Value can not be shared with another thread", cell.locator);
+    }
+    break;
+  case cell_type_e::FUNCTION:
+  case cell_type_e::ENVIRONMENT:
+    throw interpreter_c::exception_c(
+        "Functions and environments can not be sent between tasks",
+        cell.locator);
+  }
+  return message;
+}
+
+cell_ptr unpack(const message_s &message) {
+  switch (message.type) {
+  case cell_type_e::INTEGER:
+    return allocate_cell(message.i);
+  case cell_type_e::DOUBLE:
+    return allocate_cell(message.d);
+  case cell_type_e::SYMBOL:
+    return allocate_cell(symbol_s{message.symbol});
+  case cell_type_e::STRING:
+    return allocate_cell(std::string(message.str));
+  case cell_type_e::LIST: {
+    list_info_s info(message.list_type);
+    if (message.numeric) {
+      info.numeric = std::make_unique<numeric_list_s>(*message.numeric);
+    }
+    info.list.reserve(message.items.size());
+    for (auto &item : message.items) {
+      info.list.push_back(unpack(item));
+    }
+    return allocate_cell(std::move(info));
+  }
+  case cell_type_e::DICT: {
+    cell_dict_t dict;
+    for (auto &item : message.dict) {
+      dict[item.first] = unpack(item.second);
+    }
+    return allocate_cell(std::move(dict));
+  }
+  case cell_type_e::ABERRANT:
+    return allocate_cell(message.aberrant->share());
+  default:
+    return allocate_cell(cell_type_e::NIL);
+  }
+}
+
+// A bounded queue of messages that any number of threads send to and
+// receive from. Senders wait while it is full and receivers wait while
+// it is empty, until it is closed
+class channel_c {
+public:
+  channel_c(std::size_t capacity) : capacity_(capacity) {}
+
+  // Returns false if the channel was closed
+  bool send(message_s message) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock,
+                   [this]() { return closed_ || queue_.size() < capacity_; });
+    if (closed_) {
+      return false;
+    }
+    queue_.push_back(std::move(message));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // Returns nothing once the channel is closed and emptied
+  std::optional<message_s> receive() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]() { return closed_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return std::nullopt;
+    }
+    auto message = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return message;
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<message_s> queue_;
+  std::size_t capacity_;
+  bool closed_{false};
+};
+
+class channel_cell_c final : public aberrant_cell_if {
+public:
+  channel_cell_c(std::shared_ptr<channel_c> channel) : channel_(channel) {}
+  virtual std::string represent_as_string() override { return "CHANNEL"; }
+  virtual aberrant_cell_if *clone() override {
+    return new channel_cell_c(channel_);
+  }
+  virtual aberrant_cell_if *share() override {
+    return new channel_cell_c(channel_);
+  }
+  channel_c &get_channel() { return *channel_; }
+
+private:
+  std::shared_ptr<channel_c> channel_;
+};
+
+// A task and what it produced. The thread of the task is waited
+// for once the task is joined, or when its last handle is dropped
+struct task_s {
+  std::thread thread;
+  std::optional<message_s> result{std::nullopt};
+  std::exception_ptr error{nullptr};
+
+  void join() {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+
+  ~task_s() { join(); }
+};
+
+// Handles to a task stay on the thread that spawned it,
+// so they are never shared with other threads
+class task_cell_c final : public aberrant_cell_if {
+public:
+  task_cell_c(std::shared_ptr<task_s> task) : task_(task) {}
+  virtual std::string represent_as_string() override { return "TASK"; }
+  virtual aberrant_cell_if *clone() override { return new task_cell_c(task_); }
+  task_s &get_task() { return *task_; }
+
+private:
+  std::shared_ptr<task_s> task_;
+};
+
+template <typename T>
+T &get_handle(const char *keyword, cell_ptr &cell, const char *expected,
+              locator_ptr locator) {
+  T *handle{nullptr};
+  if (cell->type == cell_type_e::ABERRANT) {
+    handle = dynamic_cast<T *>(cell->as_aberrant());
+  }
+  if (!handle) {
+    throw interpreter_c::exception_c(
+        std::string(keyword) + " expects " + expected, locator);
+  }
+  return *handle;
+}
+
+channel_c &get_channel(const char *keyword, cell_processor_if &ci,
+                       cell_list_t &list, env_c &env) {
+  auto cell = ci.process_cell(list[1], env);
+  return get_handle<channel_cell_c>(keyword, cell, "a channel",
+                                    list[1]->locator)
+      .get_channel();
+}
+
+} // namespace
+
+cell_ptr builtin_fn_task_spawn(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::TASK, >=, 2)
+
+  auto fn = ci.process_cell(list[1], env);
+  if (fn->type != cell_type_e::FUNCTION ||
+      fn->as_function_info().type != function_type_e::LAMBDA_FUNCTION) {
+    throw interpreter_c::exception_c(
+        std::string(nibi::kw::TASK) + " expects a lambda", list[1]->locator);
+  }
+
+  cell_list_t args;
+  for (std::size_t i = 2; i < list.size(); i++) {
+    args.push_back(ci.process_cell(list[i], env));
+  }
+
+  std::set<symbol_id_t> seen;
+  std::vector<capture_s> captures;
+  collect_captures(*fn, env, seen, captures);
+
+  auto task = std::make_shared<task_s>();
+  auto options = ci.get_options();
+  auto locator = list[0]->locator;
+  std::latch copied(1);
+  std::exception_ptr copy_error{nullptr};
+
+  task->thread = std::thread([&, state = task.get(), options, locator]() {
+    source_manager_c source_manager;
+    env_c root;
+    interpreter_c interpreter(root, source_manager, options);
+    isolator_c isolator(root);
+
+    cell_list_t call;
+    try {
+      for (auto &capture : captures) {
+        if (auto copy = isolator.try_isolate(*capture.value)) {
+          root.define(capture.name, copy);
+        }
+      }
+      auto name = allocate_cell(symbol_s{intern_symbol(nibi::kw::TASK)});
+      name->locator = locator;
+      call.push_back(name);
+      for (auto &arg : args) {
+        call.push_back(isolator.isolate(*arg));
+      }
+      auto function = isolator.isolate(*fn);
+
+      // Nothing of the spawning thread is touched past here
+      copied.count_down();
+
+      try {
+        auto result = interpreter.execute_lambda(function, call, root);
+        state->result = pack(*result);
+      } catch (...) {
+        state->error = std::current_exception();
+      }
+    } catch (...) {
+      copy_error = std::current_exception();
+      copied.count_down();
+    }
+  });
+
+  copied.wait();
+  if (copy_error) {
+    task->join();
+    std::rethrow_exception(copy_error);
+  }
+
+  return allocate_cell(static_cast<aberrant_cell_if *>(new task_cell_c(task)));
+}
+
+cell_ptr builtin_fn_task_join(cell_processor_if &ci, cell_list_t &list,
+                              env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::TASK_JOIN, ==, 2)
+
+  auto cell = ci.process_cell(list[1], env);
+  auto &task = get_handle<task_cell_c>(nibi::kw::TASK_JOIN, cell, "a task",
+                                       list[1]->locator)
+                   .get_task();
+  task.join();
+
+  if (task.error) {
+    std::rethrow_exception(task.error);
+  }
+  return unpack(*task.result);
+}
+
+cell_ptr builtin_fn_chan_create(cell_processor_if &ci, cell_list_t &list,
+                                env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::CHAN, ==, 2)
+
+  auto capacity = ci.process_cell(list[1], env)->as_integer();
+  if (capacity < 1) {
+    throw interpreter_c::exception_c(
+        std::string(nibi::kw::CHAN) + " expects a capacity of at least 1",
+        list[1]->locator);
+  }
+  return allocate_cell(static_cast<aberrant_cell_if *>(
+      new channel_cell_c(std::make_shared<channel_c>(capacity))));
+}
+
+cell_ptr builtin_fn_chan_send(cell_processor_if &ci, cell_list_t &list,
+                              env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::CHAN_SEND, ==, 3)
+
+  auto &channel = get_channel(nibi::kw::CHAN_SEND, ci, list, env);
+  auto value = ci.process_cell(list[2], env);
+  if (!channel.send(pack(*value))) {
+    throw interpreter_c::exception_c("Can not send to a closed channel",
+                                     list[0]->locator);
+  }
+  return value;
+}
+
+cell_ptr builtin_fn_chan_recv(cell_processor_if &ci, cell_list_t &list,
+                              env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::CHAN_RECV, ==, 2)
+
+  auto &channel = get_channel(nibi::kw::CHAN_RECV, ci, list, env);
+  auto message = channel.receive();
+  if (!message) {
+    return allocate_cell(cell_type_e::NIL);
+  }
+  return unpack(*message);
+}
+
+cell_ptr builtin_fn_chan_close(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::CHAN_CLOSE, ==, 2)
+
+  get_channel(nibi::kw::CHAN_CLOSE, ci, list, env).close();
+  return allocate_cell(cell_type_e::NIL);
+}
+
+} // namespace builtins
+} // namespace nibi
@@ -0,0 +1,458 @@
+#include "vector_kernels.hpp"
+
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__GNUC__) || defined(__clang__))
+#define VECTOR_KERNELS_X86 1
+#include <immintrin.h>
+#else
+#define VECTOR_KERNELS_X86 0
+#endif
+
+namespace nibi {
+namespace builtins {
+
+namespace {
+
+// Scalar kernels, used on their own where no instruction set is supported
+// and to finish whatever is left over by the wider kernels.
+// Integers wrap on overflow the same way that the vector lanes do
+
+inline int64_t wrapping_add(int64_t a, int64_t b) {
+  return (int64_t)((uint64_t)a + (uint64_t)b);
+}
+
+inline int64_t wrapping_sub(int64_t a, int64_t b) {
+  return (int64_t)((uint64_t)a - (uint64_t)b);
+}
+
+inline int64_t wrapping_mul(int64_t a, int64_t b) {
+  return (int64_t)((uint64_t)a * (uint64_t)b);
+}
+
+void scalar_add_f64(const double *a, const double *b, double *out,
+                    std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    out[i] = a[i] + b[i];
+  }
+}
+
+void scalar_sub_f64(const double *a, const double *b, double *out,
+                    std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    out[i] = a[i] - b[i];
+  }
+}
+
+void scalar_mul_f64(const double *a, const double *b, double *out,
+                    std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    out[i] = a[i] * b[i];
+  }
+}
+
+void scalar_div_f64(const double *a, const double *b, double *out,
+                    std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    out[i] = a[i] / b[i];
+  }
+}
+
+void scalar_scale_f64(const double *a, double k, double *out, std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    out[i] = a[i] * k;
+  }
+}
+
+double scalar_dot_f64(const double *a, const double *b, std::size_t n) {
+  double result = 0.0;
+  for (std::size_t i = 0; i < n; i++) {
+    result += a[i] * b[i];
+  }
+  return result;
+}
+
+double scalar_sum_f64(const double *a, std::size_t n) {
+  double result = 0.0;
+  for (std::size_t i = 0; i < n; i++) {
+    result += a[i];
+  }
+  return result;
+}
+
+double scalar_min_f64(const double *a, std::size_t n) {
+  return *std::min_element(a, a + n);
+}
+
+double scalar_max_f64(const double *a, std::size_t n) {
+  return *std::max_element(a, a + n);
+}
+
+void scalar_add_i64(const int64_t *a, const int64_t *b, int64_t *out,
+                    std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    out[i] = wrapping_add(a[i], b[i]);
+  }
+}
+
+void scalar_sub_i64(const int64_t *a, const int64_t *b, int64_t *out,
+                    std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    out[i] = wrapping_sub(a[i], b[i]);
+  }
+}
+
+void scalar_mul_i64(const int64_t *a, const int64_t *b, int64_t *out,
+                    std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    out[i] = wrapping_mul(a[i], b[i]);
+  }
+}
+
+void scalar_div_i64(const int64_t *a, const int64_t *b, int64_t *out,
+                    std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    out[i] = a[i] / b[i];
+  }
+}
+
+void scalar_scale_i64(const int64_t *a, int64_t k, int64_t *out,
+                      std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    out[i] = wrapping_mul(a[i], k);
+  }
+}
+
+int64_t scalar_dot_i64(const int64_t *a, const int64_t *b, std::size_t n) {
+  int64_t result = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    result = wrapping_add(result, wrapping_mul(a[i], b[i]));
+  }
+  return result;
+}
+
+int64_t scalar_sum_i64(const int64_t *a, std::size_t n) {
+  int64_t result = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    result = wrapping_add(result, a[i]);
+  }
+  return result;
+}
+
+int64_t scalar_min_i64(const int64_t *a, std::size_t n) {
+  return *std::min_element(a, a + n);
+}
+
+int64_t scalar_max_i64(const int64_t *a, std::size_t n) {
+  return *std::max_element(a, a + n);
+}
+
+const vector_kernels_s scalar_kernels = {
+    "scalar",       scalar_add_f64, scalar_sub_f64,   scalar_mul_f64,
+    scalar_div_f64, scalar_scale_f64, scalar_dot_f64, scalar_sum_f64,
+    scalar_min_f64, scalar_max_f64, scalar_add_i64,   scalar_sub_i64,
+    scalar_mul_i64, scalar_div_i64, scalar_scale_i64, scalar_dot_i64,
+    scalar_sum_i64, scalar_min_i64, scalar_max_i64};
+
+#if VECTOR_KERNELS_X86
+
+// Kernels for a given register width. Lanes are processed for as
+// long as there are enough items left to fill a register, and the
+// scalar kernels finish the rest. Integer multiplication has no lane
+// wide instruction before AVX-512 so it is always left scalar
+
+#define VECTOR_BINARY_KERNEL(___name, ___target, ___type, ___width, ___load,   \
+                             ___store, ___op, ___scalar)                       \
+  ___target void ___name(const ___type *a, const ___type *b, ___type *out,    \
+                         std::size_t n) {                                      \
+    std::size_t i = 0;                                                         \
+    for (; i + ___width <= n; i += ___width) {                                 \
+      ___store(out + i, ___op(___load(a + i), ___load(b + i)));                \
+    }                                                                          \
+    ___scalar(a + i, b + i, out + i, n - i);                                   \
+  }
+
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+SSE2_TARGET inline __m128i sse2_load_i64(const int64_t *p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+SSE2_TARGET inline void sse2_store_i64(int64_t *p, __m128i v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+}
+
+AVX2_TARGET inline __m256i avx2_load_i64(const int64_t *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+AVX2_TARGET inline void avx2_store_i64(int64_t *p, __m256i v) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+}
+
+// SSE2, two lanes per register
+
+VECTOR_BINARY_KERNEL(sse2_add_f64, SSE2_TARGET, double, 2, _mm_loadu_pd,
+                     _mm_storeu_pd, _mm_add_pd, scalar_add_f64)
+VECTOR_BINARY_KERNEL(sse2_sub_f64, SSE2_TARGET, double, 2, _mm_loadu_pd,
+                     _mm_storeu_pd, _mm_sub_pd, scalar_sub_f64)
+VECTOR_BINARY_KERNEL(sse2_mul_f64, SSE2_TARGET, double, 2, _mm_loadu_pd,
+                     _mm_storeu_pd, _mm_mul_pd, scalar_mul_f64)
+VECTOR_BINARY_KERNEL(sse2_div_f64, SSE2_TARGET, double, 2, _mm_loadu_pd,
+                     _mm_storeu_pd, _mm_div_pd, scalar_div_f64)
+VECTOR_BINARY_KERNEL(sse2_add_i64, SSE2_TARGET, int64_t, 2, sse2_load_i64,
+                     sse2_store_i64, _mm_add_epi64, scalar_add_i64)
+VECTOR_BINARY_KERNEL(sse2_sub_i64, SSE2_TARGET, int64_t, 2, sse2_load_i64,
+                     sse2_store_i64, _mm_sub_epi64, scalar_sub_i64)
+
+SSE2_TARGET void sse2_scale_f64(const double *a, double k, double *out,
+                                std::size_t n) {
+  auto factor = _mm_set1_pd(k);
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), factor));
+  }
+  scalar_scale_f64(a + i, k, out + i, n - i);
+}
+
+SSE2_TARGET double sse2_dot_f64(const double *a, const double *b,
+                                std::size_t n) {
+  auto acc = _mm_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    acc = _mm_add_pd(acc,
+                     _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+  }
+  alignas(16) double lanes[2];
+  _mm_store_pd(lanes, acc);
+  return lanes[0] + lanes[1] + scalar_dot_f64(a + i, b + i, n - i);
+}
+
+SSE2_TARGET double sse2_sum_f64(const double *a, std::size_t n) {
+  auto acc = _mm_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    acc = _mm_add_pd(acc, _mm_loadu_pd(a + i));
+  }
+  alignas(16) double lanes[2];
+  _mm_store_pd(lanes, acc);
+  return lanes[0] + lanes[1] + scalar_sum_f64(a + i, n - i);
+}
+
+SSE2_TARGET double sse2_min_f64(const double *a, std::size_t n) {
+  if (n < 2) {
+    return scalar_min_f64(a, n);
+  }
+  auto acc = _mm_loadu_pd(a);
+  std::size_t i = 2;
+  for (; i + 2 <= n; i += 2) {
+    acc = _mm_min_pd(acc, _mm_loadu_pd(a + i));
+  }
+  alignas(16) double lanes[2];
+  _mm_store_pd(lanes, acc);
+  auto result = std::min(lanes[0], lanes[1]);
+  return i < n ? std::min(result, scalar_min_f64(a + i, n - i)) : result;
+}
+
+SSE2_TARGET double sse2_max_f64(const double *a, std::size_t n) {
+  if (n < 2) {
+    return scalar_max_f64(a, n);
+  }
+  auto acc = _mm_loadu_pd(a);
+  std::size_t i = 2;
+  for (; i + 2 <= n; i += 2) {
+    acc = _mm_max_pd(acc, _mm_loadu_pd(a + i));
+  }
+  alignas(16) double lanes[2];
+  _mm_store_pd(lanes, acc);
+  auto result = std::max(lanes[0], lanes[1]);
+  return i < n ? std::max(result, scalar_max_f64(a + i, n - i)) : result;
+}
+
+SSE2_TARGET int64_t sse2_sum_i64(const int64_t *a, std::size_t n) {
+  auto acc = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    acc = _mm_add_epi64(acc, sse2_load_i64(a + i));
+  }
+  alignas(16) int64_t lanes[2];
+  sse2_store_i64(lanes, acc);
+  return wrapping_add(wrapping_add(lanes[0], lanes[1]),
+                      scalar_sum_i64(a + i, n - i));
+}
+
+// SSE2 has no 64-bit integer comparison, so integer minimums and
+// maximums are left scalar
+
+const vector_kernels_s sse2_kernels = {
+    "sse2",         sse2_add_f64,   sse2_sub_f64,     sse2_mul_f64,
+    sse2_div_f64,   sse2_scale_f64, sse2_dot_f64,     sse2_sum_f64,
+    sse2_min_f64,   sse2_max_f64,   sse2_add_i64,     sse2_sub_i64,
+    scalar_mul_i64, scalar_div_i64, scalar_scale_i64, scalar_dot_i64,
+    sse2_sum_i64,   scalar_min_i64, scalar_max_i64};
+
+// AVX2, four lanes per register
+
+VECTOR_BINARY_KERNEL(avx2_add_f64, AVX2_TARGET, double, 4, _mm256_loadu_pd,
+                     _mm256_storeu_pd, _mm256_add_pd, scalar_add_f64)
+VECTOR_BINARY_KERNEL(avx2_sub_f64, AVX2_TARGET, double, 4, _mm256_loadu_pd,
+                     _mm256_storeu_pd, _mm256_sub_pd, scalar_sub_f64)
+VECTOR_BINARY_KERNEL(avx2_mul_f64, AVX2_TARGET, double, 4, _mm256_loadu_pd,
+                     _mm256_storeu_pd, _mm256_mul_pd, scalar_mul_f64)
+VECTOR_BINARY_KERNEL(avx2_div_f64, AVX2_TARGET, double, 4, _mm256_loadu_pd,
+                     _mm256_storeu_pd, _mm256_div_pd, scalar_div_f64)
+VECTOR_BINARY_KERNEL(avx2_add_i64, AVX2_TARGET, int64_t, 4, avx2_load_i64,
+                     avx2_store_i64, _mm256_add_epi64, scalar_add_i64)
+VECTOR_BINARY_KERNEL(avx2_sub_i64, AVX2_TARGET, int64_t, 4, avx2_load_i64,
+                     avx2_store_i64, _mm256_sub_epi64, scalar_sub_i64)
+
+AVX2_TARGET void avx2_scale_f64(const double *a, double k, double *out,
+                                std::size_t n) {
+  auto factor = _mm256_set1_pd(k);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), factor));
+  }
+  scalar_scale_f64(a + i, k, out + i, n - i);
+}
+
+AVX2_TARGET double avx2_dot_f64(const double *a, const double *b,
+                                std::size_t n) {
+  auto acc = _mm256_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    acc = _mm256_add_pd(
+        acc, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+  }
+  alignas(32) double lanes[4];
+  _mm256_store_pd(lanes, acc);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+         scalar_dot_f64(a + i, b + i, n - i);
+}
+
+AVX2_TARGET double avx2_sum_f64(const double *a, std::size_t n) {
+  auto acc = _mm256_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    acc = _mm256_add_pd(acc, _mm256_loadu_pd(a + i));
+  }
+  alignas(32) double lanes[4];
+  _mm256_store_pd(lanes, acc);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) +
+         scalar_sum_f64(a + i, n - i);
+}
+
+AVX2_TARGET double avx2_min_f64(const double *a, std::size_t n) {
+  if (n < 4) {
+    return scalar_min_f64(a, n);
+  }
+  auto acc = _mm256_loadu_pd(a);
+  std::size_t i = 4;
+  for (; i + 4 <= n; i += 4) {
+    acc = _mm256_min_pd(acc, _mm256_loadu_pd(a + i));
+  }
+  alignas(32) double lanes[4];
+  _mm256_store_pd(lanes, acc);
+  auto result = std::min(std::min(lanes[0], lanes[1]),
+                         std::min(lanes[2], lanes[3]));
+  return i < n ? std::min(result, scalar_min_f64(a + i, n - i)) : result;
+}
+
+AVX2_TARGET double avx2_max_f64(const double *a, std::size_t n) {
+  if (n < 4) {
+    return scalar_max_f64(a, n);
+  }
+  auto acc = _mm256_loadu_pd(a);
+  std::size_t i = 4;
+  for (; i + 4 <= n; i += 4) {
+    acc = _mm256_max_pd(acc, _mm256_loadu_pd(a + i));
+  }
+  alignas(32) double lanes[4];
+  _mm256_store_pd(lanes, acc);
+  auto result = std::max(std::max(lanes[0], lanes[1]),
+                         std::max(lanes[2], lanes[3]));
+  return i < n ? std::max(result, scalar_max_f64(a + i, n - i)) : result;
+}
+
+AVX2_TARGET int64_t avx2_sum_i64(const int64_t *a, std::size_t n) {
+  auto acc = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    acc = _mm256_add_epi64(acc, avx2_load_i64(a + i));
+  }
+  alignas(32) int64_t lanes[4];
+  avx2_store_i64(lanes, acc);
+  auto result = wrapping_add(wrapping_add(lanes[0], lanes[1]),
+                             wrapping_add(lanes[2], lanes[3]));
+  return wrapping_add(result, scalar_sum_i64(a + i, n - i));
+}
+
+AVX2_TARGET int64_t avx2_min_i64(const int64_t *a, std::size_t n) {
+  if (n < 4) {
+    return scalar_min_i64(a, n);
+  }
+  auto acc = avx2_load_i64(a);
+  std::size_t i = 4;
+  for (; i + 4 <= n; i += 4) {
+    auto next = avx2_load_i64(a + i);
+    acc = _mm256_blendv_epi8(acc, next, _mm256_cmpgt_epi64(acc, next));
+  }
+  alignas(32) int64_t lanes[4];
+  avx2_store_i64(lanes, acc);
+  auto result = *std::min_element(lanes, lanes + 4);
+  return i < n ? std::min(result, scalar_min_i64(a + i, n - i)) : result;
+}
+
+AVX2_TARGET int64_t avx2_max_i64(const int64_t *a, std::size_t n) {
+  if (n < 4) {
+    return scalar_max_i64(a, n);
+  }
+  auto acc = avx2_load_i64(a);
+  std::size_t i = 4;
+  for (; i + 4 <= n; i += 4) {
+    auto next = avx2_load_i64(a + i);
+    acc = _mm256_blendv_epi8(acc, next, _mm256_cmpgt_epi64(next, acc));
+  }
+  alignas(32) int64_t lanes[4];
+  avx2_store_i64(lanes, acc);
+  auto result = *std::max_element(lanes, lanes + 4);
+  return i < n ? std::max(result, scalar_max_i64(a + i, n - i)) : result;
+}
+
+const vector_kernels_s avx2_kernels = {
+    "avx2",         avx2_add_f64,   avx2_sub_f64,     avx2_mul_f64,
+    avx2_div_f64,   avx2_scale_f64, avx2_dot_f64,     avx2_sum_f64,
+    avx2_min_f64,   avx2_max_f64,   avx2_add_i64,     avx2_sub_i64,
+    scalar_mul_i64, scalar_div_i64, scalar_scale_i64, scalar_dot_i64,
+    avx2_sum_i64,   avx2_min_i64,   avx2_max_i64};
+
+#undef VECTOR_BINARY_KERNEL
+#undef SSE2_TARGET
+#undef AVX2_TARGET
+
+#endif
+
+const vector_kernels_s &select_vector_kernels() {
+#if VECTOR_KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return avx2_kernels;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return sse2_kernels;
+  }
+#endif
+  return scalar_kernels;
+}
+
+} // namespace
+
+const vector_kernels_s &get_vector_kernels() {
+  static const vector_kernels_s &kernels = select_vector_kernels();
+  return kernels;
+}
+
+} // namespace builtins
+} // namespace nibi
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nibi {
+namespace builtins {
+
+//! \brief Kernels performing arithmetic over contiguous numbers
+//! \note  Reductions over empty input are left to the caller, and
+//!        doubles may be summed in a different order than written
+struct vector_kernels_s {
+  using binary_f64_t = void (*)(const double *, const double *, double *,
+                                std::size_t);
+  using binary_i64_t = void (*)(const int64_t *, const int64_t *, int64_t *,
+                                std::size_t);
+  using scale_f64_t = void (*)(const double *, double, double *, std::size_t);
+  using scale_i64_t = void (*)(const int64_t *, int64_t, int64_t *,
+                               std::size_t);
+  using dot_f64_t = double (*)(const double *, const double *, std::size_t);
+  using dot_i64_t = int64_t (*)(const int64_t *, const int64_t *,
+                                std::size_t);
+  using reduce_f64_t = double (*)(const double *, std::size_t);
+  using reduce_i64_t = int64_t (*)(const int64_t *, std::size_t);
+
+  const char *name;
+
+  binary_f64_t add_f64;
+  binary_f64_t sub_f64;
+  binary_f64_t mul_f64;
+  binary_f64_t div_f64;
+  scale_f64_t scale_f64;
+  dot_f64_t dot_f64;
+  reduce_f64_t sum_f64;
+  reduce_f64_t min_f64;
+  reduce_f64_t max_f64;
+
+  binary_i64_t add_i64;
+  binary_i64_t sub_i64;
+  binary_i64_t mul_i64;
+  binary_i64_t div_i64;
+  scale_i64_t scale_i64;
+  dot_i64_t dot_i64;
+  reduce_i64_t sum_i64;
+  reduce_i64_t min_i64;
+  reduce_i64_t max_i64;
+};
+
+//! \brief Get the kernels for the best instruction set
+//!        that the processor supports
+//! \note  The instruction set is detected once, on first use
+extern const vector_kernels_s &get_vector_kernels();
+
+} // namespace builtins
+} // namespace nibi
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "interpreter/builtins/builtins.hpp"
+#include "interpreter/interpreter.hpp"
+#include "libnibi/cell.hpp"
+#include "libnibi/keywords.hpp"
+#include "macros.hpp"
+#include "vector_kernels.hpp"
+
+namespace nibi {
+namespace builtins {
+
+namespace {
+
+// The numbers of a list argument. Lists that hold their items unboxed
+// are read in place, any other list has its numbers gathered once.
+// All arguments are processed before any are read, as processing one
+// could modify the storage of another
+struct vector_operand_s {
+  cell_ptr cell{nullptr};
+  cell_type_e type{cell_type_e::INTEGER};
+  std::size_t size{0};
+  const int64_t *integers{nullptr};
+  const double *doubles{nullptr};
+  std::vector<int64_t> gathered_integers;
+  std::vector<double> gathered_doubles;
+
+  // Get the numbers as doubles, converting integers if needed
+  const double *as_doubles() {
+    if (type == cell_type_e::INTEGER) {
+      gathered_doubles.assign(integers, integers + size);
+      doubles = gathered_doubles.data();
+      type = cell_type_e::DOUBLE;
+    }
+    return doubles;
+  }
+};
+
+void read_operand(const char *keyword, cell_list_t &list, std::size_t index,
+                  vector_operand_s &operand) {
+  if (auto *numeric = operand.cell->read_numeric_list()) {
+    operand.type = numeric->type;
+    operand.size = numeric->size();
+    operand.integers = numeric->integers.data();
+    operand.doubles = numeric->doubles.data();
+    return;
+  }
+
+  auto &items = operand.cell->read_list_info().list;
+  operand.size = items.size();
+
+  for (auto &&item : items) {
+    if (!item->is_numeric()) {
+      throw interpreter_c::exception_c(
+          std::string(keyword) + " expects a list of numbers",
+          list[index]->locator);
+    }
+    if (item->type == cell_type_e::DOUBLE) {
+      operand.type = cell_type_e::DOUBLE;
+    }
+  }
+
+  if (operand.type == cell_type_e::INTEGER) {
+    operand.gathered_integers.reserve(operand.size);
+    for (auto &&item : items) {
+      operand.gathered_integers.push_back(item->data.i);
+    }
+    operand.integers = operand.gathered_integers.data();
+    return;
+  }
+
+  operand.gathered_doubles.reserve(operand.size);
+  for (auto &&item : items) {
+    operand.gathered_doubles.push_back(item->to_double());
+  }
+  operand.doubles = operand.gathered_doubles.data();
+}
+
+template <typename T>
+cell_ptr make_vector_result(std::vector<T> items, const locator_ptr &locator) {
+  list_info_s result_info(list_types_e::DATA);
+#if CELL_LIST_USE_NUMERIC_STORAGE
+  result_info.numeric = std::make_unique<numeric_list_s>(std::move(items));
+#else
+  for (auto &&item : items) {
+    result_info.list.push_back(allocate_cell(item));
+  }
+#endif
+  auto result = allocate_cell(std::move(result_info));
+  result->locator = locator;
+  return result;
+}
+
+cell_ptr apply_element_wise(cell_processor_if &ci, const char *keyword,
+                            cell_list_t &list, env_c &env,
+                            vector_kernels_s::binary_i64_t integer_kernel,
+                            vector_kernels_s::binary_f64_t double_kernel,
+                            bool is_division) {
+  NIBI_LIST_ENFORCE_SIZE(keyword, ==, 3)
+
+  vector_operand_s lhs;
+  vector_operand_s rhs;
+  lhs.cell = ci.process_cell(list[1], env);
+  rhs.cell = ci.process_cell(list[2], env);
+  read_operand(keyword, list, 1, lhs);
+  read_operand(keyword, list, 2, rhs);
+
+  if (lhs.size != rhs.size) {
+    throw interpreter_c::exception_c(
+        std::string(keyword) + " expects lists of the same length",
+        list[0]->locator);
+  }
+
+  if (lhs.type == cell_type_e::INTEGER && rhs.type == cell_type_e::INTEGER) {
+    if (is_division &&
+        std::find(rhs.integers, rhs.integers + rhs.size, 0) !=
+            rhs.integers + rhs.size) {
+      throw interpreter_c::exception_c("Division by zero", list[2]->locator);
+    }
+    std::vector<int64_t> result(lhs.size);
+    integer_kernel(lhs.integers, rhs.integers, result.data(), lhs.size);
+    return make_vector_result(std::move(result), list[0]->locator);
+  }
+
+  auto *lhs_doubles = lhs.as_doubles();
+  auto *rhs_doubles = rhs.as_doubles();
+  if (is_division && std::find(rhs_doubles, rhs_doubles + rhs.size, 0.0) !=
+                         rhs_doubles + rhs.size) {
+    throw interpreter_c::exception_c("Division by zero", list[2]->locator);
+  }
+  std::vector<double> result(lhs.size);
+  double_kernel(lhs_doubles, rhs_doubles, result.data(), lhs.size);
+  return make_vector_result(std::move(result), list[0]->locator);
+}
+
+// Reductions that have no meaning for an empty list
+void enforce_not_empty(const char *keyword, vector_operand_s &operand,
+                       cell_list_t &list) {
+  if (operand.size == 0) {
+    throw interpreter_c::exception_c(
+        std::string(keyword) + " expects a list that is not empty",
+        list[1]->locator);
+  }
+}
+
+} // namespace
+
+cell_ptr builtin_fn_vector_add(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  auto &kernels = get_vector_kernels();
+  return apply_element_wise(ci, nibi::kw::VEC_ADD, list, env, kernels.add_i64,
+                            kernels.add_f64, false);
+}
+
+cell_ptr builtin_fn_vector_sub(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  auto &kernels = get_vector_kernels();
+  return apply_element_wise(ci, nibi::kw::VEC_SUB, list, env, kernels.sub_i64,
+                            kernels.sub_f64, false);
+}
+
+cell_ptr builtin_fn_vector_mul(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  auto &kernels = get_vector_kernels();
+  return apply_element_wise(ci, nibi::kw::VEC_MUL, list, env, kernels.mul_i64,
+                            kernels.mul_f64, false);
+}
+
+cell_ptr builtin_fn_vector_div(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  auto &kernels = get_vector_kernels();
+  return apply_element_wise(ci, nibi::kw::VEC_DIV, list, env, kernels.div_i64,
+                            kernels.div_f64, true);
+}
+
+cell_ptr builtin_fn_vector_scale(cell_processor_if &ci, cell_list_t &list,
+                                 env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::VEC_SCALE, ==, 3)
+
+  vector_operand_s operand;
+  operand.cell = ci.process_cell(list[1], env);
+
+  value_s factor;
+  ci.process_value(list[2], env, factor);
+  read_operand(nibi::kw::VEC_SCALE, list, 1, operand);
+  if (!factor.is_numeric()) {
+    throw interpreter_c::exception_c(
+        std::string(nibi::kw::VEC_SCALE) + " expects a numeric factor",
+        list[2]->locator);
+  }
+
+  auto &kernels = get_vector_kernels();
+  if (operand.type == cell_type_e::INTEGER &&
+      factor.type == cell_type_e::INTEGER) {
+    std::vector<int64_t> result(operand.size);
+    kernels.scale_i64(operand.integers, factor.i, result.data(), operand.size);
+    return make_vector_result(std::move(result), list[0]->locator);
+  }
+
+  std::vector<double> result(operand.size);
+  kernels.scale_f64(operand.as_doubles(), factor.to_double(), result.data(),
+                    operand.size);
+  return make_vector_result(std::move(result), list[0]->locator);
+}
+
+cell_ptr builtin_fn_vector_dot(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::VEC_DOT, ==, 3)
+
+  vector_operand_s lhs;
+  vector_operand_s rhs;
+  lhs.cell = ci.process_cell(list[1], env);
+  rhs.cell = ci.process_cell(list[2], env);
+  read_operand(nibi::kw::VEC_DOT, list, 1, lhs);
+  read_operand(nibi::kw::VEC_DOT, list, 2, rhs);
+
+  if (lhs.size != rhs.size) {
+    throw interpreter_c::exception_c(
+        std::string(nibi::kw::VEC_DOT) + " expects lists of the same length",
+        list[0]->locator);
+  }
+
+  auto &kernels = get_vector_kernels();
+  if (lhs.type == cell_type_e::INTEGER && rhs.type == cell_type_e::INTEGER) {
+    return allocate_cell(kernels.dot_i64(lhs.integers, rhs.integers, lhs.size));
+  }
+  return allocate_cell(
+      kernels.dot_f64(lhs.as_doubles(), rhs.as_doubles(), lhs.size));
+}
+
+cell_ptr builtin_fn_vector_sum(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::VEC_SUM, ==, 2)
+
+  vector_operand_s operand;
+  operand.cell = ci.process_cell(list[1], env);
+  read_operand(nibi::kw::VEC_SUM, list, 1, operand);
+
+  auto &kernels = get_vector_kernels();
+  if (operand.type == cell_type_e::INTEGER) {
+    return allocate_cell(kernels.sum_i64(operand.integers, operand.size));
+  }
+  return allocate_cell(kernels.sum_f64(operand.doubles, operand.size));
+}
+
+cell_ptr builtin_fn_vector_min(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::VEC_MIN, ==, 2)
+
+  vector_operand_s operand;
+  operand.cell = ci.process_cell(list[1], env);
+  read_operand(nibi::kw::VEC_MIN, list, 1, operand);
+  enforce_not_empty(nibi::kw::VEC_MIN, operand, list);
+
+  auto &kernels = get_vector_kernels();
+  if (operand.type == cell_type_e::INTEGER) {
+    return allocate_cell(kernels.min_i64(operand.integers, operand.size));
+  }
+  return allocate_cell(kernels.min_f64(operand.doubles, operand.size));
+}
+
+cell_ptr builtin_fn_vector_max(cell_processor_if &ci, cell_list_t &list,
+                               env_c &env) {
+  NIBI_LIST_ENFORCE_SIZE(nibi::kw::VEC_MAX, ==, 2)
+
+  vector_operand_s operand;
+  operand.cell = ci.process_cell(list[1], env);
+  read_operand(nibi::kw::VEC_MAX, list, 1, operand);
+  enforce_not_empty(nibi::kw::VEC_MAX, operand, list);
+
+  auto &kernels = get_vector_kernels();
+  if (operand.type == cell_type_e::INTEGER) {
+    return allocate_cell(kernels.max_i64(operand.integers, operand.size));
+  }
+  return allocate_cell(kernels.max_f64(operand.doubles, operand.size));
+}
+
+} // namespace builtins
+} // namespace nibi
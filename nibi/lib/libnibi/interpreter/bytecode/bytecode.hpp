@@ -0,0 +1,119 @@
+#pragma once
+
+#include "libnibi/cell.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nibi {
+
+//! \brief The number of times a list is executed by walking its
+//!        cells before an attempt is made to compile it
+//! \note  Loops are compiled the first time they are executed
+static constexpr uint32_t BYTECODE_COMPILE_THRESHOLD = 2;
+
+//! \brief Operations carried out by the interpreter when
+//!        executing bytecode. Each operation works on a stack
+//!        of values owned by the current frame
+enum class opcode_e : uint8_t {
+  LOAD_CELL,        // Push the value of cell [a]
+  LOAD_SYMBOL,      // Push the cell bound to symbol [a], cell [b] is the
+                    // source of the symbol for error reporting
+  LOAD_LOCAL,       // Push local [a], falling back to its symbol when the
+                    // local is not set. Cell [b] is as above
+  LOAD_NIL,         // Push a new nil cell
+  LOAD_LAST_RESULT, // Push the last result of the interpreter
+  EVALUATE,         // Walk cell [a] and push the result, [b] indicates
+                    // that data lists should be processed
+  APPLY,            // Pop [b] arguments, apply call [a] and push the result
+  SET,              // Pop a value and a target, update the target in place
+                    // and push it
+  ASSIGN,           // Pop a value and bind a copy of it to symbol [a] with
+                    // cell [b] as the source of the value
+  POP,              // Discard the top of the stack
+  SCOPE,            // Execute up to [a] in a new environment holding
+                    // the locals of layout [b]
+  JUMP,             // Continue at [a]
+  JUMP_IF_NOT_POSITIVE, // Pop a value and continue at [a] if it is <= 0
+  BRANCH,               // As above, but the value must be an integer, cell
+                        // [b] is the source of the condition
+};
+
+//! \brief A single bytecode instruction
+struct instruction_s {
+  opcode_e op;
+  uint32_t a{0};
+  uint32_t b{0};
+};
+
+//! \brief A call to a builtin that is applied to arguments
+//!        that have already been evaluated
+//! \note  The instruction list may be the list that was compiled,
+//!        so it is not held to avoid a reference cycle
+struct apply_call_s {
+  apply_fn_t fn;
+  cell_list_t *list;
+};
+
+//! \brief A symbol that has been resolved to a slot of an environment
+//!        that is a known number of environments above the one that
+//!        the reference is executed in
+//! \note  Locals of the frame environment are only used when the
+//!        bytecode is executed in an environment with the layout that
+//!        it was compiled against
+struct local_s {
+  uint32_t symbol;
+  uint32_t depth;
+  uint32_t slot;
+  bool in_frame;
+};
+
+//! \brief An instruction list that was compiled natively, along with the
+//!        one it was compiled within, so that the call trace of an error
+//!        raised by its code can be rebuilt
+//! \note  The tree walker marks every call on the call stack as it makes
+//!        it, compiled code leaves that until an error is raised
+struct trace_frame_s {
+  cell_ptr operation;
+  uint32_t parent;
+};
+
+//! \brief Marks code that wasn't compiled within any instruction list
+static constexpr uint32_t BYTECODE_NO_TRACE =
+    std::numeric_limits<uint32_t>::max();
+
+//! \brief The compiled form of a list
+//! \note  Bytecode is owned by the list it was compiled from,
+//!        and only ever references cells within that list
+struct bytecode_s {
+  std::vector<instruction_s> code;
+  std::vector<uint32_t> code_traces; // The trace frame of each instruction
+  std::vector<trace_frame_s> traces;
+  std::vector<cell_ptr> cells;
+  std::vector<apply_call_s> calls;
+  std::vector<symbol_id_t> symbols;
+  std::vector<local_s> locals;
+  std::vector<std::shared_ptr<const env_layout_t>> layouts;
+  std::shared_ptr<const env_layout_t> frame_layout{nullptr};
+  std::size_t stack_size{0};
+};
+
+//! \brief Compile a list into bytecode
+//! \param list The list to compile
+//! \param process_data_list If true, the list is compiled as a body
+//!        where each item of a data list is processed
+//! \param frame_layout The layout of the environment the list is
+//!        being executed in, used to resolve symbols to its slots
+//! \returns The compiled list, or nullptr if it contains nothing that
+//!          would execute any faster than walking its cells
+extern std::shared_ptr<bytecode_s>
+compile_bytecode(const cell_ptr &list, bool process_data_list,
+                 const std::shared_ptr<const env_layout_t> &frame_layout);
+
+//! \brief Check if a list should be compiled the first time it is executed
+extern bool is_compiled_eagerly(const list_info_s &list_info);
+
+} // namespace nibi
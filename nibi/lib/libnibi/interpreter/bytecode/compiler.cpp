@@ -0,0 +1,431 @@
+#include "bytecode.hpp"
+
+#include "interpreter/builtins/builtins.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace nibi {
+
+namespace {
+
+// Get the builtin at the head of an instruction list, if there is one
+cell_fn_t get_builtin(const list_info_s &list_info) {
+  if (list_info.type != list_types_e::INSTRUCTION || list_info.list.empty()) {
+    return nullptr;
+  }
+
+  auto &operation = list_info.list.front();
+  if (operation->type != cell_type_e::FUNCTION ||
+      operation->data.fn->type != function_type_e::BUILTIN_CPP_FUNCTION) {
+    return nullptr;
+  }
+
+  return operation->data.fn->fn;
+}
+
+inline bool is_data_list(const cell_ptr &cell) {
+  return cell->type == cell_type_e::LIST &&
+         cell->data.list->value.type == list_types_e::DATA;
+}
+
+//! \brief Lowers a list of cells into bytecode
+//! \note  Instructions that are not understood by the compiler
+//!        are left for the tree walker through EVALUATE, so
+//!        anything that can be parsed can be compiled
+class compiler_c {
+public:
+  compiler_c(const std::shared_ptr<const env_layout_t> &frame_layout)
+      : program_(std::make_shared<bytecode_s>()) {
+    program_->frame_layout = frame_layout;
+  }
+
+  std::shared_ptr<bytecode_s> compile(const cell_ptr &list,
+                                      bool process_data_list) {
+    expression(list, process_data_list);
+
+    // If everything would be handed back to the tree walker then
+    // there is nothing to gain from executing the bytecode
+    if (!native_operations_) {
+      return nullptr;
+    }
+
+    // Scopes without locals don't need any slots
+    for (auto &layout : program_->layouts) {
+      if (layout->empty()) {
+        layout = nullptr;
+      }
+    }
+    return program_;
+  }
+
+private:
+  // A scope that will be given its own environment, along with
+  // the locals that have been resolved to its slots
+  struct scope_s {
+    std::shared_ptr<env_layout_t> layout;
+    std::unordered_map<symbol_id_t, uint32_t> slots;
+  };
+
+  std::shared_ptr<bytecode_s> program_;
+  std::unordered_map<symbol_id_t, uint32_t> symbol_slots_;
+  std::vector<scope_s> scopes_;
+  std::size_t depth_{0};
+  std::size_t native_operations_{0};
+  uint32_t trace_{BYTECODE_NO_TRACE};
+
+  uint32_t emit(opcode_e op, uint32_t a = 0, uint32_t b = 0) {
+    program_->code.push_back({op, a, b});
+    program_->code_traces.push_back(trace_);
+    return program_->code.size() - 1;
+  }
+
+  uint32_t here() const { return program_->code.size(); }
+
+  void patch(uint32_t instruction, uint32_t target) {
+    program_->code[instruction].a = target;
+  }
+
+  void push() {
+    depth_++;
+    program_->stack_size = std::max(program_->stack_size, depth_);
+  }
+
+  void pop(std::size_t count = 1) { depth_ -= count; }
+
+  uint32_t add_cell(const cell_ptr &cell) {
+    program_->cells.push_back(cell);
+    return program_->cells.size() - 1;
+  }
+
+  // Each symbol is given a slot per frame so that it only
+  // has to be looked up in the environment once
+  uint32_t add_symbol(const symbol_id_t name) {
+    auto it = symbol_slots_.find(name);
+    if (it != symbol_slots_.end()) {
+      return it->second;
+    }
+    program_->symbols.push_back(name);
+    uint32_t slot = program_->symbols.size() - 1;
+    symbol_slots_[name] = slot;
+    return slot;
+  }
+
+  // Open a scope, returning the SCOPE instruction to be patched
+  // with the end of the scope once its contents are emitted
+  uint32_t open_scope() {
+    auto layout = std::make_shared<env_layout_t>();
+    program_->layouts.push_back(layout);
+    scopes_.push_back({layout, {}});
+    return emit(opcode_e::SCOPE, 0, program_->layouts.size() - 1);
+  }
+
+  void close_scope(uint32_t scope) {
+    scopes_.pop_back();
+    patch(scope, here());
+  }
+
+  // Resolve a symbol to a local of an enclosing scope or of the frame
+  // environment, returning false if it can only be found by name
+  bool resolve(const symbol_id_t name, local_s &local);
+
+  // Give a symbol a slot in the innermost scope, as long as it wouldn't
+  // already be found in one of the scopes above
+  void declare(const symbol_id_t name);
+
+  // Emit the code for a cell, leaving a single value on the stack
+  void expression(const cell_ptr &cell, bool process_data_list);
+
+  // Hand a cell to the tree walker
+  void evaluate(const cell_ptr &cell, bool process_data_list) {
+    emit(opcode_e::EVALUATE, add_cell(cell), process_data_list);
+    push();
+  }
+
+  // Attempt to compile an instruction list natively, returns false
+  // if the instruction list needs to be walked
+  bool instruction(const cell_ptr &cell);
+  bool native_instruction(const cell_ptr &cell);
+
+  bool apply(cell_list_t &list, apply_fn_t fn);
+  bool loop(cell_list_t &list);
+  bool conditional(cell_list_t &list);
+  bool set(cell_list_t &list);
+  bool assign(cell_list_t &list);
+};
+
+void compiler_c::expression(const cell_ptr &cell, bool process_data_list) {
+  switch (cell->type) {
+  case cell_type_e::SYMBOL: {
+    local_s local;
+    if (resolve(cell->data.sym->id, local)) {
+      program_->locals.push_back(local);
+      emit(opcode_e::LOAD_LOCAL, program_->locals.size() - 1, add_cell(cell));
+    } else {
+      emit(opcode_e::LOAD_SYMBOL, add_symbol(cell->data.sym->id),
+           add_cell(cell));
+    }
+    push();
+    return;
+  }
+  case cell_type_e::LIST: {
+    auto &list_info = cell->data.list->value;
+    if (list_info.list.empty()) {
+      break;
+    }
+    switch (list_info.type) {
+    case list_types_e::DATA: {
+      if (!process_data_list) {
+        break;
+      }
+      // Each item is processed and the last result is kept
+      for (std::size_t i = 0; i < list_info.list.size(); i++) {
+        if (i > 0) {
+          emit(opcode_e::POP);
+          pop();
+        }
+        expression(list_info.list[i], false);
+      }
+      return;
+    }
+    case list_types_e::ACCESS:
+      evaluate(cell, false);
+      return;
+    case list_types_e::INSTRUCTION:
+      if (!instruction(cell)) {
+        evaluate(cell, false);
+      }
+      return;
+    }
+    break;
+  }
+  case cell_type_e::DICT:
+    // Not loadable directly, the tree walker will raise the error
+    evaluate(cell, false);
+    return;
+  default:
+    break;
+  }
+
+  // Anything else evaluates to itself
+  emit(opcode_e::LOAD_CELL, add_cell(cell));
+  push();
+}
+
+bool compiler_c::resolve(const symbol_id_t name, local_s &local) {
+  for (std::size_t i = scopes_.size(); i > 0; i--) {
+    auto &scope = scopes_[i - 1];
+    auto it = scope.slots.find(name);
+    if (it != scope.slots.end()) {
+      local = {add_symbol(name), (uint32_t)(scopes_.size() - i), it->second,
+               false};
+      return true;
+    }
+  }
+
+  // The frame environment sits above every scope
+  if (auto &layout = program_->frame_layout) {
+    for (std::size_t i = layout->size(); i > 0; i--) {
+      if ((*layout)[i - 1] == name) {
+        local = {add_symbol(name), (uint32_t)scopes_.size(), (uint32_t)i - 1,
+                 true};
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void compiler_c::declare(const symbol_id_t name) {
+  local_s local;
+  if (scopes_.empty() || resolve(name, local)) {
+    return;
+  }
+
+  // Assignments look through every environment above before
+  // binding in the current one, so the slot is only filled
+  // if the name isn't found elsewhere when executed
+  auto &scope = scopes_.back();
+  scope.slots[name] = scope.layout->size();
+  scope.layout->push_back(name);
+}
+
+bool compiler_c::instruction(const cell_ptr &cell) {
+  auto &list = cell->data.list->value.list;
+
+  // Code emitted for the instruction is traced to its operation. Nothing
+  // is emitted for instructions that are left to be walked
+  auto parent = trace_;
+  program_->traces.push_back({list.front(), parent});
+  trace_ = program_->traces.size() - 1;
+  auto compiled = native_instruction(cell);
+  trace_ = parent;
+  if (!compiled) {
+    program_->traces.pop_back();
+  }
+  return compiled;
+}
+
+bool compiler_c::native_instruction(const cell_ptr &cell) {
+  auto &list_info = cell->data.list->value;
+  auto &list = list_info.list;
+
+  auto &operation = list.front();
+  if (operation->type == cell_type_e::FUNCTION &&
+      operation->data.fn->type == function_type_e::BUILTIN_CPP_FUNCTION &&
+      operation->data.fn->apply_fn) {
+    return apply(list, operation->data.fn->apply_fn);
+  }
+
+  auto builtin = get_builtin(list_info);
+  if (builtin == builtins::builtin_fn_common_loop) {
+    return loop(list);
+  }
+  if (builtin == builtins::builtin_fn_common_if) {
+    return conditional(list);
+  }
+  if (builtin == builtins::builtin_fn_env_set) {
+    return set(list);
+  }
+  if (builtin == builtins::builtin_fn_env_assignment) {
+    return assign(list);
+  }
+  return false;
+}
+
+bool compiler_c::apply(cell_list_t &list, apply_fn_t fn) {
+  // Builtins may process data lists given to them in ways that
+  // can't be determined here, so they are left to be walked
+  for (std::size_t i = 1; i < list.size(); i++) {
+    if (is_data_list(list[i])) {
+      return false;
+    }
+  }
+
+  for (std::size_t i = 1; i < list.size(); i++) {
+    expression(list[i], false);
+  }
+
+  program_->calls.push_back({fn, &list});
+  emit(opcode_e::APPLY, program_->calls.size() - 1, list.size() - 1);
+  pop(list.size() - 1);
+  push();
+  native_operations_++;
+  return true;
+}
+
+bool compiler_c::loop(cell_list_t &list) {
+  // (loop (pre) (cond) (post) (body))
+  if (list.size() != 5) {
+    return false;
+  }
+
+  auto scope = open_scope();
+
+  expression(list[1], false);
+  emit(opcode_e::POP);
+  pop();
+
+  // The result of the loop is nil unless the body is executed
+  emit(opcode_e::LOAD_NIL);
+  push();
+
+  auto condition = here();
+  expression(list[2], false);
+  auto exit = emit(opcode_e::JUMP_IF_NOT_POSITIVE);
+  pop();
+
+  emit(opcode_e::POP);
+  pop();
+  expression(list[4], true);
+
+  expression(list[3], false);
+  emit(opcode_e::POP);
+  pop();
+
+  emit(opcode_e::JUMP, condition);
+
+  patch(exit, here());
+  close_scope(scope);
+  native_operations_++;
+  return true;
+}
+
+bool compiler_c::conditional(cell_list_t &list) {
+  // (if (cond) (true) (false)?)
+  if (list.size() != 3 && list.size() != 4) {
+    return false;
+  }
+
+  auto scope = open_scope();
+
+  expression(list[1], false);
+  auto branch = emit(opcode_e::BRANCH, 0, add_cell(list[1]));
+  pop();
+
+  expression(list[2], true);
+  auto skip = emit(opcode_e::JUMP);
+
+  // Only one of the branches is taken
+  pop();
+
+  patch(branch, here());
+  if (list.size() == 4) {
+    expression(list[3], true);
+  } else {
+    emit(opcode_e::LOAD_LAST_RESULT);
+    push();
+  }
+
+  patch(skip, here());
+  close_scope(scope);
+  native_operations_++;
+  return true;
+}
+
+bool compiler_c::set(cell_list_t &list) {
+  if (list.size() != 3 || list[1]->type != cell_type_e::SYMBOL) {
+    return false;
+  }
+
+  expression(list[1], false);
+  expression(list[2], false);
+  emit(opcode_e::SET);
+  pop(2);
+  push();
+  native_operations_++;
+  return true;
+}
+
+bool compiler_c::assign(cell_list_t &list) {
+  if (list.size() != 3 || list[1]->type != cell_type_e::SYMBOL) {
+    return false;
+  }
+
+  auto name = list[1]->data.sym->id;
+  auto &text = symbol_name(name);
+  if (text[0] == '$' || text[0] == ':') {
+    return false;
+  }
+
+  declare(name);
+
+  expression(list[2], false);
+  emit(opcode_e::ASSIGN, add_symbol(name), add_cell(list[2]));
+  native_operations_++;
+  return true;
+}
+
+} // namespace
+
+std::shared_ptr<bytecode_s>
+compile_bytecode(const cell_ptr &list, bool process_data_list,
+                 const std::shared_ptr<const env_layout_t> &frame_layout) {
+  return compiler_c(frame_layout).compile(list, process_data_list);
+}
+
+bool is_compiled_eagerly(const list_info_s &list_info) {
+  return get_builtin(list_info) == builtins::builtin_fn_common_loop;
+}
+
+} // namespace nibi
@@ -0,0 +1,305 @@
+#include "bytecode.hpp"
+
+#include "interpreter/interpreter.hpp"
+
+namespace nibi {
+
+#if INTERPRETER_USE_BYTECODE
+
+namespace {
+
+// Load a cell onto the stack, keeping the cell so that
+// instructions that return it can return the cell itself
+inline void load_value(value_s &value, const cell_ptr &cell) {
+  value.type = cell->type;
+  switch (cell->type) {
+  case cell_type_e::INTEGER:
+    value.i = cell->data.i;
+    break;
+  case cell_type_e::DOUBLE:
+    value.d = cell->data.d;
+    break;
+  default:
+    break;
+  }
+  value.cell = cell;
+}
+
+} // namespace
+
+interpreter_c::bytecode_frame_s::bytecode_frame_s(interpreter_c &interpreter,
+                                                  bytecode_s &program)
+    : interpreter(interpreter), values(interpreter.bytecode_values_top_),
+      value_count(program.stack_size),
+      slots(interpreter.bytecode_slots_top_),
+      slot_count(program.symbols.size()),
+      call_depth(interpreter.call_stack_.size()) {
+  interpreter.bytecode_values_top_ += value_count;
+  if (interpreter.bytecode_values_.size() < interpreter.bytecode_values_top_) {
+    interpreter.bytecode_values_.resize(interpreter.bytecode_values_top_);
+  }
+  interpreter.bytecode_slots_top_ += slot_count;
+  if (interpreter.bytecode_slots_.size() < interpreter.bytecode_slots_top_) {
+    interpreter.bytecode_slots_.resize(interpreter.bytecode_slots_top_);
+  }
+}
+
+interpreter_c::bytecode_frame_s::~bytecode_frame_s() {
+  // Release anything the frame was holding on to
+  for (std::size_t i = values; i < values + value_count; i++) {
+    interpreter.bytecode_values_[i].cell = nullptr;
+  }
+  for (std::size_t i = slots; i < slots + slot_count; i++) {
+    interpreter.bytecode_slots_[i] = nullptr;
+  }
+  interpreter.bytecode_values_top_ = values;
+  interpreter.bytecode_slots_top_ = slots;
+}
+
+bool interpreter_c::execute_compiled(const cell_ptr &cell,
+                                     list_info_s &list_info, env_c &env,
+                                     value_s &out, bool process_data_list) {
+  if (list_info.type == list_types_e::ACCESS ||
+      (list_info.type == list_types_e::DATA && !process_data_list)) {
+    return false;
+  }
+
+  if (!list_info.bytecode) {
+    // Lists that failed to compile are not attempted again
+    if (list_info.executions > BYTECODE_COMPILE_THRESHOLD) {
+      return false;
+    }
+
+    if (++list_info.executions < BYTECODE_COMPILE_THRESHOLD &&
+        !is_compiled_eagerly(list_info)) {
+      return false;
+    }
+
+    list_info.bytecode =
+        compile_bytecode(cell, process_data_list, env.get_layout());
+    if (!list_info.bytecode) {
+      list_info.executions = BYTECODE_COMPILE_THRESHOLD + 1;
+      return false;
+    }
+  }
+
+  // Keep the bytecode alive in case the list is modified during execution
+  auto program = list_info.bytecode;
+
+  execute_bytecode(*program, env, out);
+  return true;
+}
+
+void interpreter_c::execute_bytecode(bytecode_s &program, env_c &env,
+                                     value_s &out) {
+  bytecode_frame_s frame(*this, program);
+
+  // Locals of the frame environment can only be used if it is laid out
+  // the same way as the environment the bytecode was compiled in
+  frame.frame_resolved =
+      program.frame_layout && env.get_layout() == program.frame_layout;
+
+  std::size_t sp{0};
+  if (run_bytecode(program, 0, program.code.size(), env, frame, sp)) {
+    out = std::move(bytecode_values_[frame.values]);
+  }
+}
+
+const cell_ptr &interpreter_c::lookup_symbol(bytecode_s &program, env_c &env,
+                                             bytecode_frame_s &frame,
+                                             uint32_t symbol,
+                                             uint32_t source) {
+  // Symbols are looked up once and then held in their slot until
+  // something happens that could change what they are bound to
+  auto &slot = bytecode_slots_[frame.slots + symbol];
+  if (!slot) {
+    slot = env.get(program.symbols[symbol]);
+    if (!slot) {
+      throw exception_c("Symbol not found in environment: " +
+                            symbol_name(program.symbols[symbol]),
+                        program.cells[source]->locator);
+    }
+  }
+  return slot;
+}
+
+void interpreter_c::invalidate_slots(bytecode_frame_s &frame) {
+  for (std::size_t i = frame.slots; i < frame.slots + frame.slot_count; i++) {
+    bytecode_slots_[i] = nullptr;
+  }
+}
+
+void interpreter_c::trace_bytecode(bytecode_s &program, std::size_t pc,
+                                   bytecode_frame_s &frame) {
+  // Scopes share the frame, only the innermost one is traced
+  if (frame.traced) {
+    return;
+  }
+  frame.traced = true;
+
+  // Frames are unwound from the innermost out, so a record made by a
+  // frame shallower than this one is left from an error recovered from
+  while (!bytecode_traces_.empty() &&
+         bytecode_traces_.back().call_depth < frame.call_depth) {
+    bytecode_traces_.pop_back();
+  }
+
+  bytecode_trace_s record{frame.call_depth, {}};
+  for (auto trace = program.code_traces[pc]; trace != BYTECODE_NO_TRACE;
+       trace = program.traces[trace].parent) {
+    record.calls.push_back(program.traces[trace].operation);
+  }
+  bytecode_traces_.push_back(std::move(record));
+}
+
+bool interpreter_c::run_bytecode(bytecode_s &program, std::size_t pc,
+                                 const std::size_t end, env_c &env,
+                                 bytecode_frame_s &frame, std::size_t &sp) {
+
+  // The value stack may be reallocated by nested frames, so
+  // values are always accessed relative to the frame
+#define BYTECODE_VALUE(___n) bytecode_values_[frame.values + (___n)]
+
+  // Errors are traced to the instruction that raised them, the
+  // program counter has already moved past it
+  try {
+    while (pc < end) {
+      auto &instruction = program.code[pc++];
+      switch (instruction.op) {
+      case opcode_e::LOAD_CELL: {
+        load_value(BYTECODE_VALUE(sp++), program.cells[instruction.a]);
+        break;
+      }
+      case opcode_e::LOAD_SYMBOL: {
+        load_value(BYTECODE_VALUE(sp++),
+                   lookup_symbol(program, env, frame, instruction.a,
+                                 instruction.b));
+        break;
+      }
+      case opcode_e::LOAD_LOCAL: {
+        auto &local = program.locals[instruction.a];
+        if (!local.in_frame || frame.frame_resolved) {
+          auto *target = &env;
+          for (uint32_t i = 0; i < local.depth; i++) {
+            target = target->get_parent();
+          }
+          if (auto &cell = target->get_local(local.slot)) {
+            load_value(BYTECODE_VALUE(sp++), cell);
+            break;
+          }
+        }
+
+        // Not yet set, so it is bound somewhere above
+        load_value(BYTECODE_VALUE(sp++),
+                   lookup_symbol(program, env, frame, local.symbol,
+                                 instruction.b));
+        break;
+      }
+      case opcode_e::LOAD_NIL: {
+        load_value(BYTECODE_VALUE(sp++), allocate_cell(cell_type_e::NIL));
+        break;
+      }
+      case opcode_e::LOAD_LAST_RESULT: {
+        load_value(BYTECODE_VALUE(sp++), get_last_result());
+        break;
+      }
+      case opcode_e::EVALUATE: {
+        // Builtins that can produce an unboxed value are left to do so
+        value_s result;
+        process_value(program.cells[instruction.a], env, result,
+                      instruction.b);
+
+        // There is no telling what the tree walker did to the environment
+        invalidate_slots(frame);
+
+        if (yield_value_) {
+          return false;
+        }
+        BYTECODE_VALUE(sp++) = std::move(result);
+        break;
+      }
+      case opcode_e::APPLY: {
+        auto &call = program.calls[instruction.a];
+        sp -= instruction.b;
+        value_s result;
+        call.fn(&BYTECODE_VALUE(sp), *call.list, result);
+        BYTECODE_VALUE(sp++) = std::move(result);
+        break;
+      }
+      case opcode_e::SET: {
+        sp -= 2;
+        auto target = BYTECODE_VALUE(sp).cell;
+        target->update_from(BYTECODE_VALUE(sp + 1), env);
+        load_value(BYTECODE_VALUE(sp++), target);
+        break;
+      }
+      case opcode_e::ASSIGN: {
+        // Numeric values are boxed fresh, anything else is explicitly cloned
+        // as we might be reading from an instruction that will be mutated
+        // later
+        auto &value = BYTECODE_VALUE(sp - 1);
+        auto assigned = value.is_numeric()
+                            ? value.box(program.cells[instruction.b]->locator)
+                            : value.cell->clone(env);
+        env.set(program.symbols[instruction.a], assigned);
+        bytecode_slots_[frame.slots + instruction.a] = assigned;
+        load_value(value, assigned);
+        break;
+      }
+      case opcode_e::POP: {
+        BYTECODE_VALUE(--sp).cell = nullptr;
+        break;
+      }
+      case opcode_e::SCOPE: {
+        env_c scope_env(&env, program.layouts[instruction.b], env_slots_);
+        auto completed =
+            run_bytecode(program, pc, instruction.a, scope_env, frame, sp);
+
+        // Anything defined within the scope goes with it
+        if (!scope_env.is_empty()) {
+          invalidate_slots(frame);
+        }
+
+        if (!completed) {
+          return false;
+        }
+        pc = instruction.a;
+        break;
+      }
+      case opcode_e::JUMP: {
+        pc = instruction.a;
+        break;
+      }
+      case opcode_e::JUMP_IF_NOT_POSITIVE: {
+        if (BYTECODE_VALUE(--sp).to_integer() <= 0) {
+          pc = instruction.a;
+        }
+        break;
+      }
+      case opcode_e::BRANCH: {
+        auto &condition = BYTECODE_VALUE(--sp);
+
+        // Only integers are accepted as conditions, so anything else
+        // is boxed to raise the appropriate access error
+        if (condition.type != cell_type_e::INTEGER) {
+          condition.box(program.cells[instruction.b]->locator)->as_integer();
+        }
+        if (condition.i <= 0) {
+          pc = instruction.a;
+        }
+        break;
+      }
+      }
+    }
+  } catch (std::exception &) {
+    trace_bytecode(program, pc - 1, frame);
+    throw;
+  }
+
+#undef BYTECODE_VALUE
+  return true;
+}
+
+#endif
+
+} // namespace nibi
@@ -1,8 +1,13 @@
 #include "interpreter.hpp"
 
+#include "native_stack.hpp"
+
+#include "libnibi/macros.hpp"
 #include "libnibi/platform.hpp"
 #include "libnibi/rang.hpp"
 
+#include <optional>
+
 #if PROFILE_INTERPRETER
 #include <chrono>
 #include <iostream>
@@ -10,8 +15,25 @@
 
 namespace nibi {
 
-interpreter_c::interpreter_c(env_c &env, source_manager_c &source_manager)
-    : interpreter_env(env), source_manager_(source_manager),
+namespace {
+// The environment of a call that is shared with the functions
+// defined within it, which is released along with them unless
+// one of them is kept once the call is over
+struct captured_env_s {
+  std::shared_ptr<env_c> env;
+  ~captured_env_s() { reset(); }
+  void reset() {
+    if (env) {
+      env->release_captures();
+      env = nullptr;
+    }
+  }
+};
+} // namespace
+
+interpreter_c::interpreter_c(env_c &env, source_manager_c &source_manager,
+                             interpreter_options_s options)
+    : options_(options), interpreter_env(env), source_manager_(source_manager),
       modules_(source_manager, *this) {
   last_result_ = allocate_cell(cell_type_e::NIL);
 }
@@ -47,8 +69,29 @@ void interpreter_c::instruction_ind(cell_ptr &cell) {
   }
 }
 
+platform_c *interpreter_c::get_platform() {
+  return options_.platform ? options_.platform : global_platform;
+}
+
+void interpreter_c::request_exit(int64_t code) {
+  if (options_.contained) {
+    throw exit_c(code);
+  }
+  std::exit(code);
+}
+
 void interpreter_c::halt_with_error(error_c error) {
 
+  // A contained interpreter leaves it to its owner to report the error,
+  // and the owner may well go on to run more after it
+  if (options_.contained) {
+    call_stack_.clear();
+#if INTERPRETER_USE_BYTECODE
+    bytecode_traces_.clear();
+#endif
+    throw halt_c(error);
+  }
+
   // We don't want to halt in repl mode. Just draw the error and keep truckin
   if (repl_mode_) {
     error.draw();
@@ -62,9 +105,38 @@ void interpreter_c::halt_with_error(error_c error) {
   std::cout << rang::fg::yellow << "\n[ CALL TRACE ]\n"
             << rang::fg::reset << std::endl;
 
-  // Print the stack trace
-  while (!call_stack_.empty()) {
-    auto top_cell = call_stack_.top();
+  // The calls made within compiled code are placed
+  // where they were made, the trace is innermost first
+  std::vector<cell_ptr> trace;
+  trace.reserve(call_stack_.size());
+#if INTERPRETER_USE_BYTECODE
+  auto record = bytecode_traces_.begin();
+  while (record != bytecode_traces_.end() &&
+         record->call_depth > call_stack_.size()) {
+    ++record;
+  }
+#endif
+  for (auto depth = call_stack_.size();; depth--) {
+#if INTERPRETER_USE_BYTECODE
+    for (; record != bytecode_traces_.end() && record->call_depth == depth;
+         ++record) {
+      trace.insert(trace.end(), record->calls.begin(), record->calls.end());
+    }
+#endif
+    if (depth == 0) {
+      break;
+    }
+    trace.push_back(call_stack_[depth - 1]);
+  }
+
+  // Print the stack trace, only the innermost
+  // calls are shown when recursion goes deep
+  for (std::size_t i = 0; i < trace.size(); i++) {
+    if (i == INTERPRETER_MAX_TRACE_SIZE) {
+      std::cout << "... " << trace.size() - i << " more calls" << std::endl;
+      break;
+    }
+    auto &top_cell = trace[i];
 
     std::cout << ">>> " << rang::fg::cyan << top_cell->to_string(true, true)
               << rang::fg::reset;
@@ -78,8 +150,6 @@ void interpreter_c::halt_with_error(error_c error) {
     }
 
     std::cout << std::endl;
-
-    call_stack_.pop();
   }
 
   std::exit(1);
@@ -101,8 +171,9 @@ cell_ptr interpreter_c::process_cell(cell_ptr cell, env_c &env,
     return std::move(handle_list_cell(cell, env, process_data_list));
   }
   case cell_type_e::SYMBOL: {
-    // Load the symbol from the environment
-    auto loaded_cell = env.get(cell->as_symbol());
+    // Load the symbol from the environment, the symbol
+    // cell remembers where it was found for next time
+    auto loaded_cell = env.get(*cell->data.sym);
     if (!loaded_cell) {
 
       const std::string error =
@@ -111,11 +182,8 @@ cell_ptr interpreter_c::process_cell(cell_ptr cell, env_c &env,
       return nullptr;
     }
 
-    // Cache the cell so we don't load it again later (potentially)
-    cell = loaded_cell;
-
     // Return the loaded cell
-    return std::move(cell);
+    return loaded_cell;
   }
   case cell_type_e::ABERRANT:
     return cell;
@@ -143,6 +211,69 @@ cell_ptr interpreter_c::process_cell(cell_ptr cell, env_c &env,
   return nullptr;
 }
 
+void interpreter_c::process_value(const cell_ptr &cell, env_c &env,
+                                  value_s &out, const bool process_data_list) {
+  if (yield_value_ || !cell) {
+    out.set(process_cell(cell, env, process_data_list));
+    return;
+  }
+
+  switch (cell->type) {
+  case cell_type_e::INTEGER:
+    out.set(cell->data.i);
+    return;
+  case cell_type_e::DOUBLE:
+    out.set(cell->data.d);
+    return;
+  case cell_type_e::SYMBOL: {
+    auto loaded_cell = env.get(*cell->data.sym);
+    if (!loaded_cell) {
+      throw exception_c("Symbol not found in environment: " + cell->as_symbol(),
+                        cell->locator);
+    }
+    out.set(std::move(loaded_cell));
+    return;
+  }
+  case cell_type_e::LIST: {
+    if (cell->is_numeric_list()) {
+      break;
+    }
+    auto &list_info = cell->as_list_info();
+    if (list_info.list.empty()) {
+      break;
+    }
+
+    // Builtins that can produce an unboxed value are called directly
+    // so their result never has to be allocated
+    auto &operation = list_info.list.front();
+    if (list_info.type == list_types_e::INSTRUCTION &&
+        operation->type == cell_type_e::FUNCTION &&
+        operation->data.fn->value_fn) {
+      call_stack_.push_back(operation);
+      operation->data.fn->value_fn(*this, list_info.list, env, out);
+      call_stack_.pop_back();
+      return;
+    }
+
+#if INTERPRETER_USE_BYTECODE
+    if (execute_compiled(cell, list_info, env, out, process_data_list)) {
+      if (yield_value_) {
+        out.set(yield_value_);
+      } else if (out.is_numeric()) {
+        out.cell = nullptr;
+      }
+      return;
+    }
+#endif
+    break;
+  }
+  default:
+    break;
+  }
+
+  out.set(process_cell(cell, env, process_data_list));
+}
+
 inline bool considered_private(cell_ptr &cell) {
   switch (cell->type) {
   case cell_type_e::SYMBOL: {
@@ -160,12 +291,31 @@ inline bool considered_private(cell_ptr &cell) {
 
 inline cell_ptr interpreter_c::handle_list_cell(cell_ptr &cell, env_c &env,
                                                 bool process_data_list) {
-  auto &list = cell->as_list();
+  // Lists holding numbers unboxed are data, so they are kept that
+  // way unless their items are to be processed
+  if (cell->is_numeric_list() && !process_data_list) {
+    return std::move(cell);
+  }
+
+  auto &list_info = cell->as_list_info();
+  auto &list = list_info.list;
   if (!list.size()) {
     return std::move(cell);
   }
 
-  switch (cell->as_list_info().type) {
+#if INTERPRETER_USE_BYTECODE
+  {
+    value_s result;
+    if (execute_compiled(cell, list_info, env, result, process_data_list)) {
+      if (yield_value_) {
+        return yield_value_;
+      }
+      return result.cell ? result.cell : result.box(list.front()->locator);
+    }
+  }
+#endif
+
+  switch (list_info.type) {
   case list_types_e::DATA: {
     if (process_data_list) {
       cell_ptr last_result = allocate_cell(cell_type_e::NIL);
@@ -231,32 +381,29 @@ inline cell_ptr interpreter_c::handle_list_cell(cell_ptr &cell, env_c &env,
       list.front() = operation;
     }
 
-    auto fn_info = operation->as_function_info();
-
-    call_stack_.push(list.front());
+    call_stack_.push_back(list.front());
 
 #if PROFILE_INTERPRETER
-    if (fn_call_data_.find(fn_info.name) == fn_call_data_.end()) {
-      fn_call_data_[fn_info.name] = {0, 0};
+    auto name = operation->as_function_info().name;
+    if (fn_call_data_.find(name) == fn_call_data_.end()) {
+      fn_call_data_[name] = {0, 0};
     }
     auto start = std::chrono::high_resolution_clock::now();
-    auto value = fn_info.fn(*this, list, env);
+    auto value = call_function(operation, list_info, env);
     auto end = std::chrono::high_resolution_clock::now();
     auto duration =
         std::chrono::duration_cast<std::chrono::microseconds>(end - start)
             .count();
-    auto &t = fn_call_data_[fn_info.name];
+    auto &t = fn_call_data_[name];
     t.time += duration;
     t.calls++;
 
-    call_stack_.pop();
+    call_stack_.pop_back();
     return value;
 #else
-    // All functions point to a `cell_fn_t`, even lambda functions
-    // so we can just call the function and return the result
-    auto value = fn_info.fn(*this, list, env);
+    auto value = call_function(operation, list_info, env);
 
-    call_stack_.pop();
+    call_stack_.pop_back();
     return std::move(value);
 #endif
   }
@@ -267,6 +414,166 @@ inline cell_ptr interpreter_c::handle_list_cell(cell_ptr &cell, env_c &env,
   return std::move(cell);
 }
 
+inline cell_ptr interpreter_c::call_function(const cell_ptr &operation,
+                                             list_info_s &list_info,
+                                             env_c &env) {
+  auto &fn_info = operation->as_function_info();
+
+  // Lambdas are executed directly rather than through their
+  // function so that they know if they are in tail position
+  if (fn_info.type == function_type_e::LAMBDA_FUNCTION) {
+    return call_lambda(operation, list_info.list, env, list_info.tail_call);
+  }
+
+  // Everything else points to a `cell_fn_t`, so we can just call it
+  // and return the result. Only the function is taken, as the function
+  // info may be replaced by the function itself while it is executing
+  auto fn = fn_info.fn;
+  return fn(*this, list_info.list, env);
+}
+
+cell_ptr interpreter_c::execute_lambda(const cell_ptr &function,
+                                       cell_list_t &list, env_c &env) {
+  return call_lambda(function, list, env, false);
+}
+
+cell_ptr interpreter_c::call_lambda(const cell_ptr &function,
+                                    cell_list_t &list, env_c &env,
+                                    const bool tail_call) {
+  auto &fn_info = function->as_function_info();
+
+  if (fn_info.type != function_type_e::LAMBDA_FUNCTION) {
+    throw exception_c("Expected lambda function", list.front()->locator);
+  }
+
+  auto arg_count = fn_info.lambda->arg_names->size();
+
+  NIBI_LIST_ENFORCE_SIZE(list.front()->as_symbol(), ==, arg_count + 1);
+
+  // Calls in tail position only have their arguments processed here,
+  // the lambda that they are in makes the call once it has returned.
+  // Lambdas defined within the lambda they are called from refer to
+  // its environment, so they are called as usual to keep it around
+  if (tail_call && lambda_env_ &&
+      !lambda_env_->encloses(fn_info.operating_env)) {
+    auto arguments = tail_arguments_.size();
+    for (std::size_t i = 1; i < list.size(); i++) {
+      tail_arguments_.push_back(process_cell(list[i], env));
+    }
+    if (yield_value_) {
+      tail_arguments_.resize(arguments);
+      return yield_value_;
+    }
+    tail_call_ = {function, arguments};
+    return allocate_cell(cell_type_e::NIL);
+  }
+
+  if (call_depth_ >= INTERPRETER_MAX_CALL_DEPTH) {
+    throw exception_c("Maximum call depth of " +
+                          std::to_string(INTERPRETER_MAX_CALL_DEPTH) +
+                          " exceeded",
+                      list.front()->locator);
+  }
+
+  // Deep recursion carries on along a new stack
+  // rather than overflowing the one it is on
+  if (!native_stack_has_room()) {
+    struct continued_call_s {
+      interpreter_c &interpreter;
+      const cell_ptr &function;
+      cell_list_t &list;
+      env_c &env;
+      cell_ptr result;
+    } continued{*this, function, list, env, nullptr};
+
+    execute_on_new_stack(
+        [](void *data) {
+          auto &call = *static_cast<continued_call_s *>(data);
+          call.result = call.interpreter.call_lambda(call.function, call.list,
+                                                     call.env, false);
+        },
+        &continued);
+    return continued.result;
+  }
+
+  // Exceptions may be caught and execution continued, so the
+  // call is always accounted for however the lambda is left
+  struct call_guard_s {
+    interpreter_c &interpreter;
+    env_c *caller_env;
+    std::size_t tail_arguments;
+    call_guard_s(interpreter_c &interpreter)
+        : interpreter(interpreter), caller_env(interpreter.lambda_env_),
+          tail_arguments(interpreter.tail_arguments_.size()) {
+      interpreter.call_depth_++;
+    }
+    ~call_guard_s() {
+      interpreter.call_depth_--;
+      interpreter.lambda_env_ = caller_env;
+      interpreter.tail_call_ = {};
+      interpreter.tail_arguments_.resize(tail_arguments);
+    }
+  } guard(*this);
+
+  // Lambdas that define functions share the environment of the call
+  // with them so it is kept on the heap, any other lambda has its
+  // arguments held in slots taken from the slot stack
+  std::optional<env_c> frame_env;
+  captured_env_s captured_env;
+  auto enter = [&](function_info_s &info) -> env_c & {
+    frame_env.reset();
+    captured_env.reset();
+    if (info.lambda->defines_functions) {
+      captured_env.env =
+          std::make_shared<env_c>(info.operating_env, info.lambda->arg_names);
+      lambda_env_ = captured_env.env.get();
+    } else {
+      lambda_env_ = &frame_env.emplace(info.operating_env,
+                                       info.lambda->arg_names, env_slots_);
+    }
+    return *lambda_env_;
+  };
+
+  // Create an environment for the lambda
+  // and populate its slots with the arguments
+  auto *lambda_env = &enter(fn_info);
+  for (std::size_t slot = 0; slot < arg_count; slot++) {
+    lambda_env->get_local(slot) = process_cell(list[slot + 1], env);
+  }
+
+  cell_ptr body = fn_info.lambda->body;
+  cell_ptr callee{nullptr};
+  while (true) {
+    cell_ptr result = process_cell(body, *lambda_env, true);
+
+    // We are out of the function, so we can reset the yield value
+    if (yield_value_) {
+      yield_value_ = nullptr;
+    }
+
+    if (!tail_call_.function) {
+      return result;
+    }
+
+    // The body ended with a call, which is made in place of this one
+    // so that it doesn't add to the depth of the stack
+    callee = std::move(tail_call_.function);
+    tail_call_.function = nullptr;
+
+    auto &callee_info = callee->as_function_info();
+    lambda_env = &enter(callee_info);
+
+    auto arguments = tail_call_.arguments;
+    for (std::size_t slot = 0; arguments + slot < tail_arguments_.size();
+         slot++) {
+      lambda_env->get_local(slot) =
+          std::move(tail_arguments_[arguments + slot]);
+    }
+    tail_arguments_.resize(arguments);
+    body = callee_info.lambda->body;
+  }
+}
+
 void interpreter_c::load_module(cell_ptr &module_name) {
   modules_.load_module(module_name, interpreter_env);
 }
@@ -9,10 +9,22 @@
 #include "libnibi/modules.hpp"
 #include "libnibi/source.hpp"
 
-#include <stack>
+#include <vector>
 
 #define PROFILE_INTERPRETER 0
 
+// When enabled, lists that are executed often are compiled to bytecode
+// which is executed in place of walking the cells of the list
+#define INTERPRETER_USE_BYTECODE 1
+
+// The deepest that lambda calls can nest before execution is halted.
+// Calls in tail position are made in place of the lambda they are
+// in, so they can go on without limit
+#define INTERPRETER_MAX_CALL_DEPTH 100000
+
+// The number of calls shown in the trace when execution is halted
+#define INTERPRETER_MAX_TRACE_SIZE 64
+
 namespace nibi {
 //! \brief The runtime object that will be used to execute the code
 //!        that is generated by the list builder
@@ -41,11 +53,36 @@ public:
     locator_ptr source_location_{nullptr};
   };
 
+  //! \brief Raised by a contained interpreter when execution halts on an
+  //!        error, to be caught by whatever is running the interpreter
+  //! \note  Not a std::exception so that nothing within the script,
+  //!        such as a `try`, can stop it
+  class halt_c final {
+  public:
+    halt_c(error_c error) : error_(error) {}
+    const error_c &get_error() const { return error_; }
+
+  private:
+    error_c error_;
+  };
+
+  //! \brief Raised by a contained interpreter when `exit` is called
+  class exit_c final {
+  public:
+    exit_c(int64_t code) : code_(code) {}
+    int64_t get_code() const { return code_; }
+
+  private:
+    int64_t code_;
+  };
+
   //! \brief Construct a new interpreter object
   //! \param env The object that will used as the top level environment
   //! \param source_manager The source manager that will be used to track
   //!        imported files
-  interpreter_c(env_c &env, source_manager_c &source_manager);
+  //! \param options The options for the interpreter
+  interpreter_c(env_c &env, source_manager_c &source_manager,
+                interpreter_options_s options = {});
 
   //! \brief Destroy the interpreter object
   ~interpreter_c();
@@ -62,10 +99,17 @@ public:
   virtual cell_ptr process_cell(cell_ptr instruction, env_c &env,
                                 const bool process_data_cell = false) override;
 
+  virtual void process_value(const cell_ptr &instruction, env_c &env,
+                             value_s &out,
+                             const bool process_data_cell = false) override;
+
   virtual void set_yield_value(cell_ptr value) override {
     yield_value_ = value;
   }
 
+  virtual cell_ptr execute_lambda(const cell_ptr &function, cell_list_t &list,
+                                  env_c &env) override;
+
   virtual bool is_yielding() override { return yield_value_ != nullptr; }
 
   virtual cell_ptr get_yield_value() override { return yield_value_; }
@@ -80,7 +124,18 @@ public:
 
   virtual env_c &get_env() override { return interpreter_env; }
 
+  virtual const interpreter_options_s &get_options() override {
+    return options_;
+  }
+
+  virtual platform_c *get_platform() override;
+
+  [[noreturn]] virtual void request_exit(int64_t code) override;
+
 private:
+  // Options the interpreter was created with
+  interpreter_options_s options_;
+
   // The last item that was processed
   cell_ptr last_result_{nullptr};
 
@@ -100,13 +155,103 @@ private:
   // Handle a list cell
   cell_ptr handle_list_cell(cell_ptr &cell, env_c &env, bool process_data_cell);
 
+  // Call the function at the head of an instruction list
+  cell_ptr call_function(const cell_ptr &operation, list_info_s &list_info,
+                         env_c &env);
+
+  // Execute a lambda, or if the call is in tail position of another
+  // lambda, leave the call for that lambda to make once it returns
+  cell_ptr call_lambda(const cell_ptr &function, cell_list_t &list,
+                       env_c &env, const bool tail_call);
+
+  // A call made in tail position, waiting to be made
+  // by the lambda that it was made within
+  struct tail_call_s {
+    cell_ptr function{nullptr};
+    std::size_t arguments{0};
+  };
+
+  tail_call_s tail_call_;
+
+  // The arguments of calls made in tail position, where each call
+  // has its arguments from its offset to the end
+  std::vector<cell_ptr> tail_arguments_;
+
+  // Slots for the environments of lambdas and compiled scopes
+  env_slot_stack_c env_slots_;
+
+  // The number of lambdas that are being executed
+  std::size_t call_depth_{0};
+
+  // The environment of the lambda being executed
+  env_c *lambda_env_{nullptr};
+
   // Indicates if we are in repl mode
   bool repl_mode_{false};
 
   // Halt the interpreter with an error
   void halt_with_error(error_c error);
 
-  std::stack<cell_ptr> call_stack_;
+  std::vector<cell_ptr> call_stack_;
+
+#if INTERPRETER_USE_BYTECODE
+  // The region of the value stack and symbol slots used
+  // by a single execution of bytecode
+  struct bytecode_frame_s {
+    bytecode_frame_s(interpreter_c &interpreter, bytecode_s &program);
+    ~bytecode_frame_s();
+
+    interpreter_c &interpreter;
+    std::size_t values;
+    std::size_t value_count;
+    std::size_t slots;
+    std::size_t slot_count;
+    std::size_t call_depth;
+    bool frame_resolved{false};
+    bool traced{false};
+  };
+
+  // The calls within compiled code that an error was raised through,
+  // innermost first, and the depth of the call stack they were made at
+  struct bytecode_trace_s {
+    std::size_t call_depth;
+    std::vector<cell_ptr> calls;
+  };
+
+  // Traces recorded as an error unwinds, from the innermost frame out
+  std::vector<bytecode_trace_s> bytecode_traces_;
+
+  std::vector<value_s> bytecode_values_;
+  std::vector<cell_ptr> bytecode_slots_;
+  std::size_t bytecode_values_top_{0};
+  std::size_t bytecode_slots_top_{0};
+
+  // Execute a list as bytecode, compiling it if it is hot enough
+  // Returns false if the list has to be walked instead
+  bool execute_compiled(const cell_ptr &cell, list_info_s &list_info,
+                        env_c &env, value_s &out, bool process_data_list);
+
+  // Execute bytecode, leaving the result in `out` unless yielding
+  void execute_bytecode(bytecode_s &program, env_c &env, value_s &out);
+
+  // Execute the bytecode from `pc` up to `end`
+  // Returns false if execution was stopped by a yield
+  bool run_bytecode(bytecode_s &program, std::size_t pc, const std::size_t end,
+                    env_c &env, bytecode_frame_s &frame, std::size_t &sp);
+
+  // Get the cell bound to a symbol, looking it up if it isn't held in its slot
+  const cell_ptr &lookup_symbol(bytecode_s &program, env_c &env,
+                                bytecode_frame_s &frame, uint32_t symbol,
+                                uint32_t source);
+
+  // Forget the symbols that have been looked up in a frame
+  void invalidate_slots(bytecode_frame_s &frame);
+
+  // Record the calls that led to the instruction at `pc`, to be placed
+  // in the call trace beneath any recorded by calls made from it
+  void trace_bytecode(bytecode_s &program, std::size_t pc,
+                      bytecode_frame_s &frame);
+#endif
 
 #if PROFILE_INTERPRETER
   struct profile_info_s {
@@ -0,0 +1,342 @@
+// The ucontext routines are only declared on macOS when asked for
+#if defined(__APPLE__) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 600
+#endif
+
+#include "native_stack.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__unix__)
+#define NATIVE_STACK_CAN_SWITCH 1
+#include <pthread.h>
+#include <ucontext.h>
+#else
+#define NATIVE_STACK_CAN_SWITCH 0
+#endif
+
+namespace nibi {
+
+#if NATIVE_STACK_CAN_SWITCH
+
+namespace {
+
+// The size of each stack that is allocated
+static constexpr std::size_t STACK_SIZE = 1024 * 1024;
+
+// How much of a stack is left when moving on to a new one. Room is
+// checked as functions are called, so this is for anything that
+// recurses between calls
+static constexpr std::uintptr_t STACK_RESERVE = 256 * 1024;
+
+// How much of a thread's own stack is used when its size can't be found
+static constexpr std::uintptr_t STACK_FALLBACK_BUDGET = 768 * 1024;
+
+// Recursion that crosses onto a new stack tends to cross back and
+// forth, so a few stacks are kept rather than allocated each time
+static constexpr std::size_t MAX_SPARE_STACKS = 4;
+
+struct stack_switch_s {
+  ucontext_t caller;
+  ucontext_t callee;
+  void (*fn)(void *);
+  void *data;
+  std::exception_ptr error;
+};
+
+// How far down the stack currently being executed on can be used
+thread_local std::uintptr_t stack_limit{0};
+
+thread_local stack_switch_s *active_switch{nullptr};
+
+thread_local std::vector<std::unique_ptr<char[]>> spare_stacks;
+
+inline std::uintptr_t stack_position() {
+  char marker;
+  return reinterpret_cast<std::uintptr_t>(&marker);
+}
+
+// Find how far down the stack of the calling thread can be used. Threads
+// other than the main one are often given much smaller stacks than it
+std::uintptr_t find_thread_stack_limit(std::uintptr_t position) {
+#if defined(__APPLE__)
+  auto self = pthread_self();
+  auto top = reinterpret_cast<std::uintptr_t>(pthread_get_stackaddr_np(self));
+  return top - pthread_get_stacksize_np(self) + STACK_RESERVE;
+#elif defined(__linux__)
+  pthread_attr_t attributes;
+  if (pthread_getattr_np(pthread_self(), &attributes) == 0) {
+    void *address{nullptr};
+    std::size_t size{0};
+    auto found = pthread_attr_getstack(&attributes, &address, &size) == 0;
+    pthread_attr_destroy(&attributes);
+    if (found) {
+      return reinterpret_cast<std::uintptr_t>(address) + STACK_RESERVE;
+    }
+  }
+#endif
+  return position - STACK_FALLBACK_BUDGET;
+}
+
+std::unique_ptr<char[]> take_stack() {
+  if (spare_stacks.empty()) {
+    return std::unique_ptr<char[]>(new char[STACK_SIZE]);
+  }
+  auto stack = std::move(spare_stacks.back());
+  spare_stacks.pop_back();
+  return stack;
+}
+
+void give_back_stack(std::unique_ptr<char[]> stack) {
+  if (spare_stacks.size() < MAX_SPARE_STACKS) {
+    spare_stacks.push_back(std::move(stack));
+  }
+}
+
+// Exceptions can not unwind past the start of a stack, so
+// they are held until execution is back on the caller's stack
+void enter_new_stack() {
+  auto *current = active_switch;
+  try {
+    current->fn(current->data);
+  } catch (...) {
+    current->error = std::current_exception();
+  }
+}
+
+} // namespace
+
+bool native_stack_has_room() {
+  auto position = stack_position();
+  if (!stack_limit) {
+    stack_limit = find_thread_stack_limit(position);
+  }
+
+  // Stacks grow down on every platform that they are switched on
+  return position > stack_limit;
+}
+
+void execute_on_new_stack(void (*fn)(void *), void *data) {
+  auto stack = take_stack();
+
+  stack_switch_s stack_switch{};
+  stack_switch.fn = fn;
+  stack_switch.data = data;
+
+  getcontext(&stack_switch.callee);
+  stack_switch.callee.uc_stack.ss_sp = stack.get();
+  stack_switch.callee.uc_stack.ss_size = STACK_SIZE;
+  stack_switch.callee.uc_link = &stack_switch.caller;
+  makecontext(&stack_switch.callee, enter_new_stack, 0);
+
+  auto *previous_switch = active_switch;
+  auto previous_limit = stack_limit;
+  active_switch = &stack_switch;
+  stack_limit = reinterpret_cast<std::uintptr_t>(stack.get() + STACK_RESERVE);
+
+  swapcontext(&stack_switch.caller, &stack_switch.callee);
+
+  active_switch = previous_switch;
+  stack_limit = previous_limit;
+
+  give_back_stack(std::move(stack));
+
+  if (stack_switch.error) {
+    std::rethrow_exception(stack_switch.error);
+  }
+}
+
+namespace {
+
+thread_local native_coroutine_c *running_coroutine{nullptr};
+
+// Everything kept for each thread that belongs to the stack being run
+struct thread_state_s {
+  std::uintptr_t stack_limit{0};
+  stack_switch_s *active_switch{nullptr};
+  native_coroutine_c *coroutine{nullptr};
+
+  void save() {
+    stack_limit = nibi::stack_limit;
+    active_switch = nibi::active_switch;
+    coroutine = running_coroutine;
+  }
+
+  void restore() const {
+    nibi::stack_limit = stack_limit;
+    nibi::active_switch = active_switch;
+    running_coroutine = coroutine;
+  }
+};
+
+} // namespace
+
+struct native_coroutine_c::state_s {
+  void (*fn)(void *);
+  void *data;
+  std::unique_ptr<char[]> stack;
+  ucontext_t resumer;
+  ucontext_t own;
+  thread_state_s resumer_state;
+  thread_state_s own_state;
+  std::exception_ptr error{nullptr};
+
+  // The exceptions being handled by the resumer. The runtime keeps
+  // them per thread rather than per stack, so the coroutine can only
+  // be suspended once it is handling none of its own
+  std::exception_ptr resumer_handling{nullptr};
+  int resumer_uncaught{0};
+  bool started{false};
+  bool running{false};
+  bool finished{false};
+  bool cancelling{false};
+
+  static void enter() {
+    auto &state = *running_coroutine->state_;
+    try {
+      if (!state.cancelling) {
+        state.fn(state.data);
+      }
+    } catch (cancel_c &) {
+    } catch (...) {
+      state.error = std::current_exception();
+    }
+    state.finished = true;
+  }
+};
+
+native_coroutine_c::native_coroutine_c(void (*fn)(void *), void *data)
+    : state_(std::make_unique<state_s>()) {
+  state_->fn = fn;
+  state_->data = data;
+  state_->stack = take_stack();
+
+  getcontext(&state_->own);
+  state_->own.uc_stack.ss_sp = state_->stack.get();
+  state_->own.uc_stack.ss_size = STACK_SIZE;
+  state_->own.uc_link = &state_->resumer;
+  makecontext(&state_->own, state_s::enter, 0);
+
+  state_->own_state.stack_limit =
+      reinterpret_cast<std::uintptr_t>(state_->stack.get() + STACK_RESERVE);
+  state_->own_state.coroutine = this;
+}
+
+native_coroutine_c::~native_coroutine_c() {
+  // Its stack is still being run on, whatever owns the coroutine
+  // has to keep it until it has switched back to its resumer
+  if (state_->running) {
+    std::terminate();
+  }
+
+  // The coroutine can't suspend while it is cancelled,
+  // so it always finishes once it has been resumed
+  if (state_->started && !state_->finished) {
+    state_->cancelling = true;
+    try {
+      resume();
+    } catch (...) {
+    }
+  }
+  give_back_stack(std::move(state_->stack));
+}
+
+bool native_coroutine_c::resume() {
+  if (state_->finished) {
+    return false;
+  }
+  if (state_->running) {
+    throw std::runtime_error("A coroutine can not resume itself");
+  }
+
+  state_->started = true;
+  state_->running = true;
+  state_->resumer_handling = std::current_exception();
+  state_->resumer_uncaught = std::uncaught_exceptions();
+  state_->resumer_state.save();
+  state_->own_state.restore();
+
+  swapcontext(&state_->resumer, &state_->own);
+
+  state_->resumer_state.restore();
+  state_->running = false;
+  state_->resumer_handling = nullptr;
+
+  if (state_->error) {
+    auto error = state_->error;
+    state_->error = nullptr;
+    std::rethrow_exception(error);
+  }
+  return !state_->finished;
+}
+
+bool native_coroutine_c::can_suspend() {
+  auto *coroutine = running_coroutine;
+  if (!coroutine) {
+    return false;
+  }
+  auto &state = *coroutine->state_;
+  return std::current_exception() == state.resumer_handling &&
+         std::uncaught_exceptions() == state.resumer_uncaught;
+}
+
+void native_coroutine_c::suspend() {
+  auto *coroutine = running_coroutine;
+  if (!coroutine) {
+    throw std::runtime_error("No coroutine is running to suspend");
+  }
+  if (!can_suspend()) {
+    throw std::runtime_error(
+        "A coroutine can not suspend while handling an exception");
+  }
+
+  auto &state = *coroutine->state_;
+  if (state.cancelling) {
+    throw cancel_c();
+  }
+  state.own_state.save();
+  swapcontext(&state.own, &state.resumer);
+
+  if (state.cancelling) {
+    throw cancel_c();
+  }
+}
+
+native_coroutine_c *native_coroutine_c::running() { return running_coroutine; }
+
+void *native_coroutine_c::get_data() const { return state_->data; }
+
+#else
+
+bool native_stack_has_room() { return true; }
+
+void execute_on_new_stack(void (*fn)(void *), void *data) { fn(data); }
+
+struct native_coroutine_c::state_s {
+  void *data;
+};
+
+native_coroutine_c::native_coroutine_c(void (*fn)(void *), void *data) {
+  throw std::runtime_error("Coroutines are not supported on this platform");
+}
+
+native_coroutine_c::~native_coroutine_c() {}
+
+bool native_coroutine_c::resume() { return false; }
+
+bool native_coroutine_c::can_suspend() { return false; }
+
+void native_coroutine_c::suspend() {}
+
+native_coroutine_c *native_coroutine_c::running() { return nullptr; }
+
+void *native_coroutine_c::get_data() const { return nullptr; }
+
+#endif
+
+} // namespace nibi
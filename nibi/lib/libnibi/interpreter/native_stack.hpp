@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+
+namespace nibi {
+
+//! \brief Check if the native stack being executed on has room
+//!        for the interpreter to recurse further
+//! \note  The first check made on a thread finds the bounds of its
+//!        stack, which may be far smaller than that of the main thread
+extern bool native_stack_has_room();
+
+//! \brief Execute a function on a newly allocated native stack
+//! \param fn The function to execute
+//! \param data The data to pass to the function
+//! \note  Exceptions thrown by the function are rethrown on the
+//!        stack that this was called from. On platforms where
+//!        stacks can not be switched the function is called directly
+extern void execute_on_new_stack(void (*fn)(void *), void *data);
+
+//! \brief A function that runs on a native stack of its own, and can
+//!        suspend itself to be resumed later from where it left off
+//! \note  A coroutine must be resumed and destroyed on the thread
+//!        that created it
+class native_coroutine_c {
+public:
+  //! \brief Raised from suspend() within a coroutine that is being
+  //!        destroyed, so that its stack is unwound
+  //! \note  Not a std::exception so that it is only caught where the
+  //!        coroutine began
+  class cancel_c final {};
+
+  //! \brief Create the coroutine, which starts once resumed
+  //! \param fn The function to execute
+  //! \param data The data to pass to the function
+  //! \throws std::runtime_error on platforms where stacks can not be
+  //!         switched
+  native_coroutine_c(void (*fn)(void *), void *data);
+
+  //! \brief Unwind the stack of the coroutine if it was left suspended
+  //! \note  Terminates if the coroutine is running, as its stack is
+  //!        still in use
+  ~native_coroutine_c();
+
+  native_coroutine_c(const native_coroutine_c &) = delete;
+  native_coroutine_c &operator=(const native_coroutine_c &) = delete;
+
+  //! \brief Run the coroutine until it suspends itself or returns
+  //! \return false once the function has returned
+  //! \note  Exceptions thrown by the function are rethrown here
+  bool resume();
+
+  //! \brief Check if the coroutine being run can suspend itself
+  //! \return false if no coroutine is being run, or it is handling an
+  //!         exception. The C++ runtime keeps the exceptions being
+  //!         handled per thread, so they can't be left on a suspended
+  //!         stack
+  static bool can_suspend();
+
+  //! \brief Return from resume() of the coroutine being run
+  //! \throws cancel_c if the coroutine is being destroyed, in which
+  //!         case it does not suspend
+  //! \throws std::runtime_error if the coroutine can't suspend
+  static void suspend();
+
+  //! \brief Get the coroutine being run on this thread
+  //! \return nullptr if no coroutine is being run
+  static native_coroutine_c *running();
+
+  //! \brief Get the data given to the function
+  void *get_data() const;
+
+private:
+  struct state_s;
+  std::unique_ptr<state_s> state_;
+};
+
+} // namespace nibi
@@ -15,9 +15,10 @@ namespace {
 
 class line_interpreter_c : public line_interpreter_if {
 public:
-  line_interpreter_c(error_callback_f error_callback)
+  line_interpreter_c(error_callback_f error_callback,
+                     interpreter_options_s options)
       : error_callback_(error_callback),
-        interpreter_(environment_, source_manager_),
+        interpreter_(environment_, source_manager_, options),
         intake_(interpreter_, error_callback, source_manager_,
                 nibi::builtins::get_builtin_symbols_map()) {
     interpreter_.indicate_repl();
@@ -25,13 +26,25 @@ public:
   }
 
   void interpret_line(std::string line) override {
-    intake_.read_line(line, source_origin_);
+    if (exit_code_.has_value()) {
+      return;
+    }
+    try {
+      intake_.read_line(line, source_origin_);
+    } catch (interpreter_c::halt_c &halt) {
+      intake_.discard_pending();
+      error_callback_(halt.get_error());
+    } catch (interpreter_c::exit_c &exit) {
+      exit_code_ = exit.get_code();
+    }
   }
 
   std::string get_result() override {
     return interpreter_.get_last_result()->to_string();
   }
 
+  std::optional<int64_t> get_exit_code() override { return exit_code_; }
+
 private:
   std::shared_ptr<source_origin_c> source_origin_;
   error_callback_f error_callback_;
@@ -39,18 +52,68 @@ private:
   source_manager_c source_manager_;
   interpreter_c interpreter_;
   intake_c intake_;
+  std::optional<int64_t> exit_code_{std::nullopt};
+};
+
+// The file interpreter held by the program that created it, which
+// stops at the first halt or exit of a contained interpreter. Those
+// raised by the interpreters of imports and modules pass through
+// them to here, as they are all part of the one program
+class hosted_file_interpreter_c : public file_interpreter_if {
+public:
+  hosted_file_interpreter_c(error_callback_f error_callback,
+                            interpreter_options_s options)
+      : error_callback_(error_callback),
+        file_interpreter_(error_callback, options) {}
+
+  void interpret_file(std::filesystem::path filename) override {
+    if (stopped_) {
+      return;
+    }
+    try {
+      file_interpreter_.interpret_file(filename);
+    } catch (interpreter_c::halt_c &halt) {
+      stopped_ = true;
+      error_callback_(halt.get_error());
+    } catch (interpreter_c::exit_c &exit) {
+      stopped_ = true;
+      exit_code_ = exit.get_code();
+    }
+  }
+
+  void indicate_complete() override { file_interpreter_.indicate_complete(); }
+
+  std::optional<int64_t> get_exit_code() override { return exit_code_; }
+
+  bool save_snapshot(std::filesystem::path snapshot,
+                     std::filesystem::path file) override {
+    return !stopped_ && file_interpreter_.save_snapshot(snapshot, file);
+  }
+
+  bool restore_snapshot(std::filesystem::path snapshot,
+                        std::filesystem::path file) override {
+    return !stopped_ && file_interpreter_.restore_snapshot(snapshot, file);
+  }
+
+private:
+  error_callback_f error_callback_;
+  file_interpreter_c file_interpreter_;
+  std::optional<int64_t> exit_code_{std::nullopt};
+  bool stopped_{false};
 };
 
 } // namespace
 
 file_interpreter_ptr
-interpreter_factory_c::file_interpreter(error_callback_f error_callback) {
-  return std::make_unique<file_interpreter_c>(error_callback);
+interpreter_factory_c::file_interpreter(error_callback_f error_callback,
+                                        interpreter_options_s options) {
+  return std::make_unique<hosted_file_interpreter_c>(error_callback, options);
 }
 
 line_interpreter_ptr
-interpreter_factory_c::line_interpreter(error_callback_f error_callback) {
-  return std::make_unique<line_interpreter_c>(error_callback);
+interpreter_factory_c::line_interpreter(error_callback_f error_callback,
+                                        interpreter_options_s options) {
+  return std::make_unique<line_interpreter_c>(error_callback, options);
 }
 
 } // namespace nibi
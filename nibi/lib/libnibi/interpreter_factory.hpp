@@ -22,13 +22,23 @@ public:
 
   //! \brief Create a file interpreter.
   //! \param error_callback Callback for errors.
+  //! \param options Options for the interpreter.
   //! \return A file interpreter interface shared pointer
-  static file_interpreter_ptr file_interpreter(error_callback_f error_callback);
+  //! \note  A contained interpreter reports runtime errors through the
+  //!        callback and then ignores any further files
+  static file_interpreter_ptr
+  file_interpreter(error_callback_f error_callback,
+                   interpreter_options_s options = {});
 
   //! \brief Create a line interpreter.
   //! \param error_callback Callback for errors.
+  //! \param options Options for the interpreter.
   //! \return A line interpreter interface shared pointer
-  static line_interpreter_ptr line_interpreter(error_callback_f error_callback);
+  //! \note  A contained interpreter reports runtime errors through the
+  //!        callback and then goes on to take more lines
+  static line_interpreter_ptr
+  line_interpreter(error_callback_f error_callback,
+                   interpreter_options_s options = {});
 };
 
 } // namespace nibi
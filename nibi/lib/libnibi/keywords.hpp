@@ -35,6 +35,20 @@ static constexpr const char *POP_BACK = "|>>";
 static constexpr const char *SPAWN = "<|>";
 static constexpr const char *ITER = "iter";
 static constexpr const char *AT = "at";
+static constexpr const char *PITER = "piter";
+static constexpr const char *PMAP = "pmap";
+static constexpr const char *TASK = "task";
+static constexpr const char *TASK_JOIN = "task-join";
+static constexpr const char *CHAN = "chan";
+static constexpr const char *CHAN_SEND = "chan-send";
+static constexpr const char *CHAN_RECV = "chan-recv";
+static constexpr const char *CHAN_CLOSE = "chan-close";
+static constexpr const char *GEN = "gen";
+static constexpr const char *EMIT = "emit";
+static constexpr const char *GEN_NEXT = "gen-next";
+static constexpr const char *GEN_TAKE = "gen-take";
+static constexpr const char *GEN_MAP = "gen-map";
+static constexpr const char *GEN_FILTER = "gen-filter";
 static constexpr const char *LEN = "len";
 static constexpr const char *YIELD = "<-";
 static constexpr const char *LOOP = "loop";
@@ -52,6 +66,15 @@ static constexpr const char *BW_AND = "bw-and";
 static constexpr const char *BW_OR = "bw-or";
 static constexpr const char *BW_XOR = "bw-xor";
 static constexpr const char *BW_NOT = "bw-not";
+static constexpr const char *VEC_ADD = "vec-add";
+static constexpr const char *VEC_SUB = "vec-sub";
+static constexpr const char *VEC_MUL = "vec-mul";
+static constexpr const char *VEC_DIV = "vec-div";
+static constexpr const char *VEC_SCALE = "vec-scale";
+static constexpr const char *VEC_DOT = "vec-dot";
+static constexpr const char *VEC_SUM = "vec-sum";
+static constexpr const char *VEC_MIN = "vec-min";
+static constexpr const char *VEC_MAX = "vec-max";
 static constexpr const char *STR = "str";
 static constexpr const char *INT = "int";
 static constexpr const char *FLOAT = "float";
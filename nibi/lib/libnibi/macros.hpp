@@ -15,6 +15,16 @@ namespace nibi {
     ___loop_body                                                               \
   }
 
+// Iterate over a list, executing the loop body for each element
+// after skipping the first n elements, and loading the unboxed value
+// into an "arg" variable
+#define NIBI_LIST_ITER_AND_LOAD_VALUE_SKIP_N(___n, ___loop_body)               \
+  for (auto i = std::next(list.begin(), ___n); i != list.end(); ++i) {         \
+    nibi::value_s arg;                                                         \
+    ci.process_value(*i, env, arg);                                            \
+    ___loop_body                                                               \
+  }
+
 // Check if the list is a given size, and if not error out.
 // converts size to number of arguments expected, so if you want 2 arguments
 // you should pass 3
@@ -25,7 +35,6 @@ namespace nibi {
             std::to_string(___size - 1) + " parameters, got " +                \
             std::to_string(list.size() - 1) + ".",                             \
         list.front()->locator);                                                \
-    return nibi::allocate_cell(nibi::cell_type_e::NIL);                        \
   }
 
 } // namespace nibi
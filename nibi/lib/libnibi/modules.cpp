@@ -31,8 +31,8 @@ inline std::string generate_random_id() {
                                  "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
                                  "abcdefghijklmnopqrstuvwxyz";
 
-  static std::random_device dev;
-  static std::mt19937 rng(dev());
+  thread_local std::random_device dev;
+  thread_local std::mt19937 rng(dev());
 
   std::uniform_int_distribution<uint32_t> dist(0, sizeof(POOL) - 1);
 
@@ -64,7 +64,7 @@ std::filesystem::path modules_c::get_module_path(cell_ptr &module_name) {
 
   std::string name = module_name->as_string();
 
-  auto opt_path = global_platform->locate_directory(name);
+  auto opt_path = ci_.get_platform()->locate_directory(name);
 
   if (!opt_path.has_value()) {
     throw interpreter_c::exception_c("Could not locate module: " + name,
@@ -96,7 +96,8 @@ void populate_env(std::filesystem::path module_file, interpreter_c &ci,
     e.draw();
     throw interpreter_c::exception_c("Module import failure");
   };
-  file_interpreter_c(error_callback, env, ci.get_source_manager())
+  file_interpreter_c(error_callback, env, ci.get_source_manager(),
+                     ci.get_options())
       .interpret_file(module_file);
 }
 
@@ -326,7 +327,8 @@ inline void modules_c::load_source_list(std::string &name, env_c &module_env,
           source_file->locator);
     }
 
-    file_interpreter_c(error_callback, module_env, source_manager_)
+    file_interpreter_c(error_callback, module_env, source_manager_,
+                       ci_.get_options())
         .interpret_file(source_file_path);
   }
 }
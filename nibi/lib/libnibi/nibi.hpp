@@ -1,5 +1,6 @@
 #pragma once
 
+#include <libnibi/allocator.hpp>
 #include <libnibi/cell.hpp>
 #include <libnibi/config.hpp>
 #include <libnibi/environment.hpp>
@@ -1,4 +1,5 @@
 #include "platform.hpp"
+#include "config.hpp"
 
 #include <iostream>
 
@@ -43,6 +44,16 @@ platform_c::platform_c(std::vector<std::filesystem::path> &include_dirs,
     }
   }
 
+  // The cache is kept in the nibi home unless directed elsewhere,
+  // setting the path to nothing disables it
+  if (const char *cache = std::getenv(config::NIBI_CACHE_PATH_ENV)) {
+    if (*cache) {
+      _cache_path = {std::filesystem::path(cache)};
+    }
+  } else if (_nibi_path.has_value()) {
+    _cache_path = {_nibi_path.value() / config::NIBI_CACHE_DIR_NAME};
+  }
+
 #if defined(__linux__) || defined(__unix__)
   _platform = platform_e::LINUX;
 #elif defined(__APPLE__)
@@ -59,6 +70,10 @@ std::optional<std::filesystem::path> platform_c::get_nibi_path() const {
   return _nibi_path;
 }
 
+std::optional<std::filesystem::path> platform_c::get_cache_path() const {
+  return _cache_path;
+}
+
 const char *platform_c::get_platform_string() const {
   switch (_platform) {
   case platform_e::LINUX:
@@ -74,7 +89,7 @@ const char *platform_c::get_platform_string() const {
 
 std::optional<std::filesystem::path>
 platform_c::locate_file(std::filesystem::path &file_path,
-                        std::filesystem::path &imported_from) {
+                        std::filesystem::path &imported_from) const {
 
   // Check the path that the import came from to see if it has a parent
   // directory. if it does, then we should check that directory first.
@@ -118,7 +133,7 @@ platform_c::locate_file(std::filesystem::path &file_path,
 }
 
 std::optional<std::filesystem::path>
-platform_c::locate_directory(std::string &directory_name) {
+platform_c::locate_directory(std::string &directory_name) const {
   std::filesystem::path dir_path = std::filesystem::path(directory_name);
   for (auto &include_dir : _include_dirs) {
     dir_path = include_dir / std::filesystem::path(directory_name);
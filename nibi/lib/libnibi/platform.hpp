@@ -8,6 +8,8 @@
 namespace nibi {
 
 //! \brief Platform class
+//! \note  Nothing is changed once constructed, so a platform can be
+//!        shared by interpreters on any number of threads
 class platform_c {
 public:
   //! \brief Platform enum
@@ -23,18 +25,22 @@ public:
   //! \return The nibi home path iff it exists
   std::optional<std::filesystem::path> get_nibi_path() const;
 
+  //! \brief Retrieve the path that parsed sources are cached in
+  //! \return The cache path iff caching is enabled
+  std::optional<std::filesystem::path> get_cache_path() const;
+
   //! \brief Locate a file
   //! \param file_name The file name
   //! \return The file path iff it exists somewhere
   std::optional<std::filesystem::path>
   locate_file(std::filesystem::path &file_name,
-              std::filesystem::path &imported_from);
+              std::filesystem::path &imported_from) const;
 
   //! \brief Locate a directory
   //! \param directory_name The directory name
   //! \return The directory path iff it exists somewhere
   std::optional<std::filesystem::path>
-  locate_directory(std::string &directory_name);
+  locate_directory(std::string &directory_name) const;
 
   //! \brief Retrieve the platform string
   //! \return The platform string
@@ -49,6 +55,7 @@ private:
   std::vector<std::filesystem::path> &_include_dirs;
   std::vector<std::string> &_program_args;
   std::optional<std::filesystem::path> _nibi_path{std::nullopt};
+  std::optional<std::filesystem::path> _cache_path{std::nullopt};
 };
 
 extern platform_c *global_platform;
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+// When enabled, reference counts are updated atomically so that objects
+// may be shared between threads. The interpreter itself is single threaded
+// so this is only required for embeddings that hand cells across threads.
+// Modules must be built with the same setting as the library.
+#define REF_PTR_USE_ATOMIC_COUNT 0
+
+#if REF_PTR_USE_ATOMIC_COUNT
+#include <atomic>
+#endif
+
+namespace nibi {
+
+//! \brief Base for objects that carry their own reference count
+//! \note  Objects are deleted through a virtual destructor when
+//!        the last ref_ptr_c to them is released
+class ref_counted_c {
+public:
+  ref_counted_c() = default;
+  ref_counted_c(const ref_counted_c &) = delete;
+  ref_counted_c &operator=(const ref_counted_c &) = delete;
+  virtual ~ref_counted_c() = default;
+
+  //! \brief Get the number of references held to the object
+  std::size_t use_count() const {
+#if REF_PTR_USE_ATOMIC_COUNT
+    return ref_count_.load(std::memory_order_relaxed);
+#else
+    return ref_count_;
+#endif
+  }
+
+private:
+  template <typename T> friend class ref_ptr_c;
+
+  inline void add_ref() const {
+#if REF_PTR_USE_ATOMIC_COUNT
+    ref_count_.fetch_add(1, std::memory_order_relaxed);
+#else
+    ++ref_count_;
+#endif
+  }
+
+  inline void release_ref() const {
+#if REF_PTR_USE_ATOMIC_COUNT
+    if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+#else
+    if (--ref_count_ == 0) {
+      delete this;
+    }
+#endif
+  }
+
+#if REF_PTR_USE_ATOMIC_COUNT
+  mutable std::atomic<uint32_t> ref_count_{0};
+#else
+  mutable uint32_t ref_count_{0};
+#endif
+};
+
+//! \brief A pointer to an object that stores its own reference count
+//! \note  The interface mirrors the parts of std::shared_ptr that
+//!        the library and modules use so it can be used in its place
+template <typename T> class ref_ptr_c {
+public:
+  using element_type = T;
+
+  constexpr ref_ptr_c() noexcept = default;
+  constexpr ref_ptr_c(std::nullptr_t) noexcept {}
+
+  //! \brief Take a reference to an object
+  explicit ref_ptr_c(T *ptr) noexcept : ptr_(ptr) {
+    if (ptr_) {
+      ptr_->add_ref();
+    }
+  }
+
+  ref_ptr_c(const ref_ptr_c &other) noexcept : ptr_(other.ptr_) {
+    if (ptr_) {
+      ptr_->add_ref();
+    }
+  }
+
+  ref_ptr_c(ref_ptr_c &&other) noexcept : ptr_(other.ptr_) {
+    other.ptr_ = nullptr;
+  }
+
+  ~ref_ptr_c() {
+    if (ptr_) {
+      ptr_->release_ref();
+    }
+  }
+
+  ref_ptr_c &operator=(const ref_ptr_c &other) noexcept {
+    // Take the new reference first in case both refer to the same object
+    if (other.ptr_) {
+      other.ptr_->add_ref();
+    }
+    T *old = ptr_;
+    ptr_ = other.ptr_;
+    if (old) {
+      old->release_ref();
+    }
+    return *this;
+  }
+
+  ref_ptr_c &operator=(ref_ptr_c &&other) noexcept {
+    if (this != &other) {
+      T *old = ptr_;
+      ptr_ = other.ptr_;
+      other.ptr_ = nullptr;
+      if (old) {
+        old->release_ref();
+      }
+    }
+    return *this;
+  }
+
+  ref_ptr_c &operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  //! \brief Release the held reference, if any
+  void reset() noexcept {
+    if (ptr_) {
+      T *old = ptr_;
+      ptr_ = nullptr;
+      old->release_ref();
+    }
+  }
+
+  void swap(ref_ptr_c &other) noexcept { std::swap(ptr_, other.ptr_); }
+
+  T *get() const noexcept { return ptr_; }
+  T &operator*() const noexcept { return *ptr_; }
+  T *operator->() const noexcept { return ptr_; }
+  explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+  //! \brief Get the number of references held to the object
+  std::size_t use_count() const noexcept {
+    return ptr_ ? ptr_->use_count() : 0;
+  }
+
+  friend bool operator==(const ref_ptr_c &lhs, const ref_ptr_c &rhs) noexcept {
+    return lhs.ptr_ == rhs.ptr_;
+  }
+
+  friend bool operator==(const ref_ptr_c &lhs, std::nullptr_t) noexcept {
+    return lhs.ptr_ == nullptr;
+  }
+
+private:
+  T *ptr_{nullptr};
+};
+
+//! \brief Construct an object and take the first reference to it
+template <typename T, typename... Args>
+inline ref_ptr_c<T> make_ref(Args &&...args) {
+  return ref_ptr_c<T>(new T(std::forward<Args>(args)...));
+}
+
+} // namespace nibi
+
+template <typename T> struct std::hash<nibi::ref_ptr_c<T>> {
+  std::size_t operator()(const nibi::ref_ptr_c<T> &ptr) const noexcept {
+    return std::hash<T *>()(ptr.get());
+  }
+};
@@ -0,0 +1,44 @@
+#include "serial.hpp"
+
+#include <fstream>
+#include <random>
+#include <system_error>
+
+namespace nibi {
+
+uint64_t serial_checksum(std::string_view data) {
+  // FNV-1a
+  uint64_t hash = 0xcbf29ce484222325;
+  for (auto c : data) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+bool serial_replace_file(const std::filesystem::path &file,
+                         std::string_view data) {
+  // Others may be replacing the same file, so each writes its own
+  auto temporary = file;
+  temporary += ".";
+  temporary += std::to_string(std::random_device()());
+
+  std::error_code ec;
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+    out.close();
+    if (!out) {
+      std::filesystem::remove(temporary, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(temporary, file, ec);
+  if (ec) {
+    std::filesystem::remove(temporary, ec);
+    return false;
+  }
+  return true;
+}
+
+} // namespace nibi
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace nibi {
+
+//! \brief Writes values to a buffer, as they are laid out in memory
+//!        on this machine
+//! \note  Whatever reads them back has to check that it was written
+//!        by a machine with the same byte order
+class serial_writer_c {
+public:
+  //! \brief Create a writer
+  //! \param out The buffer to append to
+  serial_writer_c(std::string &out) : out_(out) {}
+
+  //! \brief Write a value
+  template <typename T> void write(const T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  //! \brief Write a string, prefixed by its length
+  void write_string(std::string_view value) {
+    write(static_cast<uint32_t>(value.size()));
+    out_.append(value);
+  }
+
+private:
+  std::string &out_;
+};
+
+//! \brief Reads values written by a serial writer
+//! \note  Reads fail rather than going past the end of the data
+class serial_reader_c {
+public:
+  //! \brief Create a reader
+  //! \param data The data to read, which must outlive the reader
+  serial_reader_c(std::string_view data) : data_(data) {}
+
+  //! \brief Read a value
+  //! \return false if there isn't enough data left
+  template <typename T> bool read(T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (data_.size() < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, data_.data(), sizeof(T));
+    data_.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  //! \brief Read a string
+  //! \param value Set to a view of the string within the data
+  //! \return false if there isn't enough data left
+  bool read_string(std::string_view &value) {
+    uint32_t length{0};
+    if (!read(length) || data_.size() < length) {
+      return false;
+    }
+    value = data_.substr(0, length);
+    data_.remove_prefix(length);
+    return true;
+  }
+
+  //! \brief Read a count of the items that follow
+  //! \param count Set to the count
+  //! \param min_size The fewest bytes that each of the items takes
+  //! \return false if there isn't enough data left for that many items
+  bool read_count(uint32_t &count, const std::size_t min_size) {
+    return read(count) && count <= data_.size() / min_size;
+  }
+
+  //! \brief Get the data that has yet to be read
+  std::string_view remaining() const { return data_; }
+
+  //! \brief Check if everything has been read
+  bool at_end() const { return data_.empty(); }
+
+private:
+  std::string_view data_;
+};
+
+//! \brief Get a checksum of data, for telling if it has been damaged
+extern uint64_t serial_checksum(std::string_view data);
+
+//! \brief Replace the contents of a file, writing them aside first and
+//!        then moving them into place, so that the file is never seen
+//!        half written
+//! \param file The file to write
+//! \param data The contents of the file
+//! \return false if the file could not be written
+extern bool serial_replace_file(const std::filesystem::path &file,
+                                std::string_view data);
+
+} // namespace nibi
@@ -0,0 +1,807 @@
+#include "snapshot.hpp"
+#include "libnibi/interpreter/builtins/builtins.hpp"
+#include "libnibi/interpreter/interpreter.hpp"
+#include "libnibi/serial.hpp"
+#include "libnibi/source.hpp"
+#include "libnibi/version.hpp"
+
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+/*
+    A snapshot holds a header that identifies what it was made from,
+    the source files that were loaded in making it, the modules that
+    were loaded, tables of the sources of locators and of names, and
+    then the bindings of the environment.
+
+    header        - magic format_version byte_order_mark
+                    string(libnibi version) string(source)
+                    u64(checksum)
+    dependencies  - u32(count) (string(path) i64(modification time)
+                    u64(size))+
+    modules       - u32(count) string+
+    sources       - u32(count) string+
+    names         - u32(count) string+
+    bindings      - u32(count) (u32(name) cell)+
+    cell          - u8(tag) [u32(source) u32(line) u32(column)]? <data>
+
+    The tag is the type of the cell, with its high bit set if the cell
+    has a locator. Sources and names are given by their index in the
+    tables. Functions of modules are stored as the name of the module
+    and of the function, and are found in the module once it is loaded.
+    The checksum is of everything that follows it in the snapshot.
+*/
+
+namespace nibi {
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'N', 'I', 'B', 'I', 'S', 'N', 'A', 'P'};
+constexpr uint32_t SNAPSHOT_FORMAT_VERSION = 2;
+constexpr uint32_t SNAPSHOT_BYTE_ORDER_MARK = 0x01020304;
+
+constexpr uint8_t TAG_HAS_LOCATOR = 0x80;
+constexpr uint8_t TAG_NIL = 0;
+constexpr uint8_t TAG_INTEGER = 1;
+constexpr uint8_t TAG_DOUBLE = 2;
+constexpr uint8_t TAG_STRING = 3;
+constexpr uint8_t TAG_SYMBOL = 4;
+constexpr uint8_t TAG_LIST = 5;
+constexpr uint8_t TAG_DICT = 6;
+constexpr uint8_t TAG_BUILTIN = 7;
+constexpr uint8_t TAG_LAMBDA = 8;
+constexpr uint8_t TAG_FAUX = 9;
+constexpr uint8_t TAG_MODULE_FUNCTION = 10;
+
+constexpr uint8_t LIST_RESOLVED = 0x01;
+constexpr uint8_t LIST_TAIL_CALL = 0x02;
+
+// The fewest bytes taken by a string, a name, and a cell
+constexpr std::size_t MIN_STRING_SIZE = sizeof(uint32_t);
+constexpr std::size_t MIN_NAME_SIZE = sizeof(uint32_t);
+constexpr std::size_t MIN_CELL_SIZE = sizeof(uint8_t);
+constexpr std::size_t MIN_DEPENDENCY_SIZE =
+    MIN_STRING_SIZE + sizeof(int64_t) + sizeof(uint64_t);
+
+struct dependency_s {
+  int64_t modified{0};
+  uint64_t size{0};
+};
+
+std::optional<dependency_s> get_dependency(const std::string &path) {
+  std::error_code ec;
+  auto modified = std::filesystem::last_write_time(path, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  auto size = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  return dependency_s{
+      static_cast<int64_t>(modified.time_since_epoch().count()), size};
+}
+
+// Modules are bound in the root environment by their name
+bool is_module_binding(env_c &root, const symbol_id_t name, cell_c &cell) {
+  return cell.type == cell_type_e::ENVIRONMENT &&
+         root.get_loaded_modules().contains(symbol_name(name));
+}
+
+// Writes the bindings of an environment, and the tables they refer to
+class encoder_c {
+public:
+  encoder_c(env_c &root) : root_(root) {
+    for (auto &name : root_.get_loaded_modules()) {
+      auto module = root_.get(name);
+      if (module && module->type == cell_type_e::ENVIRONMENT) {
+        modules_[module->as_environment_info().env.get()] = name;
+      }
+    }
+  }
+
+  bool encode_bindings() {
+    serial_writer_c out(bindings_);
+    uint32_t count{0};
+    for (auto &[name, cell] : root_.get_map()) {
+      if (is_module_binding(root_, name, *cell)) {
+        continue;
+      }
+      count++;
+    }
+    out.write(count);
+    for (auto &[name, cell] : root_.get_map()) {
+      if (is_module_binding(root_, name, *cell)) {
+        continue;
+      }
+      out.write(name_id(name));
+      if (!encode(*cell)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void write_tables(std::string &data) {
+    serial_writer_c out(data);
+    out.write(static_cast<uint32_t>(sources_.size()));
+    for (auto source : sources_) {
+      out.write_string(source_manager_c::get_registered_name(source));
+    }
+    out.write(static_cast<uint32_t>(names_.size()));
+    for (auto name : names_) {
+      out.write_string(symbol_name(name));
+    }
+    data.append(bindings_);
+  }
+
+private:
+  env_c &root_;
+  std::string bindings_;
+  std::vector<uint32_t> sources_;
+  std::unordered_map<uint32_t, uint32_t> source_ids_;
+  std::vector<symbol_id_t> names_;
+  std::unordered_map<symbol_id_t, uint32_t> name_ids_;
+  std::unordered_map<const env_c *, std::string> modules_;
+
+  uint32_t name_id(const symbol_id_t name) {
+    auto [it, added] =
+        name_ids_.emplace(name, static_cast<uint32_t>(names_.size()));
+    if (added) {
+      names_.push_back(name);
+    }
+    return it->second;
+  }
+
+  uint32_t source_id(const uint32_t source) {
+    auto [it, added] =
+        source_ids_.emplace(source, static_cast<uint32_t>(sources_.size()));
+    if (added) {
+      sources_.push_back(source);
+    }
+    return it->second;
+  }
+
+  const std::string *module_of(const env_c *env) {
+    auto it = modules_.find(env);
+    return it != modules_.end() ? &it->second : nullptr;
+  }
+
+  // Find what a function is, and so how it can be bound again
+  uint8_t function_tag(const function_info_s &info) {
+    switch (info.type) {
+    case function_type_e::BUILTIN_CPP_FUNCTION: {
+      auto &router = builtins::get_builtin_symbols_map();
+      auto builtin = router.find(intern_symbol(info.name));
+      if (builtin != router.end() && builtin->second.fn == info.fn) {
+        return TAG_BUILTIN;
+      }
+      return TAG_NIL;
+    }
+    case function_type_e::LAMBDA_FUNCTION:
+      if (module_of(info.operating_env)) {
+        return TAG_MODULE_FUNCTION;
+      }
+      // Lambdas that share the environment of a call can't be saved
+      if (info.fn == builtins::execute_suspected_lambda &&
+          info.lambda.has_value() && info.operating_env == &root_ &&
+          !info.captured_env) {
+        return TAG_LAMBDA;
+      }
+      return TAG_NIL;
+    case function_type_e::FAUX:
+      if (builtins::get_faux_function(info.name) == info.fn) {
+        return TAG_FAUX;
+      }
+      return TAG_NIL;
+    case function_type_e::EXTERNAL_FUNCTION:
+      return module_of(info.operating_env) ? TAG_MODULE_FUNCTION : TAG_NIL;
+    default:
+      return TAG_NIL;
+    }
+  }
+
+  bool encode(cell_c &cell) {
+    uint8_t tag{TAG_NIL};
+    switch (cell.type) {
+    case cell_type_e::NIL:
+      break;
+    case cell_type_e::INTEGER:
+      tag = TAG_INTEGER;
+      break;
+    case cell_type_e::DOUBLE:
+      tag = TAG_DOUBLE;
+      break;
+    case cell_type_e::STRING:
+      tag = TAG_STRING;
+      break;
+    case cell_type_e::SYMBOL:
+      tag = TAG_SYMBOL;
+      break;
+    case cell_type_e::LIST:
+      tag = TAG_LIST;
+      break;
+    case cell_type_e::DICT:
+      tag = TAG_DICT;
+      break;
+    case cell_type_e::FUNCTION:
+      tag = function_tag(*cell.data.fn);
+      if (tag == TAG_NIL) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+    }
+
+    serial_writer_c out(bindings_);
+    if (cell.locator) {
+      out.write(static_cast<uint8_t>(tag | TAG_HAS_LOCATOR));
+      out.write(source_id(cell.locator.get_source_id()));
+      out.write(static_cast<uint32_t>(cell.locator.get_line()));
+      out.write(static_cast<uint32_t>(cell.locator.get_column()));
+    } else {
+      out.write(tag);
+    }
+
+    switch (tag) {
+    case TAG_INTEGER:
+      out.write(cell.data.i);
+      return true;
+    case TAG_DOUBLE:
+      out.write(cell.data.d);
+      return true;
+    case TAG_STRING:
+      out.write_string(cell.data.str->value);
+      return true;
+    case TAG_SYMBOL:
+      out.write(name_id(cell.data.sym->id));
+      return true;
+    case TAG_LIST:
+      return encode_list(cell);
+    case TAG_DICT: {
+      auto &dict = cell.data.dict->value;
+      out.write(static_cast<uint8_t>(cell.data.dict->resolved));
+      out.write(static_cast<uint32_t>(dict.size()));
+      for (auto &[key, value] : dict) {
+        out.write_string(key);
+        if (!encode(*value)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case TAG_BUILTIN:
+      out.write(name_id(intern_symbol(cell.data.fn->name)));
+      return true;
+    case TAG_LAMBDA: {
+      auto &info = *cell.data.fn;
+      auto &arg_names = *info.lambda->arg_names;
+      out.write_string(info.name);
+      out.write(static_cast<uint32_t>(arg_names.size()));
+      for (auto name : arg_names) {
+        out.write(name_id(name));
+      }
+      out.write(static_cast<uint8_t>(info.lambda->defines_functions));
+      return encode(*info.lambda->body);
+    }
+    case TAG_FAUX: {
+      // Fauxs own their environment, so it is saved with them
+      auto &info = *cell.data.fn;
+      out.write_string(info.name);
+      if (!info.operating_env) {
+        out.write(uint32_t{0});
+        return true;
+      }
+      auto &bindings = info.operating_env->get_map();
+      out.write(static_cast<uint32_t>(bindings.size()));
+      for (auto &[name, value] : bindings) {
+        out.write(name_id(name));
+        if (!encode(*value)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case TAG_MODULE_FUNCTION: {
+      auto &info = *cell.data.fn;
+      out.write_string(*module_of(info.operating_env));
+      out.write(name_id(intern_symbol(info.name)));
+      return true;
+    }
+    }
+    return true;
+  }
+
+  bool encode_list(cell_c &cell) {
+    serial_writer_c out(bindings_);
+    auto &info = cell.data.list->value;
+    uint8_t flags{0};
+    if (cell.data.list->resolved) {
+      flags |= LIST_RESOLVED;
+    }
+    if (info.tail_call) {
+      flags |= LIST_TAIL_CALL;
+    }
+    out.write(static_cast<uint8_t>(info.type));
+    out.write(flags);
+
+    // Numeric storage is written as it is held
+    if (info.numeric) {
+      out.write(static_cast<uint8_t>(info.numeric->type));
+      out.write(static_cast<uint32_t>(info.numeric->size()));
+      if (info.numeric->type == cell_type_e::INTEGER) {
+        bindings_.append(
+            reinterpret_cast<const char *>(info.numeric->integers.data()),
+            info.numeric->integers.size() * sizeof(int64_t));
+      } else {
+        bindings_.append(
+            reinterpret_cast<const char *>(info.numeric->doubles.data()),
+            info.numeric->doubles.size() * sizeof(double));
+      }
+    } else {
+      out.write(static_cast<uint8_t>(cell_type_e::NIL));
+    }
+
+    out.write(static_cast<uint32_t>(info.list.size()));
+    for (auto &item : info.list) {
+      if (!encode(*item)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// Rebuilds the bindings of an environment
+class decoder_c {
+public:
+  decoder_c(serial_reader_c &reader, env_c &root)
+      : reader_(reader), root_(root) {}
+
+  bool decode_tables() {
+    uint32_t count{0};
+    if (!reader_.read_count(count, MIN_STRING_SIZE)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      std::string_view name;
+      if (!reader_.read_string(name)) {
+        return false;
+      }
+      sources_.push_back(source_manager_c::register_source(std::string(name)));
+    }
+    if (!reader_.read_count(count, MIN_STRING_SIZE)) {
+      return false;
+    }
+    names_.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+      std::string_view name;
+      if (!reader_.read_string(name)) {
+        return false;
+      }
+      names_.push_back(intern_symbol(name));
+    }
+    return true;
+  }
+
+  bool decode_bindings(std::vector<std::pair<symbol_id_t, cell_ptr>> &out) {
+    uint32_t count{0};
+    if (!reader_.read_count(count, MIN_NAME_SIZE + MIN_CELL_SIZE)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      symbol_id_t name{0};
+      if (!read_name(name)) {
+        return false;
+      }
+      auto cell = decode();
+      if (!cell) {
+        return false;
+      }
+      out.emplace_back(name, cell);
+    }
+    return reader_.at_end();
+  }
+
+private:
+  serial_reader_c &reader_;
+  env_c &root_;
+  std::vector<uint32_t> sources_;
+  std::vector<symbol_id_t> names_;
+
+  bool read_name(symbol_id_t &name) {
+    uint32_t index{0};
+    if (!reader_.read(index) || index >= names_.size()) {
+      return false;
+    }
+    name = names_[index];
+    return true;
+  }
+
+  cell_ptr decode() {
+    uint8_t tag{0};
+    if (!reader_.read(tag)) {
+      return nullptr;
+    }
+
+    locator_ptr locator{nullptr};
+    if (tag & TAG_HAS_LOCATOR) {
+      uint32_t source{0};
+      uint32_t line{0};
+      uint32_t column{0};
+      if (!reader_.read(source) || source >= sources_.size() ||
+          !reader_.read(line) || !reader_.read(column)) {
+        return nullptr;
+      }
+      locator = locator_c(sources_[source], line, column);
+    }
+
+    auto cell = decode_data(tag & ~TAG_HAS_LOCATOR);
+    if (cell) {
+      cell->locator = locator;
+    }
+    return cell;
+  }
+
+  cell_ptr decode_data(const uint8_t tag) {
+    switch (tag) {
+    case TAG_NIL:
+      return allocate_cell(cell_type_e::NIL);
+    case TAG_INTEGER: {
+      int64_t value{0};
+      return reader_.read(value) ? allocate_cell(value) : nullptr;
+    }
+    case TAG_DOUBLE: {
+      double value{0.0};
+      return reader_.read(value) ? allocate_cell(value) : nullptr;
+    }
+    case TAG_STRING: {
+      std::string_view value;
+      return reader_.read_string(value) ? allocate_cell(std::string(value))
+                                        : nullptr;
+    }
+    case TAG_SYMBOL: {
+      symbol_id_t name{0};
+      return read_name(name) ? allocate_cell(symbol_s{name}) : nullptr;
+    }
+    case TAG_LIST:
+      return decode_list();
+    case TAG_DICT: {
+      uint8_t resolved{0};
+      uint32_t count{0};
+      if (!reader_.read(resolved) ||
+          !reader_.read_count(count, MIN_STRING_SIZE + MIN_CELL_SIZE)) {
+        return nullptr;
+      }
+      cell_dict_t dict;
+      for (uint32_t i = 0; i < count; i++) {
+        std::string_view key;
+        if (!reader_.read_string(key)) {
+          return nullptr;
+        }
+        auto value = decode();
+        if (!value) {
+          return nullptr;
+        }
+        dict[std::string(key)] = value;
+      }
+      auto cell = allocate_cell(std::move(dict));
+      cell->data.dict->resolved = resolved;
+      return cell;
+    }
+    case TAG_BUILTIN: {
+      symbol_id_t name{0};
+      if (!read_name(name)) {
+        return nullptr;
+      }
+      auto &router = builtins::get_builtin_symbols_map();
+      auto builtin = router.find(name);
+      if (builtin == router.end()) {
+        return nullptr;
+      }
+      return allocate_cell(builtin->second);
+    }
+    case TAG_LAMBDA:
+      return decode_lambda();
+    case TAG_FAUX:
+      return decode_faux();
+    case TAG_MODULE_FUNCTION: {
+      std::string_view module_name;
+      symbol_id_t name{0};
+      if (!reader_.read_string(module_name) || !read_name(name)) {
+        return nullptr;
+      }
+      auto module = root_.get(std::string(module_name));
+      if (!module || module->type != cell_type_e::ENVIRONMENT) {
+        return nullptr;
+      }
+      auto function = module->as_environment_info().env->get(name);
+      if (!function || function->type != cell_type_e::FUNCTION) {
+        return nullptr;
+      }
+      return function->clone(root_);
+    }
+    default:
+      return nullptr;
+    }
+  }
+
+  cell_ptr decode_list() {
+    uint8_t type{0};
+    uint8_t flags{0};
+    uint8_t numeric_type{0};
+    if (!reader_.read(type) ||
+        type > static_cast<uint8_t>(list_types_e::ACCESS) ||
+        !reader_.read(flags) || !reader_.read(numeric_type)) {
+      return nullptr;
+    }
+
+    list_info_s info(static_cast<list_types_e>(type));
+    info.tail_call = flags & LIST_TAIL_CALL;
+
+    switch (static_cast<cell_type_e>(numeric_type)) {
+    case cell_type_e::NIL:
+      break;
+    case cell_type_e::INTEGER: {
+      std::vector<int64_t> items;
+      if (!decode_numbers(items)) {
+        return nullptr;
+      }
+      info.numeric = std::make_unique<numeric_list_s>(std::move(items));
+      break;
+    }
+    case cell_type_e::DOUBLE: {
+      std::vector<double> items;
+      if (!decode_numbers(items)) {
+        return nullptr;
+      }
+      info.numeric = std::make_unique<numeric_list_s>(std::move(items));
+      break;
+    }
+    default:
+      return nullptr;
+    }
+
+    uint32_t count{0};
+    if (!reader_.read_count(count, MIN_CELL_SIZE)) {
+      return nullptr;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      auto item = decode();
+      if (!item) {
+        return nullptr;
+      }
+      info.list.push_back(item);
+    }
+
+    auto cell = allocate_cell(std::move(info));
+    cell->data.list->resolved = flags & LIST_RESOLVED;
+    return cell;
+  }
+
+  template <typename T> bool decode_numbers(std::vector<T> &items) {
+    uint32_t count{0};
+    if (!reader_.read_count(count, sizeof(T))) {
+      return false;
+    }
+    items.resize(count);
+    for (auto &item : items) {
+      if (!reader_.read(item)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  cell_ptr decode_lambda() {
+    std::string_view name;
+    uint32_t count{0};
+    if (!reader_.read_string(name) ||
+        !reader_.read_count(count, MIN_NAME_SIZE)) {
+      return nullptr;
+    }
+    auto arg_names = std::make_shared<env_layout_t>();
+    for (uint32_t i = 0; i < count; i++) {
+      symbol_id_t arg{0};
+      if (!read_name(arg)) {
+        return nullptr;
+      }
+      arg_names->push_back(arg);
+    }
+    uint8_t defines_functions{0};
+    if (!reader_.read(defines_functions)) {
+      return nullptr;
+    }
+    auto body = decode();
+    if (!body || body->type != cell_type_e::LIST) {
+      return nullptr;
+    }
+
+    function_info_s info(std::string(name), builtins::execute_suspected_lambda,
+                         function_type_e::LAMBDA_FUNCTION, &root_);
+    info.lambda = lambda_info_s{arg_names, body, defines_functions != 0};
+    return allocate_cell(std::move(info));
+  }
+
+  cell_ptr decode_faux() {
+    std::string_view name;
+    uint32_t count{0};
+    if (!reader_.read_string(name) ||
+        !reader_.read_count(count, MIN_NAME_SIZE + MIN_CELL_SIZE)) {
+      return nullptr;
+    }
+    auto fn = builtins::get_faux_function(std::string(name));
+    if (!fn) {
+      return nullptr;
+    }
+
+    // The cell owns the environment once it is made
+    auto cell = allocate_cell(function_info_s(
+        std::string(name), fn, function_type_e::FAUX, new env_c()));
+    auto &env = *cell->data.fn->operating_env;
+    for (uint32_t i = 0; i < count; i++) {
+      symbol_id_t binding{0};
+      if (!read_name(binding)) {
+        return nullptr;
+      }
+      auto value = decode();
+      if (!value) {
+        return nullptr;
+      }
+      env.define(binding, value);
+    }
+    return cell;
+  }
+};
+
+} // namespace
+
+bool snapshot_c::save(const std::filesystem::path &file,
+                      const std::string &source, interpreter_c &ci) {
+  auto &root = ci.get_env();
+  auto &sm = ci.get_source_manager();
+
+  encoder_c encoder(root);
+  if (!encoder.encode_bindings()) {
+    return false;
+  }
+
+  std::string data;
+  serial_writer_c out(data);
+  data.append(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  out.write(SNAPSHOT_FORMAT_VERSION);
+  out.write(SNAPSHOT_BYTE_ORDER_MARK);
+  out.write_string(LIBNIBI_VERSION);
+  out.write_string(source);
+
+  // The size is that of the text that was interpreted, so a source
+  // that has changed since makes the snapshot stale straight away
+  std::string payload;
+  serial_writer_c payload_out(payload);
+  auto dependencies = sm.get_loaded_sources();
+  payload_out.write(static_cast<uint32_t>(dependencies.size()));
+  for (auto &path : dependencies) {
+    auto dependency = get_dependency(path);
+    if (!dependency) {
+      return false;
+    }
+    dependency->size = sm.get_source(path)->get_text()->get_data().size();
+    payload_out.write_string(path);
+    payload_out.write(dependency->modified);
+    payload_out.write(dependency->size);
+  }
+
+  auto &modules = root.get_loaded_modules();
+  payload_out.write(static_cast<uint32_t>(modules.size()));
+  for (auto &name : modules) {
+    payload_out.write_string(name);
+  }
+
+  encoder.write_tables(payload);
+  out.write(serial_checksum(payload));
+  data.append(payload);
+  return serial_replace_file(file, data);
+}
+
+bool snapshot_c::restore(const std::filesystem::path &file,
+                         const std::string &source, interpreter_c &ci) {
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(file, ec)) {
+    return false;
+  }
+
+  // The snapshot is read where it is mapped, it isn't split into lines
+  auto snapshot = source_text_c::load(file.string(), false);
+  if (!snapshot) {
+    return false;
+  }
+
+  serial_reader_c reader(snapshot->get_data());
+  char magic[sizeof(SNAPSHOT_MAGIC)];
+  uint32_t format_version{0};
+  uint32_t byte_order_mark{0};
+  std::string_view version;
+  std::string_view made_from;
+  uint64_t checksum{0};
+  if (!reader.read(magic) ||
+      std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0 ||
+      !reader.read(format_version) ||
+      format_version != SNAPSHOT_FORMAT_VERSION ||
+      !reader.read(byte_order_mark) ||
+      byte_order_mark != SNAPSHOT_BYTE_ORDER_MARK ||
+      !reader.read_string(version) || version != LIBNIBI_VERSION ||
+      !reader.read_string(made_from) || made_from != source ||
+      !reader.read(checksum) ||
+      checksum != serial_checksum(reader.remaining())) {
+    return false;
+  }
+
+  // Every source is checked before anything is restored
+  uint32_t count{0};
+  if (!reader.read_count(count, MIN_DEPENDENCY_SIZE)) {
+    return false;
+  }
+  std::vector<std::string> dependencies;
+  for (uint32_t i = 0; i < count; i++) {
+    std::string_view path;
+    dependency_s recorded;
+    if (!reader.read_string(path) || !reader.read(recorded.modified) ||
+        !reader.read(recorded.size)) {
+      return false;
+    }
+    dependencies.emplace_back(path);
+    auto dependency = get_dependency(dependencies.back());
+    if (!dependency || dependency->modified != recorded.modified ||
+        dependency->size != recorded.size) {
+      return false;
+    }
+  }
+
+  std::vector<std::string> modules;
+  if (!reader.read_count(count, MIN_STRING_SIZE)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    std::string_view name;
+    if (!reader.read_string(name)) {
+      return false;
+    }
+    modules.emplace_back(name);
+  }
+
+  // Modules are loaded first, as functions may be bound from them
+  auto &root = ci.get_env();
+  try {
+    for (auto &name : modules) {
+      auto module_name = allocate_cell(name);
+      ci.load_module(module_name);
+    }
+  } catch (interpreter_c::exception_c &) {
+    return false;
+  }
+
+  decoder_c decoder(reader, root);
+  std::vector<std::pair<symbol_id_t, cell_ptr>> bindings;
+  if (!decoder.decode_tables() || !decoder.decode_bindings(bindings)) {
+    return false;
+  }
+
+  for (auto &[name, cell] : bindings) {
+    root.set(name, cell);
+  }
+
+  // The sources count as having been loaded, so that
+  // importing them again does nothing
+  auto &sm = ci.get_source_manager();
+  for (auto &path : dependencies) {
+    sm.get_source(path);
+  }
+  return true;
+}
+
+} // namespace nibi
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+namespace nibi {
+
+class interpreter_c;
+
+//! \brief Snapshots of the environment that interpreting a source leaves
+//!        behind, so that it can be restored rather than interpreting the
+//!        source again
+//! \note  Values, lambdas, dicts and macros are saved as they are. Modules
+//!        are loaded again by name, which binds the functions of their
+//!        libraries by symbol. A snapshot is only restored while every
+//!        source file that was loaded in making it is unchanged
+class snapshot_c {
+public:
+  //! \brief Save the environment of an interpreter
+  //! \param file The file to save the snapshot to
+  //! \param source The source that was interpreted to populate it
+  //! \param ci The interpreter
+  //! \return false if the environment holds something that can't be
+  //!         saved, or the file can't be written
+  static bool save(const std::filesystem::path &file,
+                   const std::string &source, interpreter_c &ci);
+
+  //! \brief Restore the environment of an interpreter
+  //! \param file The file that the snapshot was saved to
+  //! \param source The source that the snapshot must have been made from
+  //! \param ci The interpreter, whose environment should be empty
+  //! \return false if the snapshot is missing, damaged, or was made from
+  //!         sources that have since changed. The source should then be
+  //!         interpreted instead, modules that were loaded from the
+  //!         snapshot are left loaded
+  static bool restore(const std::filesystem::path &file,
+                      const std::string &source, interpreter_c &ci);
+};
+
+} // namespace nibi
@@ -1,13 +1,243 @@
 #include "libnibi/source.hpp"
+#include "libnibi/config.hpp"
 #include "libnibi/rang.hpp"
 
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 #include <vector>
 
+#if defined(__linux__) || defined(__APPLE__) || defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NIBI_SOURCE_MMAP 1
+#else
+#define NIBI_SOURCE_MMAP 0
+#endif
+
 namespace nibi {
-void draw_locator(locator_if &location) {
+
+namespace {
+
+//! \brief The table that every source is registered in, so that
+//!        locators only need to hold the id of their source
+//! \note  Entries are held in a deque so that references to them,
+//!        and the views used as keys, are never invalidated
+class source_table_c {
+public:
+  // Id 0 is never given out, so that an empty locator is all zeros
+  source_table_c() { entries_.emplace_back(); }
+
+  uint32_t add(const std::string &name) {
+    {
+      std::shared_lock lock(mutex_);
+      auto it = ids_.find(name);
+      if (it != ids_.end()) {
+        return it->second;
+      }
+    }
+
+    std::unique_lock lock(mutex_);
+
+    // Another thread may have registered it while unlocked
+    auto it = ids_.find(name);
+    if (it != ids_.end()) {
+      return it->second;
+    }
+
+    auto id = static_cast<uint32_t>(entries_.size());
+    auto &entry = entries_.emplace_back();
+    entry.name = name;
+    ids_.emplace(std::string_view(entry.name), id);
+    return id;
+  }
+
+  const std::string &name(const uint32_t id) {
+    std::shared_lock lock(mutex_);
+    return entries_[id].name;
+  }
+
+  std::shared_ptr<source_text_c> text(const uint32_t id) {
+    std::shared_lock lock(mutex_);
+    return entries_[id].text;
+  }
+
+  void set_text(const uint32_t id, std::shared_ptr<source_text_c> text) {
+    std::unique_lock lock(mutex_);
+    entries_[id].text = text;
+  }
+
+private:
+  struct entry_s {
+    std::string name;
+    std::shared_ptr<source_text_c> text{nullptr};
+  };
+
+  std::shared_mutex mutex_;
+  std::deque<entry_s> entries_;
+  std::unordered_map<std::string_view, uint32_t> ids_;
+};
+
+// Constructed on first use so that sources can be
+// registered during static initialization
+source_table_c &get_source_table() {
+  static source_table_c table;
+  return table;
+}
+
+} // namespace
+
+uint32_t source_manager_c::register_source(const std::string &source_name) {
+  return get_source_table().add(source_name);
+}
+
+const std::string &source_manager_c::get_registered_name(const uint32_t id) {
+  return get_source_table().name(id);
+}
+
+std::shared_ptr<source_text_c>
+source_manager_c::get_registered_text(const uint32_t id) {
+  return get_source_table().text(id);
+}
+
+void source_manager_c::set_registered_text(
+    const uint32_t id, std::shared_ptr<source_text_c> text) {
+  get_source_table().set_text(id, text);
+}
+
+const char *locator_c::get_source_name() const {
+  return source_manager_c::get_registered_name(get_source_id()).c_str();
+}
+
+std::shared_ptr<source_text_c> locator_c::get_source_text() const {
+  return source_manager_c::get_registered_text(get_source_id());
+}
+
+source_origin_c::source_origin_c(std::string source_name)
+    : id_(source_manager_c::register_source(source_name)) {}
+
+std::string source_origin_c::get_source_name() {
+  return source_manager_c::get_registered_name(id_);
+}
+
+void source_origin_c::set_text(std::shared_ptr<source_text_c> text) {
+  text_ = text;
+  source_manager_c::set_registered_text(id_, text);
+}
+
+source_text_c::~source_text_c() {
+#if NIBI_SOURCE_MMAP
+  if (mapped_) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+#endif
+}
+
+std::shared_ptr<source_text_c> source_text_c::load(const std::string &path,
+                                                   bool index_lines) {
+  std::shared_ptr<source_text_c> text(new source_text_c());
+
+#if NIBI_SOURCE_MMAP
+  // Regular files are mapped, anything else (pipes, devices) is read.
+  // Small files are read too, as mapping them costs more than copying
+  auto fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat info;
+  if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+    if (info.st_size > 0 && info.st_size < config::NIBI_SOURCE_MAP_MIN_SIZE) {
+      text->buffer_.resize(info.st_size);
+      std::size_t total{0};
+      while (total < text->buffer_.size()) {
+        auto count = ::read(fd, text->buffer_.data() + total,
+                            text->buffer_.size() - total);
+        if (count <= 0) {
+          break;
+        }
+        total += count;
+      }
+      text->buffer_.resize(total);
+      text->data_ = text->buffer_.data();
+      text->size_ = text->buffer_.size();
+    } else if (info.st_size > 0) {
+      auto mapping =
+          ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping == MAP_FAILED) {
+        ::close(fd);
+        return nullptr;
+      }
+      text->data_ = static_cast<const char *>(mapping);
+      text->size_ = info.st_size;
+      text->mapped_ = true;
+    }
+    ::close(fd);
+    if (index_lines) {
+      text->index_lines();
+    }
+    return text;
+  }
+  ::close(fd);
+#endif
+
+  std::ifstream fs(path, std::ios::binary);
+  if (!fs.is_open()) {
+    return nullptr;
+  }
+  text->buffer_.assign(std::istreambuf_iterator<char>(fs),
+                       std::istreambuf_iterator<char>());
+  text->data_ = text->buffer_.data();
+  text->size_ = text->buffer_.size();
+  if (index_lines) {
+    text->index_lines();
+  }
+  return text;
+}
+
+uint64_t source_text_c::get_hash() const {
+  // FNV-1a
+  uint64_t hash = 0xcbf29ce484222325;
+  for (std::size_t i = 0; i < size_; i++) {
+    hash ^= static_cast<unsigned char>(data_[i]);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+void source_text_c::index_lines() {
+  std::size_t start{0};
+  while (start < size_) {
+    line_starts_.push_back(start);
+    auto newline = static_cast<const char *>(
+        std::memchr(data_ + start, '\n', size_ - start));
+    if (!newline) {
+      break;
+    }
+    start = newline - data_ + 1;
+  }
+}
+
+std::string_view source_text_c::get_line(const std::size_t line) const {
+  if (line == 0 || line > line_starts_.size()) {
+    return {};
+  }
+  auto start = line_starts_[line - 1];
+  auto end = (line < line_starts_.size()) ? line_starts_[line] : size_;
+  if (end > start && data_[end - 1] == '\n') {
+    end--;
+  }
+  return {data_ + start, end - start};
+}
+
+void draw_locator(const locator_c &location) {
 
   std::cout << rang::fg::magenta << location.get_source_name()
             << rang::fg::reset << " : (" << rang::fg::blue
@@ -16,23 +246,23 @@ void draw_locator(locator_if &location) {
 
   struct line_data_pair_s {
     uint64_t number;
-    std::string data;
+    std::string_view data;
   };
 
-  std::ifstream fs;
-  fs.open(location.get_source_name());
+  // Use the text loaded for the source, only sources that were not
+  // read from a file as a whole need to be loaded here
+  auto text = location.get_source_text();
+  if (!text) {
+    text = source_text_c::load(location.get_source_name());
+  }
 
-  if (!fs.is_open()) {
+  if (!text) {
     return;
   }
 
   // A window of source
   std::vector<line_data_pair_s> window;
 
-  // Get to the line
-  std::string line_data;
-  uint64_t line_number{0};
-
   // Determine the upper and lower bound for a source code window
   int64_t upper_bound = location.get_line() + 4;
   int64_t lower_bound = (int64_t)location.get_line() - 5;
@@ -40,9 +270,11 @@ void draw_locator(locator_if &location) {
     lower_bound = 0;
   }
 
-  // Build a window of source code to display
-  while (std::getline(fs, line_data)) {
-    line_number++;
+  // Build a window of source code to display, lines before the lower
+  // bound are never a part of it
+  for (uint64_t line_number = (lower_bound > 0) ? lower_bound : 1;
+       line_number <= text->get_line_count(); line_number++) {
+    auto line_data = text->get_line(line_number);
     if ((line_number >= lower_bound && lower_bound < location.get_line()) ||
         location.get_line() == line_number ||
         line_number > location.get_line() && line_number < upper_bound) {
@@ -85,6 +317,5 @@ void draw_locator(locator_if &location) {
                 << line_data.data << std::endl;
     }
   }
-  fs.close();
 }
 } // namespace nibi
\ No newline at end of file
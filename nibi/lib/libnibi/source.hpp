@@ -1,52 +1,118 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 namespace nibi {
-//! \brief A locator interface.
-//!       Used to locate errors in the source.
-class locator_if {
+
+//! \brief The text of a source file, loaded once and indexed by line
+//!        so that any line can be found without scanning for it.
+//!        Files are memory mapped where the platform allows it, unless
+//!        they are small enough to be read quicker.
+class source_text_c {
 public:
-  virtual ~locator_if() = default;
-  virtual const size_t get_line() const = 0;
-  virtual const size_t get_column() const = 0;
-  virtual const char *get_source_name() const = 0;
-  virtual std::tuple<size_t, size_t> get_line_column() const = 0;
-};
+  source_text_c(const source_text_c &) = delete;
+  source_text_c(source_text_c &&) = delete;
+  ~source_text_c();
 
-// Shorthand for a shared locator interface pointer.
-using locator_ptr = std::shared_ptr<locator_if>;
+  //! \brief Load the text of a file.
+  //! \param path The path of the file.
+  //! \param index_lines Index the lines of the file, which files that
+  //!        aren't text can do without.
+  //! \return nullptr if the file could not be read.
+  static std::shared_ptr<source_text_c> load(const std::string &path,
+                                             bool index_lines = true);
 
-extern void draw_locator(locator_if &location);
+  //! \brief Get all of the text.
+  std::string_view get_data() const { return {data_, size_}; }
+  //! \brief Get a hash of all of the text, for telling if it has changed.
+  uint64_t get_hash() const;
+  //! \brief Get the number of lines in the text.
+  std::size_t get_line_count() const { return line_starts_.size(); }
+  //! \brief Get a line of the text, without its newline.
+  //! \param line The line number, starting from 1.
+  //! \note Lines that don't exist are empty.
+  std::string_view get_line(const std::size_t line) const;
+
+private:
+  source_text_c() = default;
+  void index_lines();
 
-//! \brief A locator implementation.
-class locator_c final : public locator_if {
+  const char *data_{nullptr};
+  std::size_t size_{0};
+  bool mapped_{false};
+  std::string buffer_;
+  std::vector<std::size_t> line_starts_;
+};
+
+//! \brief A location within a source, packed into 64 bits.
+//!        The name and text of the source are looked up from its id,
+//!        as registered with the source manager, when they are needed.
+//! \note Lines beyond 2^24 and columns beyond 2^18 are clamped.
+class locator_c {
 public:
+  //! \brief Create an empty locator, one that doesn't locate anything.
+  locator_c() = default;
+  locator_c(std::nullptr_t) {}
+
   //! \brief Create the locator.
-  //! \param source The name of the source.
+  //! \param source The id of the source.
   //! \param line The line of the source.
   //! \param column The column of the source.
-  locator_c(std::shared_ptr<std::string> source, const size_t line,
-            const size_t column)
-      : line_(line), column_(column), source_name_(source) {}
-  virtual std::tuple<size_t, size_t> get_line_column() const override {
-    return std::make_tuple(line_, column_);
+  locator_c(const uint32_t source, const size_t line, const size_t column)
+      : packed_((static_cast<uint64_t>(source) << (LINE_BITS + COLUMN_BITS)) |
+                (clamp(line, LINE_BITS) << COLUMN_BITS) |
+                clamp(column, COLUMN_BITS)) {}
+
+  //! \brief Check if the locator locates anything.
+  explicit operator bool() const { return packed_ != 0; }
+  bool operator==(const locator_c &other) const = default;
+  bool operator==(std::nullptr_t) const { return packed_ == 0; }
+
+  //! \brief Locators are small enough to be passed by value, this lets
+  //!        them be used with the same syntax as a pointer.
+  const locator_c *operator->() const { return this; }
+
+  //! \brief Get the id of the source.
+  uint32_t get_source_id() const {
+    return static_cast<uint32_t>(packed_ >> (LINE_BITS + COLUMN_BITS));
+  }
+  const size_t get_line() const {
+    return (packed_ >> COLUMN_BITS) & ((uint64_t{1} << LINE_BITS) - 1);
   }
-  virtual const size_t get_line() const override { return line_; }
-  virtual const size_t get_column() const override { return column_; }
-  virtual const char *get_source_name() const override {
-    return source_name_->c_str();
+  const size_t get_column() const {
+    return packed_ & ((uint64_t{1} << COLUMN_BITS) - 1);
   }
+  std::tuple<size_t, size_t> get_line_column() const {
+    return std::make_tuple(get_line(), get_column());
+  }
+  //! \brief Get the name of the source.
+  const char *get_source_name() const;
+  //! \brief Get the text of the source, if it has been loaded.
+  std::shared_ptr<source_text_c> get_source_text() const;
 
 private:
-  const size_t line_{0};
-  const size_t column_{0};
-  std::shared_ptr<std::string> source_name_{nullptr};
+  static constexpr int LINE_BITS = 24;
+  static constexpr int COLUMN_BITS = 18;
+
+  static uint64_t clamp(const size_t value, const int bits) {
+    auto max = (uint64_t{1} << bits) - 1;
+    return (value > max) ? max : value;
+  }
+
+  uint64_t packed_{0};
 };
 
+// Shorthand for a locator, which is passed around by value.
+using locator_ptr = locator_c;
+
+extern void draw_locator(const locator_c &location);
+
 //! \brief A source origin. (File, string, etc.)
 //!        Used to create locators.
 class source_origin_c {
@@ -57,23 +123,47 @@ public:
 
   //! \brief Create a source origin.
   //! \param source_name The name of the source.
-  source_origin_c(std::string source_name)
-      : source_name_(std::make_shared<std::string>(source_name)) {}
+  source_origin_c(std::string source_name);
 
   //! \brief Get the name of the source.
-  std::string get_source_name() { return *source_name_; }
+  std::string get_source_name();
+  //! \brief Get the id of the source, that its locators hold.
+  uint32_t get_id() const { return id_; }
   //! \brief Get a locator interface for the source.
   locator_ptr get_locator(const size_t line, const size_t column) const {
-    return std::make_shared<locator_c>(source_name_, line, column);
+    return locator_c(id_, line, column);
   }
+  //! \brief Get the text of the source, if it has been loaded.
+  std::shared_ptr<source_text_c> get_text() const { return text_; }
+  //! \brief Set the text of the source.
+  void set_text(std::shared_ptr<source_text_c> text);
 
 private:
-  std::shared_ptr<std::string> source_name_{nullptr};
+  uint32_t id_{0};
+  std::shared_ptr<source_text_c> text_{nullptr};
 };
 
 //! \brief A source manager that manages all the sources.
 class source_manager_c {
 public:
+  //! \brief Register a source, giving the id that locators use for it.
+  //!        Sources with the same name share an id, and stay registered
+  //!        for the lifetime of the process.
+  //! \param source_name The name of the source.
+  //! \note Thread safe
+  static uint32_t register_source(const std::string &source_name);
+  //! \brief Get the name of a registered source.
+  //! \note Thread safe
+  static const std::string &get_registered_name(const uint32_t id);
+  //! \brief Get the text last loaded for a registered source.
+  //! \note Thread safe
+  static std::shared_ptr<source_text_c>
+  get_registered_text(const uint32_t id);
+  //! \brief Set the text loaded for a registered source.
+  //! \note Thread safe
+  static void set_registered_text(const uint32_t id,
+                                  std::shared_ptr<source_text_c> text);
+
   //! \brief Get a source by name.
   //! \param source_name The name of the source.
   //! \note If the source does not exist, it will be created.
@@ -86,6 +176,34 @@ public:
     sources_.insert(std::make_pair(source_name, source));
     return source;
   }
+  //! \brief Get a source by the name of the file it is read from,
+  //!        loading the text of the file if it hasn't been already.
+  //! \param source_name The path of the file.
+  //! \return nullptr if the file could not be loaded.
+  std::shared_ptr<source_origin_c>
+  load_source(const std::string source_name) {
+    auto it = sources_.find(source_name);
+    if (it != sources_.end() && it->second->get_text()) {
+      return it->second;
+    }
+    auto text = source_text_c::load(source_name);
+    if (!text) {
+      return nullptr;
+    }
+    auto source = get_source(source_name);
+    source->set_text(text);
+    return source;
+  }
+  //! \brief Get the names of the sources that were loaded from files.
+  std::vector<std::string> get_loaded_sources() const {
+    std::vector<std::string> names;
+    for (auto &[name, source] : sources_) {
+      if (source->get_text()) {
+        names.push_back(name);
+      }
+    }
+    return names;
+  }
   //! \brief Check if a source exists.
   bool exists(const std::string source_name) const {
     return sources_.find(source_name) != sources_.end();
@@ -0,0 +1,69 @@
+#include "libnibi/symbols.hpp"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace nibi {
+
+namespace {
+
+//! \brief The table that every symbol is interned in
+//! \note  Names are held in a deque so that references to them,
+//!        and the views used as keys, are never invalidated
+class symbol_table_c {
+public:
+  symbol_id_t intern(std::string_view name) {
+    {
+      std::shared_lock lock(mutex_);
+      auto it = ids_.find(name);
+      if (it != ids_.end()) {
+        return it->second;
+      }
+    }
+
+    std::unique_lock lock(mutex_);
+
+    // Another thread may have interned it while unlocked
+    auto it = ids_.find(name);
+    if (it != ids_.end()) {
+      return it->second;
+    }
+
+    auto id = static_cast<symbol_id_t>(names_.size());
+    auto &stored = names_.emplace_back(name);
+    ids_.emplace(std::string_view(stored), id);
+    return id;
+  }
+
+  const std::string &name(const symbol_id_t id) {
+    std::shared_lock lock(mutex_);
+    return names_[id];
+  }
+
+private:
+  std::shared_mutex mutex_;
+  std::deque<std::string> names_;
+  std::unordered_map<std::string_view, symbol_id_t> ids_;
+};
+
+// Constructed on first use so that symbols can be
+// interned during static initialization
+symbol_table_c &get_symbol_table() {
+  static symbol_table_c table;
+  return table;
+}
+
+} // namespace
+
+symbol_id_t intern_symbol(std::string_view name) {
+  return get_symbol_table().intern(name);
+}
+
+const std::string &symbol_name(const symbol_id_t id) {
+  return get_symbol_table().name(id);
+}
+
+} // namespace nibi
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace nibi {
+
+//! \brief An interned symbol
+//! \note  Every occurrence of a name maps to the same id for
+//!        the lifetime of the process, so symbols can be compared
+//!        and used as keys without touching their names
+using symbol_id_t = uint32_t;
+
+//! \brief Get the id of a symbol, interning the name if it
+//!        has not been seen before
+//! \param name The name of the symbol
+//! \note  Thread safe
+extern symbol_id_t intern_symbol(std::string_view name);
+
+//! \brief Get the name of an interned symbol
+//! \param id The id of the symbol
+//! \returns The name, which remains valid for the lifetime of the process
+//! \note  Thread safe
+extern const std::string &symbol_name(const symbol_id_t id);
+
+} // namespace nibi
@@ -0,0 +1,108 @@
+#include "libnibi/thread_pool.hpp"
+#include "libnibi/config.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace nibi {
+
+namespace {
+thread_local bool on_worker_thread{false};
+} // namespace
+
+thread_pool_c::thread_pool_c(const std::size_t workers) {
+  threads_.reserve(workers);
+  for (std::size_t i = 0; i < workers; i++) {
+    threads_.emplace_back([this, i]() { work(i); });
+  }
+}
+
+thread_pool_c::~thread_pool_c() {
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    stopping_ = true;
+  }
+  task_started_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void thread_pool_c::start(const std::size_t workers, task_fn_t task) {
+  task_mutex_.lock();
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    task_ = std::move(task);
+    task_workers_ = std::min(workers, threads_.size());
+    running_ = task_workers_;
+    generation_++;
+  }
+  task_started_.notify_all();
+}
+
+void thread_pool_c::wait() {
+  {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    task_finished_.wait(lock, [this]() { return running_ == 0; });
+    task_ = nullptr;
+  }
+  task_mutex_.unlock();
+}
+
+bool thread_pool_c::is_worker_thread() { return on_worker_thread; }
+
+void thread_pool_c::work(const std::size_t index) {
+  on_worker_thread = true;
+  uint64_t seen{0};
+  while (true) {
+    task_fn_t *task{nullptr};
+    {
+      std::unique_lock<std::mutex> lock(state_mutex_);
+      task_started_.wait(lock,
+                         [&]() { return stopping_ || generation_ != seen; });
+      if (stopping_) {
+        return;
+      }
+      seen = generation_;
+      if (index >= task_workers_) {
+        continue;
+      }
+      task = &task_;
+    }
+
+    // Tasks handle their own errors, anything that escapes is dropped
+    // rather than taking the process down from a worker
+    try {
+      (*task)(index);
+    } catch (...) {
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(state_mutex_);
+      running_--;
+    }
+    task_finished_.notify_all();
+  }
+}
+
+namespace {
+// The number of threads can be set through the environment,
+// otherwise there is one for each hardware thread
+std::size_t get_pool_size() {
+  if (const char *threads = std::getenv(config::NIBI_THREADS_ENV)) {
+    try {
+      return std::max(1, std::stoi(threads));
+    } catch (...) {
+    }
+  }
+  return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+} // namespace
+
+thread_pool_c &get_thread_pool() {
+  static thread_pool_c pool(get_pool_size());
+  return pool;
+}
+
+} // namespace nibi
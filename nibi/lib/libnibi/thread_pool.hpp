@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nibi {
+
+//! \brief A fixed set of threads that run a task together
+//! \note  A task is started on a number of workers at once, each being
+//!        given its index, so that they can share out the work of the
+//!        task between themselves. One task runs at a time
+class thread_pool_c {
+public:
+  using task_fn_t = std::function<void(std::size_t)>;
+
+  //! \brief Create the pool
+  //! \param workers The number of threads in the pool
+  thread_pool_c(const std::size_t workers);
+
+  //! \brief Stop and join the threads of the pool
+  ~thread_pool_c();
+
+  thread_pool_c(const thread_pool_c &) = delete;
+  thread_pool_c &operator=(const thread_pool_c &) = delete;
+
+  //! \brief Get the number of threads in the pool
+  std::size_t get_worker_count() const { return threads_.size(); }
+
+  //! \brief Start a task
+  //! \param workers The number of workers to run the task on, at
+  //!        most the number of threads in the pool
+  //! \param task The task, given the index of the worker running it
+  //! \note  The calling thread holds the pool until it calls wait()
+  void start(const std::size_t workers, task_fn_t task);
+
+  //! \brief Wait for every worker to return from the started task
+  void wait();
+
+  //! \brief Check if the calling thread is a worker of any pool
+  static bool is_worker_thread();
+
+private:
+  void work(const std::size_t index);
+
+  std::vector<std::thread> threads_;
+
+  // Held from the start of a task until it has been waited on, so
+  // that interpreters on other threads take their turns with the pool
+  std::mutex task_mutex_;
+
+  std::mutex state_mutex_;
+  std::condition_variable task_started_;
+  std::condition_variable task_finished_;
+  task_fn_t task_;
+  std::size_t task_workers_{0};
+  std::size_t running_{0};
+  uint64_t generation_{0};
+  bool stopping_{false};
+};
+
+//! \brief Get the pool shared by the builtins that run in parallel
+//! \note  Created on first use with a thread for each hardware thread,
+//!        unless the number is given by the NIBI_THREADS variable
+extern thread_pool_c &get_thread_pool();
+
+} // namespace nibi
@@ -17,6 +17,7 @@ class file_interpreter_if;
 class line_interpreter_if;
 class module_viewer_if;
 class error_c;
+class platform_c;
 
 struct module_info_s {
   std::optional<std::vector<std::string>> authors{std::nullopt};
@@ -31,6 +32,21 @@ using line_interpreter_ptr = std::unique_ptr<line_interpreter_if>;
 using module_viewer_ptr = std::unique_ptr<module_viewer_if>;
 using error_callback_f = std::function<void(error_c)>;
 
+//! \brief Options given to an interpreter when it is created
+//! \note  Interpreters that are created from within another, for imports,
+//!        modules, eval and parallel workers, are given the same options
+struct interpreter_options_s {
+  //! \brief The platform used to locate imports and modules, and to
+  //!        retrieve the program arguments. If not set the global
+  //!        platform is used
+  platform_c *platform{nullptr};
+
+  //! \brief If set, runtime errors and `exit` stop the interpreter
+  //!        rather than the process, so that it can be embedded in a
+  //!        program that runs other interpreters alongside it
+  bool contained{false};
+};
+
 // Function router was tested against test_perfs
 // with the following map types:
 // std::map<std::string, function_info_s>
@@ -38,5 +54,8 @@ using error_callback_f = std::function<void(error_c)>;
 // std::unordered_map<std::string, function_info_s>
 //
 // std::unordered_map<std::string, function_info_s> was the fastest
-using function_router_t = std::unordered_map<std::string, function_info_s>;
+//
+// Keywords are keyed by their interned symbol, so the parser only
+// has to hash a name once to both intern it and route it
+using function_router_t = std::unordered_map<symbol_id_t, function_info_s>;
 } // namespace nibi
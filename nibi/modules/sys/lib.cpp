@@ -4,6 +4,7 @@
 #include <iostream>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -12,25 +13,25 @@
 #include <libnibi/macros.hpp>
 
 namespace {
-static bool loaded{false};
+// Standard input belongs to the process, so it is read once
+// and shared by every interpreter that asks for it
+static std::once_flag loaded;
 static std::vector<std::string> std_in;
 void populate_std_in() {
-  if (loaded) {
-    return;
-  }
-  if (!isatty(STDIN_FILENO)) {
-    std_in =
-        std::vector<std::string>(std::istream_iterator<std::string>(std::cin),
-                                 std::istream_iterator<std::string>());
-  }
-  loaded = true;
+  std::call_once(loaded, []() {
+    if (!isatty(STDIN_FILENO)) {
+      std_in = std::vector<std::string>(
+          std::istream_iterator<std::string>(std::cin),
+          std::istream_iterator<std::string>());
+    }
+  });
 }
 } // namespace
 
 nibi::cell_ptr get_argv(nibi::cell_processor_if &ci, nibi::cell_list_t &list,
                         nibi::env_c &env) {
   NIBI_LIST_ENFORCE_SIZE("{sys argv}", ==, 1)
-  auto args = nibi::global_platform->get_program_args();
+  auto args = ci.get_platform()->get_program_args();
   auto argv_cell = nibi::allocate_cell(nibi::cell_type_e::LIST);
   auto &al = argv_cell->as_list();
   for (auto &arg : args) {
@@ -55,6 +56,6 @@ nibi::cell_ptr get_stdin(nibi::cell_processor_if &ci, nibi::cell_list_t &list,
 nibi::cell_ptr get_platform(nibi::cell_processor_if &ci,
                             nibi::cell_list_t &list, nibi::env_c &env) {
   NIBI_LIST_ENFORCE_SIZE("{sys platform}", ==, 1)
-  std::string platform_string = nibi::global_platform->get_platform_string();
+  std::string platform_string = ci.get_platform()->get_platform_string();
   return nibi::allocate_cell(platform_string);
 }
@@ -5,6 +5,7 @@ import os
 import subprocess
 import threading
 import time
+from startup_checks import run_startup_checks
 
 binary = "nibi"
 if len(sys.argv) == 2:
@@ -40,24 +41,53 @@ def display_result(result_item):
 
    print(out)
 
+# Every test is expected to finish in seconds, one that runs
+# for longer than this has failed even if it would go on to pass
+test_time_limit = 60
+
 def test_item(id, expected_result, item):
    results = {}
    start = time.time()
-   result = subprocess.run([binary, item], stdout=subprocess.PIPE)
+   try:
+      result = subprocess.run([binary, item], stdout=subprocess.PIPE,
+                              timeout=test_time_limit)
+      returncode = result.returncode
+      decoded = result.stdout.decode("utf-8")
+   except subprocess.TimeoutExpired as e:
+      returncode = None
+      decoded = (e.stdout or b"").decode("utf-8")
+      decoded += "\nTimed out after " + str(test_time_limit) + "s\n"
    end = time.time()
    parser_status = True
 
-   decoded = result.stdout.decode("utf-8")
-
    results["name"] = item
 
    results["result"] = {
    "time": end - start,
-   "success": result.returncode == int(expected_result),
+   "success": returncode == int(expected_result) and
+              output_is_expected(item, decoded),
    "output": decoded
    }
    return results
 
+# A test may have a `.expect` file next to it, holding lines
+# that must show up in its output in the order they are given.
+# Files are named relative to the directory of the test
+def output_is_expected(item, output):
+   expect_file = os.path.splitext(item)[0] + ".expect"
+   if not os.path.exists(expect_file):
+      return True
+   output = output.replace(os.path.dirname(item) + "/", "")
+   with open(expect_file) as f:
+      expected = [line.rstrip("\n") for line in f if line.strip()]
+   position = 0
+   for line in expected:
+      position = output.find(line, position)
+      if position < 0:
+         return False
+      position += len(line)
+   return True
+
 def retrieve_objects_from(directory):
    os.chdir(directory)
    items_in_dir = glob.glob("*.nibi")
@@ -92,6 +122,8 @@ def linear_run():
 
 run_time_start = time.time()
 linear_run()
+if not run_startup_checks(binary):
+   exit(1)
 run_time_end = time.time()
 
 print("-" * 10)
@@ -0,0 +1,224 @@
+import os
+import shutil
+import struct
+import subprocess
+import tempfile
+
+# Checks of what nibi keeps from one run to the next, the parse cache
+# and snapshots of the standard environment. Each needs more than one
+# run of nibi, so they can't be written as scripted tests. They work on
+# copies of the scripts in `startup` and of NIBI_PATH, so nothing that
+# is installed is changed
+
+startup_directory = os.path.dirname(os.path.abspath(__file__)) + "/startup"
+
+class check_failed(Exception):
+   pass
+
+def expect(condition, message):
+   if not condition:
+      raise check_failed(message)
+
+def run(binary, args, env):
+   result = subprocess.run([binary] + args, stdout=subprocess.PIPE,
+                           stderr=subprocess.STDOUT, env=env)
+   output = result.stdout.decode("utf-8")
+   expect(result.returncode == 0, "nibi failed:\n" + output)
+   return output
+
+def modified(path):
+   return os.stat(path).st_mtime_ns
+
+# Set the modification time of a file apart from what it was
+def touch_later(path):
+   stat = os.stat(path)
+   later = stat.st_mtime_ns + 10 * 1000000000
+   os.utime(path, ns=(stat.st_atime_ns, later))
+
+def replace_text(path, old, new, keep_modified):
+   stat = os.stat(path)
+   with open(path) as f:
+      text = f.read()
+   with open(path, "w") as f:
+      f.write(text.replace(old, new))
+   if keep_modified:
+      os.utime(path, ns=(stat.st_atime_ns, stat.st_mtime_ns))
+   else:
+      touch_later(path)
+
+# FNV-1a, as used for the checksums of entries and snapshots
+def checksum(data):
+   value = 0xcbf29ce484222325
+   for byte in data:
+      value = ((value ^ byte) * 0x100000001b3) & 0xffffffffffffffff
+   return value
+
+# The offset of the checksum of a cache entry or snapshot, which comes
+# after the magic, format version, byte order mark, two strings and
+# then the given number of other bytes
+def checksum_offset(data, after_strings):
+   offset = 16
+   for _ in range(2):
+      offset += 4 + struct.unpack_from("=I", data, offset)[0]
+   return offset + after_strings
+
+# Change the first count of the payload to one far too large for the
+# data, while keeping the checksum correct
+def claim_huge_count(path, after_strings):
+   with open(path, "rb") as f:
+      data = bytearray(f.read())
+   offset = checksum_offset(data, after_strings)
+   struct.pack_into("=I", data, offset + 8, 0xfffffff0)
+   struct.pack_into("=Q", data, offset, checksum(data[offset + 8:]))
+   with open(path, "wb") as f:
+      f.write(data)
+
+# ---- parse cache ----
+
+# An entry holds the modification time, size, and content hash
+# of the file it was made from, after the strings of its header
+CACHE_KEY_SIZE = 24
+
+def cache_entry(cache, script):
+   name = os.path.abspath(script).encode("utf-8")
+   if not os.path.isdir(cache):
+      return None
+   for entry in os.listdir(cache):
+      path = os.path.join(cache, entry)
+      with open(path, "rb") as f:
+         if name in f.read():
+            return path
+   return None
+
+def check_cache(binary, work, env):
+   script = os.path.join(work, "cached.nibi")
+   cache = os.path.join(work, "cache")
+   shutil.copy(os.path.join(startup_directory, "cached.nibi"), script)
+
+   uncached_env = dict(env, NIBI_CACHE_PATH="")
+   env = dict(env, NIBI_CACHE_PATH=cache)
+   expected = run(binary, [script], uncached_env)
+   expect("twice: 42" in expected, "macro expanded")
+
+   # Miss, then hit
+   expect(cache_entry(cache, script) is None, "cache starts empty")
+   expect(run(binary, [script], env) == expected, "output on a miss")
+   entry = cache_entry(cache, script)
+   expect(entry is not None, "entry stored on a miss")
+   stored = modified(entry)
+   expect(run(binary, [script], env) == expected, "output on a hit")
+   expect(modified(entry) == stored, "entry used on a hit")
+
+   # Edited first keeping the size and the modification time, which
+   # leaves only the content hash to tell that the entry is stale, and
+   # then changing both
+   for keep_modified in [True, False]:
+      old, new = ("original", "replaced") if keep_modified else \
+                 ("replaced", "changed")
+      replace_text(script, old, new, keep_modified)
+      stored = modified(entry)
+      output = run(binary, [script], env)
+      expect("marker: " + new in output,
+             "stale entry used, keeping modification time: " +
+             str(keep_modified))
+      expect(modified(entry) != stored, "stale entry replaced")
+      expected = run(binary, [script], uncached_env)
+      expect(output == expected, "output after an edit")
+
+   # Damaged entries are parsed again, and replaced
+   def truncate(data):
+      return data[:len(data) // 2]
+
+   def flip_last_byte(data):
+      return data[:-1] + bytes([data[-1] ^ 0xff])
+
+   for damage in [truncate, flip_last_byte]:
+      with open(entry, "rb") as f:
+         data = f.read()
+      with open(entry, "wb") as f:
+         f.write(damage(data))
+      touch_later(entry)
+      stored = modified(entry)
+      expect(run(binary, [script], env) == expected,
+             "output from a damaged entry: " + damage.__name__)
+      expect(modified(entry) != stored, "damaged entry replaced")
+
+   claim_huge_count(entry, CACHE_KEY_SIZE)
+   touch_later(entry)
+   stored = modified(entry)
+   expect(run(binary, [script], env) == expected,
+          "output from an entry with a huge count")
+   expect(modified(entry) != stored, "entry with a huge count replaced")
+
+# ---- snapshots ----
+
+def check_snapshot(binary, work, env):
+   script = os.path.join(work, "args.nibi")
+   snapshot = os.path.join(work, "std.snapshot")
+   shutil.copy(os.path.join(startup_directory, "args.nibi"), script)
+
+   # The standard library is changed, so a copy of it is used
+   nibi_path = os.path.join(work, "nibi_path")
+   shutil.copytree(env["NIBI_PATH"], nibi_path,
+                   ignore=shutil.ignore_patterns("cache"))
+   env = dict(env, NIBI_PATH=nibi_path, NIBI_CACHE_PATH="")
+   std_file = os.path.join(nibi_path, "std", "match.nibi")
+   with open(std_file, "a") as f:
+      f.write("\n(:= startup_check 1)\n")
+   with open(script, "a") as f:
+      f.write("(io::println \"check: \" startup_check)\n")
+
+   # Options for nibi are not handed to the program
+   args = ["a", "-s", "b"]
+   expected = run(binary, [script] + args, env)
+   expect("[" + script + " a -s b]" in expected, "program arguments")
+   expect("check: 1" in expected, "std symbols")
+
+   # Made, then restored
+   expect(run(binary, ["-s", snapshot, script] + args, env) == expected,
+          "output when a snapshot is made")
+   expect(os.path.isfile(snapshot), "snapshot made")
+   stored = modified(snapshot)
+   expect(run(binary, ["-s", snapshot, script] + args, env) == expected,
+          "output when a snapshot is restored")
+   expect(modified(snapshot) == stored, "snapshot restored")
+
+   # Made again once a file of the standard library changes
+   replace_text(std_file, "(:= startup_check 1)", "(:= startup_check 22)",
+                False)
+   output = run(binary, ["-s", snapshot, script] + args, env)
+   expect("check: 22" in output, "stale snapshot restored")
+   expect(modified(snapshot) != stored, "stale snapshot made again")
+   stored = modified(snapshot)
+   expect(run(binary, ["-s", snapshot, script] + args, env) == output,
+          "output when a new snapshot is restored")
+   expect(modified(snapshot) == stored, "new snapshot restored")
+
+   # Damaged snapshots are made again
+   claim_huge_count(snapshot, 0)
+   touch_later(snapshot)
+   stored = modified(snapshot)
+   expect(run(binary, ["-s", snapshot, script] + args, env) == output,
+          "output from a snapshot with a huge count")
+   expect(modified(snapshot) != stored, "snapshot with a huge count made again")
+
+checks = [
+   ("Parse cache", check_cache),
+   ("Snapshots", check_snapshot),
+]
+
+def run_startup_checks(binary):
+   binary = shutil.which(binary) or binary
+   env = dict(os.environ)
+   if "NIBI_PATH" not in env:
+      print("NIBI_PATH is not set, skipping startup checks")
+      return True
+   for name, check in checks:
+      with tempfile.TemporaryDirectory() as work:
+         try:
+            check(binary, work, env)
+         except check_failed as e:
+            print("Startup check : " + name + " [FAILED]\n\n" + str(e))
+            return False
+      print("Startup check : " + name + " [PASSED]")
+   return True